@@ -1,41 +1,537 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <array>
+#include <thread>
+#include <type_traits>
+#include <algorithm>
+#include <cmath>
+#include <cctype>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
 #include <iostream>
 #include <iomanip>
 #include "do_not_optimize.hpp"
 #include "TimeHelpers.hpp"
+#include "Probability.hpp"
+#include "Parallel.hpp"
+#include "AllocationCounter.hpp"
 #include "external/rang.hpp"
 
+#if defined(__linux__)
+#include <sched.h>
+#include <fstream>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+////////////////////////////////////////////////////////////
+/// \brief How much to repeat each case. Settable from the command line (see parse_benchmark_options).
+///
+/// Every case is run warmup times without measuring, and then at least min_reps times. It's
+/// then repeated until the 95% confidence interval of the median is within target_ci of the
+/// median and min_time has passed, or until max_reps or max_time is reached.
+////////////////////////////////////////////////////////////
+struct BenchmarkOptions
+{
+	int warmup {1};
+	int min_reps {3};
+	int max_reps {30};
+	double min_time {0.5}; // seconds
+	double max_time {10.0}; // seconds
+	double target_ci {0.02}; // relative half-width of the confidence interval
+	int cpu {-1}; // pin to this cpu if >= 0
+	bool list_only {false};
+	std::vector<std::string> filters {}; // run only cases whose name contains one of these
+	std::vector<std::string> excludes {}; // skip cases whose name contains one of these
+	std::string json_file {""}; // also write the results here as json
+	std::string csv_file {""}; // also write the results here as csv
+	std::string tag {""}; // free-form label saved with the results, e.g. a commit hash
+	bool perf {false}; // also measure hardware counters (linux only)
+	int threads {0}; // for the parallel cases, 0 means std::thread::hardware_concurrency()
+	bool sweep {false}; // also run every family at several sizes
+};
+
+inline BenchmarkOptions& benchmark_options()
+{
+	static BenchmarkOptions options;
+	return options;
+}
+
+inline int benchmark_threads()
+{
+	int threads = benchmark_options().threads;
+	if (threads <= 0)
+		threads = std::thread::hardware_concurrency();
+	return std::max(threads, 1);
+}
+
+enum perf_counter
+{
+	perf_cycles,
+	perf_instructions,
+	perf_branch_misses,
+	perf_l1d_misses,
+	num_perf_counters
+};
+
+inline const char* perf_counter_name(int counter)
+{
+	const char* names[] = {"cycles", "instructions", "branch_misses", "l1d_misses"};
+	return names[counter];
+}
+
+using perf_values = std::array<double, num_perf_counters>;
+
+////////////////////////////////////////////////////////////
+/// \brief Hardware counters for the current thread and the threads it starts (user space only), through perf_event_open.
+///
+/// The counters are inherited by new threads, and what those count is added in when they end, so
+/// the parallel cases count the work of every thread (joined before stop()). Inherited counters
+/// can't be read as a group, so each one is its own event, read separately. Works without root as long as /proc/sys/kernel/perf_event_paranoid is 2 or less. Counters
+/// that can't be opened (or aren't supported by the cpu) read as -1. If the kernel has to
+/// multiplex them, values are scaled by time enabled/time running.
+////////////////////////////////////////////////////////////
+class PerfCounters
+{
+public:
+	PerfCounters()
+	{
+#if defined(__linux__)
+		const std::array<std::pair<std::uint32_t, std::uint64_t>, num_perf_counters> events = {{
+			{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+			{PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+			{PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+			{PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)}
+		}};
+
+		for (int i = 0; i < num_perf_counters; ++i)
+		{
+			perf_event_attr attr;
+			std::memset(&attr, 0, sizeof(attr));
+			attr.size = sizeof(attr);
+			attr.type = events[i].first;
+			attr.config = events[i].second;
+			attr.disabled = 1;
+			attr.inherit = 1;
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+			int fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+			m_fd[i] = fd;
+			if (fd == -1)
+			{
+				if (m_error == 0)
+					m_error = errno;
+				continue;
+			}
+			++m_num_open;
+		}
+#endif
+	}
+
+	~PerfCounters()
+	{
+#if defined(__linux__)
+		for (int fd : m_fd)
+		{
+			if (fd != -1)
+				close(fd);
+		}
+#endif
+	}
+
+	PerfCounters(const PerfCounters&) = delete;
+	PerfCounters& operator=(const PerfCounters&) = delete;
+
+	bool available() const
+	{
+		return m_num_open > 0;
+	}
+
+	void start()
+	{
+#if defined(__linux__)
+		for (int fd : m_fd)
+		{
+			if (fd == -1)
+				continue;
+			ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+#endif
+	}
+
+	void stop()
+	{
+#if defined(__linux__)
+		for (int fd : m_fd)
+		{
+			if (fd != -1)
+				ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+		}
+#endif
+	}
+
+	perf_values read_values() const
+	{
+		perf_values result;
+		result.fill(-1.0);
+#if defined(__linux__)
+		for (int i = 0; i < num_perf_counters; ++i)
+		{
+			// value, time_enabled, time_running
+			std::array<std::uint64_t, 3> buffer {};
+			if (m_fd[i] == -1 || ::read(m_fd[i], buffer.data(), sizeof(buffer)) <= 0 || buffer[2] == 0)
+				continue;
+
+			result[i] = double(buffer[0])*double(buffer[1])/double(buffer[2]);
+		}
+#endif
+		return result;
+	}
+
+	// Why the counters couldn't be opened, if they couldn't.
+	std::string error() const
+	{
+		if (m_error == ENOENT || m_error == EOPNOTSUPP)
+			return "no hardware counters on this cpu/vm";
+		if (m_error == EACCES || m_error == EPERM)
+			return "permission denied, perf_event_paranoid = " + paranoid_level() + " (must be 2 or less)";
+		if (m_error != 0)
+			return std::strerror(m_error);
+#if !defined(__linux__)
+		return "only supported on linux";
+#endif
+		return "";
+	}
+
+	static std::string paranoid_level()
+	{
+#if defined(__linux__)
+		std::ifstream file("/proc/sys/kernel/perf_event_paranoid");
+		std::string level;
+		if (file >> level)
+			return level;
+#endif
+		return "unknown";
+	}
+
+private:
+	std::array<int, num_perf_counters> m_fd {{-1, -1, -1, -1}};
+	int m_num_open {0};
+	int m_error {0};
+};
+
+////////////////////////////////////////////////////////////
+/// \brief The counters used by Benchmark(), or nullptr if --perf wasn't given or they're unavailable.
+////////////////////////////////////////////////////////////
+inline PerfCounters* benchmark_perf_counters()
+{
+	if (!benchmark_options().perf)
+		return nullptr;
+
+	static PerfCounters counters;
+	static bool warned = false;
+	if (!counters.available())
+	{
+		if (!warned)
+			std::cerr << "Warning: hardware counters are unavailable (" << counters.error() << ")" << std::endl;
+		warned = true;
+		return nullptr;
+	}
+	return &counters;
+}
+
+////////////////////////////////////////////////////////////
+/// \brief Summary of the repetitions of a case. Times are in seconds.
+////////////////////////////////////////////////////////////
+struct BenchStats
+{
+	double median {0.0};
+	double mad {0.0}; // median absolute deviation, scaled to be comparable to a standard deviation
+	double ci_low {0.0}; // 95% confidence interval of the median
+	double ci_high {0.0};
+	double min {0.0};
+	double mean {0.0};
+	int reps {0};
+	perf_values counters {{-1.0, -1.0, -1.0, -1.0}}; // median over the repetitions, -1 if not measured
+	long long allocations {-1}; // calls to operator new in the last repetition, -1 if not counted
+
+	bool has_counter(int counter) const
+	{
+		return counters[counter] >= 0.0;
+	}
+
+	double ipc() const
+	{
+		if (!has_counter(perf_cycles) || !has_counter(perf_instructions) || counters[perf_cycles] == 0.0)
+			return -1.0;
+		return counters[perf_instructions]/counters[perf_cycles];
+	}
+
+	double relative_mad() const
+	{
+		return median > 0.0 ? mad/median : 0.0;
+	}
+
+	double relative_ci() const
+	{
+		return median > 0.0 ? (ci_high - ci_low)/(2.0*median) : 0.0;
+	}
+};
+
+inline double median_of_sorted(const std::vector<double>& x)
+{
+	auto n = x.size();
+	if (n == 0)
+		return 0.0;
+	if (n%2 == 1)
+		return x[n/2];
+	return (x[n/2 - 1] + x[n/2])/2.0;
+}
+
+////////////////////////////////////////////////////////////
+/// \brief Median, MAD and a distribution-free confidence interval for the median (from order statistics).
+////////////////////////////////////////////////////////////
+inline BenchStats compute_stats(std::vector<double> times)
+{
+	BenchStats S;
+	S.reps = times.size();
+	if (times.empty())
+		return S;
+
+	std::sort(times.begin(), times.end());
+	S.median = median_of_sorted(times);
+	S.min = times.front();
+
+	double sum = 0.0;
+	for (auto t : times)
+		sum += t;
+	S.mean = sum/times.size();
+
+	std::vector<double> deviations;
+	for (auto t : times)
+		deviations.push_back(std::abs(t - S.median));
+	std::sort(deviations.begin(), deviations.end());
+	const double mad_to_sigma = 1.4826;
+	S.mad = mad_to_sigma*median_of_sorted(deviations);
+
+	// The number of samples below the median is binomial(n,1/2), so ranks n/2 -+ 1.96*sqrt(n)/2 bracket it with 95% probability.
+	long n = times.size();
+	double halfwidth = 0.98*std::sqrt(double(n));
+	long lo = std::max(0L, long(std::floor(n/2.0 - halfwidth)));
+	long hi = std::min(n - 1, long(std::ceil(n/2.0 + halfwidth)) - 1);
+	S.ci_low = times[lo];
+	S.ci_high = times[std::max(hi,lo)];
+
+	return S;
+}
+
+////////////////////////////////////////////////////////////
+/// \brief Pins the current thread to the given cpu. Returns false if it couldn't (or if it's not supported).
+////////////////////////////////////////////////////////////
+inline bool pin_to_cpu(int cpu)
+{
+#if defined(__linux__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+	(void)cpu;
+	return false;
+#endif
+}
+
+inline bool benchmark_selected(const std::string& name)
+{
+	auto contains = [&name](const std::string& pattern)
+	{
+		auto it = std::search(name.begin(), name.end(), pattern.begin(), pattern.end(), [](char a, char b)
+		{
+			return std::tolower(a) == std::tolower(b);
+		});
+		return it != name.end();
+	};
+
+	const auto& options = benchmark_options();
+	if (std::any_of(options.excludes.begin(), options.excludes.end(), contains))
+		return false;
+
+	return options.filters.empty() || std::any_of(options.filters.begin(), options.filters.end(), contains);
+}
+
+inline void print_benchmark_usage(std::ostream& os, const char* program)
+{
+	os << "Usage: " << program << " [options] [filter...]\n"
+	   << "  Only cases whose name contains (case insensitive) one of the filters are run.\n"
+	   << "  --filter=S        same as a positional filter\n"
+	   << "  --exclude=S       skip cases whose name contains S\n"
+	   << "  --list            print the names of the selected cases without running them\n"
+	   << "  --warmup=N        unmeasured runs before measuring (default 1)\n"
+	   << "  --min-reps=N      minimum measured runs (default 3)\n"
+	   << "  --max-reps=N      maximum measured runs (default 30)\n"
+	   << "  --min-time=S      keep repeating for at least S seconds (default 0.5)\n"
+	   << "  --max-time=S      stop repeating after S seconds (default 10)\n"
+	   << "  --target-ci=X     stop once the 95% CI of the median is within X of it (default 0.02)\n"
+	   << "  --cpu=N           pin the benchmark to cpu N\n"
+	   << "  --json=FILE       also write the results (and compiler/cpu metadata) to FILE as json\n"
+	   << "  --csv=FILE        also write the results (and compiler/cpu metadata) to FILE as csv\n"
+	   << "  --tag=S           label saved along with the results, e.g. a commit hash\n"
+	   << "  --threads=N       threads for the parallel cases (default: all; don't combine with --cpu)\n"
+	   << "  --sweep           also run every family at several sizes\n"
+	   << "  --perf            also count cycles, instructions, branch and L1 misses (linux, perf_event_paranoid <= 2)\n";
+}
+
+////////////////////////////////////////////////////////////
+/// \brief Fills benchmark_options() from the command line.
+/// \return false if the program should exit (bad option or --help).
+////////////////////////////////////////////////////////////
+inline bool parse_benchmark_options(int argc, char* argv[])
+{
+	auto& options = benchmark_options();
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		auto eq = arg.find('=');
+		std::string key = arg.substr(0, eq);
+		std::string value = (eq == std::string::npos) ? "" : arg.substr(eq + 1);
+
+		if (key == "--help" || key == "-h")
+		{
+			print_benchmark_usage(std::cout, argv[0]);
+			return false;
+		}
+		else if (key == "--list")
+			options.list_only = true;
+		else if (key == "--filter")
+			options.filters.push_back(value);
+		else if (key == "--exclude")
+			options.excludes.push_back(value);
+		else if (key == "--warmup")
+			options.warmup = std::atoi(value.c_str());
+		else if (key == "--min-reps")
+			options.min_reps = std::max(1, std::atoi(value.c_str()));
+		else if (key == "--max-reps")
+			options.max_reps = std::max(1, std::atoi(value.c_str()));
+		else if (key == "--min-time")
+			options.min_time = std::atof(value.c_str());
+		else if (key == "--max-time")
+			options.max_time = std::atof(value.c_str());
+		else if (key == "--target-ci")
+			options.target_ci = std::atof(value.c_str());
+		else if (key == "--cpu")
+			options.cpu = std::atoi(value.c_str());
+		else if (key == "--json")
+			options.json_file = value;
+		else if (key == "--csv")
+			options.csv_file = value;
+		else if (key == "--tag")
+			options.tag = value;
+		else if (key == "--perf")
+			options.perf = true;
+		else if (key == "--threads")
+			options.threads = std::atoi(value.c_str());
+		else if (key == "--sweep")
+			options.sweep = true;
+		else if (arg.size() > 1 && arg[0] == '-')
+		{
+			std::cerr << "Unknown option " << arg << std::endl;
+			print_benchmark_usage(std::cerr, argv[0]);
+			return false;
+		}
+		else
+			options.filters.push_back(arg);
+	}
+
+	options.max_reps = std::max(options.max_reps, options.min_reps);
+
+	if (options.cpu >= 0 && !pin_to_cpu(options.cpu))
+		std::cerr << "Warning: could not pin to cpu " << options.cpu << std::endl;
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////
+/// \brief Runs f repeatedly, as specified by benchmark_options(), and summarizes how long each run took.
+////////////////////////////////////////////////////////////
 template <class Func>
-double Benchmark(Func f, int numtimes = 1)
+BenchStats Benchmark(Func f)
 {
-// 	f(); //warm up
+	const auto& options = benchmark_options();
+
+	for (int i = 0; i < options.warmup; ++i)
+		f();
+
+	auto* perf = benchmark_perf_counters();
+	std::vector<perf_values> samples;
+	long long last_allocations = 0;
+
+	std::vector<double> times;
+	double total = 0.0;
 	dscr::Chronometer C;
-	for (int i = 0; i < numtimes; ++i)
+	while (true)
 	{
+		if (perf)
+			perf->start();
+		dscr::allocation_scope allocations;
+		C.Reset();
 		f();
+		double t = C.Reset();
+		last_allocations = allocations.allocations();
+		if (perf)
+		{
+			perf->stop();
+			samples.push_back(perf->read_values());
+		}
+		times.push_back(t);
+		total += t;
+
+		int reps = times.size();
+		if (reps < options.min_reps)
+			continue;
+		if (reps >= options.max_reps || total >= options.max_time)
+			break;
+		if (total >= options.min_time && compute_stats(times).relative_ci() <= options.target_ci)
+			break;
 	}
-	double avg = C.Reset()/numtimes;
-	
-	return avg;
+
+	auto stats = compute_stats(times);
+	if (dscr::allocation_counting_enabled())
+		stats.allocations = last_allocations;
+	for (int c = 0; c < num_perf_counters && !samples.empty(); ++c)
+	{
+		std::vector<double> values;
+		for (const auto& sample : samples)
+			values.push_back(sample[c]);
+		std::sort(values.begin(), values.end());
+		stats.counters[c] = median_of_sorted(values);
+	}
+	return stats;
 }
 
 template <class Container>
-double FWIterationBenchmark(const Container& A)
+BenchStats FWIterationBenchmark(const Container& A)
 {
 	return Benchmark([&A]()
 	{
-		for (auto& a : A)
+		for (const auto& a : A)
 		{
 			DoNotOptimize(a);
 		}
 	});
-	
+
 }
 
 template <class Container>
-double ReverseIterationBenchmark(const Container& A)
+BenchStats ReverseIterationBenchmark(const Container& A)
 {
 	return Benchmark([&A]()
 	{
@@ -47,7 +543,7 @@ double ReverseIterationBenchmark(const Container& A)
 }
 
 template <class Container>
-double ForEachBenchmark(const Container& A)
+BenchStats ForEachBenchmark(const Container& A)
 {
 	return Benchmark([&A]()
 	{
@@ -59,7 +555,7 @@ double ForEachBenchmark(const Container& A)
 }
 
 template <class Container>
-double ConstructionBenchmark(const Container& A, int numtimes)
+BenchStats ConstructionBenchmark(const Container& A, int numtimes)
 {
 	return Benchmark([&A,numtimes]()
 	{
@@ -71,3 +567,44 @@ double ConstructionBenchmark(const Container& A, int numtimes)
 	});
 }
 
+template <class Container>
+BenchStats RankBenchmark(const Container& A, int numtimes)
+{
+	std::vector<std::decay_t<decltype(A[0])>> sample;
+	sample.reserve(numtimes);
+	for (int i = 0; i < numtimes; ++i)
+		sample.push_back(A[dscr::random::random_int<long>(0,A.size())]);
+	
+	return Benchmark([&A,&sample]()
+	{
+		for (const auto& x : sample)
+		{
+			DoNotOptimize(A.get_index(x));
+		}
+	});
+}
+
+template <class Container>
+BenchStats ParallelBenchmark(const Container& A, int threads)
+{
+	return Benchmark([&A,threads]()
+	{
+		dscr::parallel_for_each(A, [](const auto& a)
+		{
+			DoNotOptimize(a);
+		}, threads);
+	});
+}
+
+// F is what find_all returned: a forward range.
+template <class Range>
+BenchStats FindAllBenchmark(const Range& F)
+{
+	return Benchmark([&F]()
+	{
+		for (const auto& f : F)
+		{
+			DoNotOptimize(f);
+		}
+	});
+}
@@ -0,0 +1,414 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <ctime>
+#include <cstdlib>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <stdexcept>
+#include "benchtable.hpp"
+
+// Machine readable (json and csv) reports of benchmark results, and reading them back for comparison.
+
+#ifndef DISCRETURE_BENCHMARK_FLAGS
+#define DISCRETURE_BENCHMARK_FLAGS "unknown"
+#endif
+
+////////////////////////////////////////////////////////////
+/// \brief Where and how the benchmarks were run.
+////////////////////////////////////////////////////////////
+struct BenchContext
+{
+	std::map<std::string, std::string> values {};
+
+	static BenchContext current()
+	{
+		BenchContext C;
+		C.values["date"] = current_date();
+		C.values["compiler"] = compiler();
+		C.values["flags"] = DISCRETURE_BENCHMARK_FLAGS;
+		C.values["features"] = features();
+		C.values["cpu"] = cpu_model();
+		C.values["num_cpus"] = std::to_string(std::thread::hardware_concurrency());
+		C.values["threads"] = std::to_string(benchmark_threads());
+		C.values["pinned_cpu"] = std::to_string(benchmark_options().cpu);
+		C.values["tag"] = benchmark_options().tag;
+		return C;
+	}
+
+	static std::string compiler()
+	{
+#if defined(__clang__)
+		return std::string("clang ") + __clang_version__;
+#elif defined(__GNUC__)
+		return std::string("gcc ") + __VERSION__;
+#elif defined(_MSC_VER)
+		return "msvc " + std::to_string(_MSC_VER);
+#else
+		return "unknown";
+#endif
+	}
+
+	// What the flags actually turned on, in case DISCRETURE_BENCHMARK_FLAGS isn't there or lies.
+	static std::string features()
+	{
+		std::string result;
+#if defined(__OPTIMIZE__)
+		result += "optimize ";
+#endif
+#if defined(NDEBUG)
+		result += "ndebug ";
+#endif
+#if defined(__SSE4_2__)
+		result += "sse4.2 ";
+#endif
+#if defined(__AVX2__)
+		result += "avx2 ";
+#endif
+#if defined(__AVX512F__)
+		result += "avx512f ";
+#endif
+#if defined(__BMI2__)
+		result += "bmi2 ";
+#endif
+		if (!result.empty())
+			result.pop_back();
+		return result;
+	}
+
+	static std::string cpu_model()
+	{
+		std::ifstream cpuinfo("/proc/cpuinfo");
+		std::string line;
+		while (std::getline(cpuinfo, line))
+		{
+			if (line.compare(0, 10, "model name") == 0)
+			{
+				auto colon = line.find(':');
+				if (colon != std::string::npos)
+					return line.substr(line.find_first_not_of(' ', colon + 1));
+			}
+		}
+		return "unknown";
+	}
+
+	static std::string current_date()
+	{
+		std::time_t now = std::time(nullptr);
+		char buffer[32];
+		std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+		return buffer;
+	}
+};
+
+inline std::string json_escape(const std::string& s)
+{
+	std::string result;
+	for (char c : s)
+	{
+		if (c == '"' || c == '\\')
+			result += '\\';
+		if (c == '\n')
+		{
+			result += "\\n";
+			continue;
+		}
+		if (static_cast<unsigned char>(c) < 0x20)
+		{
+			// Every other control character is invalid inside a json string.
+			static const char hex[] = "0123456789abcdef";
+			result += "\\u00";
+			result += hex[(c >> 4) & 0xf];
+			result += hex[c & 0xf];
+			continue;
+		}
+		result += c;
+	}
+	return result;
+}
+
+// Hardware counters are written as null (json) or left empty (csv) when they weren't measured.
+inline std::string counter_text(double value, const char* missing)
+{
+	if (value < 0.0)
+		return missing;
+	std::ostringstream os;
+	os << std::setprecision(9) << value;
+	return os.str();
+}
+
+inline std::string csv_escape(const std::string& s)
+{
+	std::string result = "\"";
+	for (char c : s)
+	{
+		if (c == '"')
+			result += '"';
+		result += c;
+	}
+	return result + "\"";
+}
+
+////////////////////////////////////////////////////////////
+/// \brief Writes the context and the results as json. Each result is on its own line.
+////////////////////////////////////////////////////////////
+inline void write_json(std::ostream& os, const BenchContext& context, const std::vector<BenchRow>& rows)
+{
+	os << std::setprecision(9);
+	os << "{\n  \"context\": {";
+	bool first = true;
+	for (const auto& kv : context.values)
+	{
+		os << (first ? "\n" : ",\n") << "    \"" << json_escape(kv.first) << "\": \"" << json_escape(kv.second) << "\"";
+		first = false;
+	}
+	os << "\n  },\n  \"benchmarks\": [";
+	first = true;
+	for (const auto& row : rows)
+	{
+		os << (first ? "\n" : ",\n");
+		os << "    {\"name\": \"" << json_escape(row.name) << "\", \"unit\": \"" << json_escape(row.unit) << "\""
+		   << ", \"processed\": " << row.container_size
+		   << ", \"median_s\": " << row.stats.median
+		   << ", \"mad_s\": " << row.stats.mad
+		   << ", \"ci_low_s\": " << row.stats.ci_low
+		   << ", \"ci_high_s\": " << row.stats.ci_high
+		   << ", \"min_s\": " << row.stats.min
+		   << ", \"reps\": " << row.stats.reps
+		   << ", \"rate\": " << row.speed();
+		for (int c = 0; c < num_perf_counters; ++c)
+			os << ", \"" << perf_counter_name(c) << "\": " << counter_text(row.stats.counters[c], "null");
+		os << ", \"ipc\": " << counter_text(row.stats.ipc(), "null")
+		   << ", \"cycles_per_object\": " << counter_text(row.per_object(perf_cycles), "null")
+		   << ", \"allocations_per_object\": " << counter_text(row.allocations_per_object(), "null")
+		   << ", \"speedup\": " << counter_text(row.speedup, "null")
+		   << ", \"efficiency\": " << counter_text(row.efficiency, "null")
+		   << ", \"imbalance\": " << counter_text(row.imbalance, "null") << "}";
+		first = false;
+	}
+	os << "\n  ]\n}\n";
+}
+
+////////////////////////////////////////////////////////////
+/// \brief Writes the results as csv, preceded by the context as "# key: value" lines.
+////////////////////////////////////////////////////////////
+inline void write_csv(std::ostream& os, const BenchContext& context, const std::vector<BenchRow>& rows)
+{
+	os << std::setprecision(9);
+	for (const auto& kv : context.values)
+		os << "# " << kv.first << ": " << kv.second << "\n";
+	os << "name,unit,processed,median_s,mad_s,ci_low_s,ci_high_s,min_s,reps,rate";
+	for (int c = 0; c < num_perf_counters; ++c)
+		os << ',' << perf_counter_name(c);
+	os << ",ipc,cycles_per_object,allocations_per_object,speedup,efficiency,imbalance\n";
+	for (const auto& row : rows)
+	{
+		os << csv_escape(row.name) << ',' << csv_escape(row.unit) << ',' << row.container_size << ','
+		   << row.stats.median << ',' << row.stats.mad << ',' << row.stats.ci_low << ',' << row.stats.ci_high << ','
+		   << row.stats.min << ',' << row.stats.reps << ',' << row.speed();
+		for (int c = 0; c < num_perf_counters; ++c)
+			os << ',' << counter_text(row.stats.counters[c], "");
+		os << ',' << counter_text(row.stats.ipc(), "") << ',' << counter_text(row.per_object(perf_cycles), "")
+		   << ',' << counter_text(row.allocations_per_object(), "") << ',' << counter_text(row.speedup, "")
+		   << ',' << counter_text(row.efficiency, "") << ',' << counter_text(row.imbalance, "") << "\n";
+	}
+}
+
+////////////////////////////////////////////////////////////
+/// \brief Writes benchmark_results() to the files given with --json and --csv, if any.
+/// \return false if some file couldn't be written.
+////////////////////////////////////////////////////////////
+inline bool write_benchmark_reports()
+{
+	const auto& options = benchmark_options();
+	auto context = BenchContext::current();
+	bool ok = true;
+
+	if (!options.json_file.empty())
+	{
+		std::ofstream file(options.json_file);
+		write_json(file, context, benchmark_results());
+		ok = ok && bool(file);
+	}
+
+	if (!options.csv_file.empty())
+	{
+		std::ofstream file(options.csv_file);
+		write_csv(file, context, benchmark_results());
+		ok = ok && bool(file);
+	}
+
+	return ok;
+}
+
+// ************** Reading
+
+namespace detail
+{
+// Finds "key": in line and returns what follows (a string without quotes, or the raw number).
+inline bool json_field(const std::string& line, const std::string& key, std::string& value)
+{
+	auto pos = line.find("\"" + key + "\":");
+	if (pos == std::string::npos)
+		return false;
+	pos = line.find_first_not_of(' ', pos + key.size() + 3);
+	if (pos == std::string::npos)
+		return false;
+
+	value.clear();
+	if (line[pos] == '"')
+	{
+		for (++pos; pos < line.size() && line[pos] != '"'; ++pos)
+		{
+			if (line[pos] == '\\' && pos + 1 < line.size())
+			{
+				++pos;
+				if (line[pos] == 'n')
+				{
+					value += '\n';
+					continue;
+				}
+				if (line[pos] == 'u' && pos + 4 < line.size())
+				{
+					value += static_cast<char>(std::stoi(line.substr(pos + 1, 4), nullptr, 16));
+					pos += 4;
+					continue;
+				}
+			}
+			value += line[pos];
+		}
+		return true;
+	}
+
+	auto end = line.find_first_of(",}", pos);
+	value = line.substr(pos, end - pos);
+	return true;
+}
+
+inline std::vector<std::string> split_csv_line(const std::string& line)
+{
+	std::vector<std::string> fields(1);
+	bool quoted = false;
+	for (size_t i = 0; i < line.size(); ++i)
+	{
+		char c = line[i];
+		if (quoted)
+		{
+			if (c == '"' && i + 1 < line.size() && line[i+1] == '"')
+			{
+				fields.back() += '"';
+				++i;
+			}
+			else if (c == '"')
+				quoted = false;
+			else
+				fields.back() += c;
+		}
+		else if (c == '"')
+			quoted = true;
+		else if (c == ',')
+			fields.emplace_back();
+		else
+			fields.back() += c;
+	}
+	return fields;
+}
+
+inline BenchRow make_row(std::map<std::string, std::string>& f)
+{
+	BenchStats S;
+	S.median = std::atof(f["median_s"].c_str());
+	S.mad = std::atof(f["mad_s"].c_str());
+	S.ci_low = std::atof(f["ci_low_s"].c_str());
+	S.ci_high = std::atof(f["ci_high_s"].c_str());
+	S.min = std::atof(f["min_s"].c_str());
+	S.reps = std::atoi(f["reps"].c_str());
+	for (int c = 0; c < num_perf_counters; ++c)
+	{
+		const auto& value = f[perf_counter_name(c)];
+		if (!value.empty() && value != "null")
+			S.counters[c] = std::atof(value.c_str());
+	}
+	auto processed = std::strtoull(f["processed"].c_str(), nullptr, 10);
+	const auto& allocations = f["allocations_per_object"];
+	if (!allocations.empty() && allocations != "null")
+		S.allocations = std::llround(std::atof(allocations.c_str())*processed);
+	BenchRow row(f["name"], S, processed, f["unit"]);
+	for (auto field : {std::make_pair("speedup", &row.speedup), std::make_pair("efficiency", &row.efficiency), std::make_pair("imbalance", &row.imbalance)})
+	{
+		const auto& value = f[field.first];
+		if (!value.empty() && value != "null")
+			*field.second = std::atof(value.c_str());
+	}
+	return row;
+}
+} // namespace detail
+
+////////////////////////////////////////////////////////////
+/// \brief Reads back a file written with write_json or write_csv (detected from the first character).
+////////////////////////////////////////////////////////////
+inline std::vector<BenchRow> read_benchmark_results(std::istream& is)
+{
+	std::vector<std::string> keys = {"name", "unit", "processed", "median_s", "mad_s", "ci_low_s", "ci_high_s", "min_s", "reps", "rate"};
+	for (int c = 0; c < num_perf_counters; ++c)
+		keys.push_back(perf_counter_name(c));
+	for (auto key : {"allocations_per_object", "speedup", "efficiency", "imbalance"})
+		keys.push_back(key);
+	std::vector<BenchRow> rows;
+	std::string line;
+	std::vector<std::string> header;
+	bool json = false;
+	bool first = true;
+
+	while (std::getline(is, line))
+	{
+		if (first)
+		{
+			auto pos = line.find_first_not_of(" \t");
+			json = (pos != std::string::npos && line[pos] == '{');
+			first = false;
+		}
+
+		if (json)
+		{
+			std::map<std::string, std::string> f;
+			if (!detail::json_field(line, "name", f["name"]) || !detail::json_field(line, "median_s", f["median_s"]))
+				continue;
+			for (const auto& key : keys)
+				detail::json_field(line, key, f[key]);
+			rows.push_back(detail::make_row(f));
+			continue;
+		}
+
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		auto fields = detail::split_csv_line(line);
+		if (header.empty())
+		{
+			header = fields;
+			continue;
+		}
+
+		std::map<std::string, std::string> f;
+		for (size_t i = 0; i < header.size() && i < fields.size(); ++i)
+			f[header[i]] = fields[i];
+		rows.push_back(detail::make_row(f));
+	}
+
+	return rows;
+}
+
+inline std::vector<BenchRow> read_benchmark_results(const std::string& filename)
+{
+	std::ifstream file(filename);
+	if (!file)
+		throw std::runtime_error("Could not open " + filename);
+	return read_benchmark_results(file);
+}
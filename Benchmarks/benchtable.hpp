@@ -12,40 +12,65 @@
 #include "benchmarker.hpp"
 
 const int columntime = 35;
-const int columnsize = 50;
-const int columnspeed = 70;
+const int columnspread = 47;
+const int columnsize = 62;
+const int columnspeed = 82;
 
 struct BenchRow
 {
 	BenchRow() {} // empty initializer
-	BenchRow(const std::string& Name, double t, size_t cs) : name(Name), avg_time(t), container_size(cs)  {}
+	BenchRow(const std::string& Name, double t, size_t cs) : name(Name), avg_time(t), container_size(cs)  
+	{
+		stats.median = t;
+		stats.reps = 1;
+	}
+	
+	BenchRow(const std::string& Name, const BenchStats& S, size_t cs, const std::string& Unit = "#") : name(Name), avg_time(S.median), container_size(cs), stats(S), unit(Unit) {}
+	
+	//////////////////////////////////////////////
+	/// \brief A row for a case that was filtered out from the command line. Prints nothing.
+	//////////////////////////////////////////////
+	static BenchRow Skipped(const std::string& Name)
+	{
+		BenchRow row;
+		row.name = Name;
+		row.skipped = true;
+		return row;
+	}
 	
 	static void print_header(std::ostream& os)
 	{
-		const std::string head1 = "Benchmark name";
-		const std::string head2 = "Time";
-		const std::string head3 = "# processed";
-		const std::string head4 = "Speed";
-		
-		os << head1;
-		
-		for (int i = head1.size(); i < columntime+2; ++i) os << ' ';
-		os << head2;
-		
-		for (int i = columntime+head2.size()+2; i < columnsize; ++i) os << ' ';
-		os << head3;
-		
-		for (int i = columnsize+head3.size(); i <= columnspeed+6; ++i) os << ' ';
-		os << head4;
+		if (benchmark_options().list_only)
+			return;
 		
-		os << std::endl;
+		os << std::left << std::setw(columntime) << "Benchmark name";
+		os << std::right << std::setw(9) << "Time";
+		os << std::setw(columnspread - columntime - 9) << "";
+		os << std::left << std::setw(columnsize - columnspread) << "  MAD (reps)";
+		os << std::right << std::setw(12) << "# processed";
+		os << std::setw(columnspeed - columnsize - 11) << "";
+		os << "Speed" << std::endl;
+		rows_since_line() = 1;
 	}
 	
+	//////////////////////////////////////////////
+	/// \brief Prints a separator, unless nothing was printed since the last one (e.g. because of filters).
+	//////////////////////////////////////////////
 	static void print_line(std::ostream& os)
 	{
-		for (int i = 0; i < columnspeed + 17; ++i)
+		if (benchmark_options().list_only || rows_since_line() == 0)
+			return;
+		
+		for (int i = 0; i < columnspeed + 24; ++i)
 			os << '-';
 		os << std::endl;
+		rows_since_line() = 0;
+	}
+	
+	static int& rows_since_line()
+	{
+		static int rows = 0;
+		return rows;
 	}
 	
 	double speed() const
@@ -53,14 +78,79 @@ struct BenchRow
 		return static_cast<double>(container_size)/avg_time;
 	}
 	
+	double ipc() const
+	{
+		return stats.ipc();
+	}
+	
+	// -1 if allocations weren't counted (see AllocationCounter.hpp)
+	double allocations_per_object() const
+	{
+		if (stats.allocations < 0 || container_size == 0)
+			return -1.0;
+		return double(stats.allocations)/container_size;
+	}
+	
+	// e.g. cycles per object; -1 if the counter wasn't measured
+	double per_object(int counter) const
+	{
+		if (!stats.has_counter(counter) || container_size == 0)
+			return -1.0;
+		return stats.counters[counter]/container_size;
+	}
+	
 	std::string name {""};
-	double avg_time {0.0};
+	double avg_time {0.0}; // the median of the repetitions
 	size_t container_size {0};
-	bool variable_time_units {false};
+	bool variable_time_units {true};
+	BenchStats stats {};
+	std::string unit {"#"}; // what is being counted, e.g. "objects" or "unranks"
+	bool skipped {false};
+	
+	// Only for parallel scaling rows (-1 otherwise): time with one thread over this time, that over
+	// the number of threads, and the slowest thread over the average thread (median over the repetitions).
+	double speedup {-1.0};
+	double efficiency {-1.0};
+	double imbalance {-1.0};
 };
 
+//////////////////////////////////////////////
+/// \brief Every row that was actually run, in order. Used for the json/csv reports.
+//////////////////////////////////////////////
+inline std::vector<BenchRow>& benchmark_results()
+{
+	static std::vector<BenchRow> results;
+	return results;
+}
+
+inline BenchRow record(BenchRow row)
+{
+	benchmark_results().push_back(row);
+	return row;
+}
+
+inline std::string si_prefix(double& x)
+{
+	const char* prefixes[] = {"", "k", "M", "G", "T"};
+	int i = 0;
+	while (x >= 1000.0 && i < 4)
+	{
+		x /= 1000.0;
+		++i;
+	}
+	return prefixes[i];
+}
+
 std::ostream& operator<<(std::ostream& os, const BenchRow& T)
 {
+	if (T.skipped)
+	{
+		if (benchmark_options().list_only && benchmark_selected(T.name))
+			os << T.name << std::endl;
+		return os;
+	}
+	
+	++BenchRow::rows_since_line();
 // 	os << '|';
 	os << T.name;
 	for (int i = T.name.size(); i < columntime; ++i) 
@@ -72,14 +162,14 @@ std::ostream& operator<<(std::ostream& os, const BenchRow& T)
 	
 	if (T.variable_time_units)
 	{
-		if (avg_time < 0.01)
+		if (avg_time < 0.1)
 		{
 			avg_time *= 1000;
 			units = "ms";
 			color = rang::fg::yellow;
 		}
 		
-		if (avg_time < 0.01)
+		if (avg_time < 0.1)
 		{
 			avg_time *= 1000;
 			units = "μs";
@@ -88,15 +178,24 @@ std::ostream& operator<<(std::ostream& os, const BenchRow& T)
 	}
 	
 	const int precision = 3;
-	const int timewidth = 6;
+	const int timewidth = 8;
 	os << std::setprecision(precision) << std::fixed << color;
-	os << std::setw(timewidth) << T.avg_time << units << rang::fg::reset;
+	os << std::setw(timewidth) << avg_time << units << rang::fg::reset;
 	
-	for (int i = columntime+units.size()+timewidth; i <= columnsize; ++i) 
+	for (int i = columntime+2+timewidth; i < columnspread; ++i) 
 		os << ' ';
-// 	os << '|';
 	
-	const int sizewidth = 10;
+	auto spread_color = rang::fg::green;
+	if (T.stats.relative_mad() > 0.02)
+		spread_color = rang::fg::yellow;
+	if (T.stats.relative_mad() > 0.1)
+		spread_color = rang::fg::red;
+	os << spread_color << std::setprecision(1) << std::setw(5) << 100.0*T.stats.relative_mad() << "%" << rang::fg::reset;
+	os << " (n=" << std::setw(2) << T.stats.reps << ")";
+	
+	const int sizewidth = 12;
+	for (int i = columnspread + 14; i < columnsize; ++i) 
+		os << ' ';
 	os << rang::fg::blue << std::setw(sizewidth) << T.container_size << rang::fg::reset;
 	
 	for (int i = columnsize + sizewidth; i <= columnspeed; ++i) 
@@ -111,53 +210,132 @@ std::ostream& operator<<(std::ostream& os, const BenchRow& T)
 	if (T.speed() < 1e7)
 		speed_color = rang::fg::red;
 	
+	double speed = T.speed();
+	std::string prefix = si_prefix(speed);
 	
-	os << std::setprecision(3) << std::scientific << speed_color;
+	os << std::setprecision(2) << std::fixed << speed_color;
 	
 	if (T.speed() > 1e9)
 		os << rang::fgB::green << rang::style::bold;
 	
-	os << T.speed() << " #/sec" << rang::fg::reset << rang::style::reset << std::endl;
+	os << std::setw(7) << speed << " " << prefix << (prefix.empty() ? "" : " ") << T.unit << "/s" << rang::fg::reset << rang::style::reset;
+	
+	if (T.ipc() >= 0.0)
+	{
+		os << std::setprecision(2) << "   IPC " << T.ipc()
+		   << std::setprecision(1) << "  " << T.per_object(perf_cycles) << " cyc/obj";
+		if (T.per_object(perf_branch_misses) >= 0.0)
+			os << std::setprecision(3) << "  " << T.per_object(perf_branch_misses) << " br-miss/obj";
+		if (T.per_object(perf_l1d_misses) >= 0.0)
+			os << std::setprecision(3) << "  " << T.per_object(perf_l1d_misses) << " L1-miss/obj";
+	}
+	
+	if (T.speedup >= 0.0)
+	{
+		auto efficiency_color = rang::fg::green;
+		if (T.efficiency < 0.8)
+			efficiency_color = rang::fg::yellow;
+		if (T.efficiency < 0.5)
+			efficiency_color = rang::fg::red;
+		os << std::setprecision(2) << "   speedup " << std::setw(5) << T.speedup
+		   << efficiency_color << "  efficiency " << std::setprecision(0) << std::setw(3) << 100.0*T.efficiency << "%" << rang::fg::reset
+		   << std::setprecision(2) << "  imbalance " << T.imbalance;
+	}
+	
+	if (T.allocations_per_object() >= 0.0)
+	{
+		auto alloc_color = (T.stats.allocations == 0) ? rang::fg::green : rang::fg::red;
+		os << alloc_color << std::setprecision(3) << "   " << T.allocations_per_object() << " allocs/obj" << rang::fg::reset;
+	}
+	os << std::endl;
 	
 	return os;
 }
 
-template <class Container>
-BenchRow ProduceRowForward(std::string name, const Container& A)
+//////////////////////////////////////////////
+/// \brief Runs f (as specified by benchmark_options()) unless name is filtered out from the command line.
+/// \param size is the number of objects processed by each call of f
+//////////////////////////////////////////////
+template <class Func>
+BenchRow ProduceRow(const std::string& name, Func f, size_t size, const std::string& unit = "objects")
 {
-	double t = FWIterationBenchmark(A);
+	if (!benchmark_selected(name) || benchmark_options().list_only)
+		return BenchRow::Skipped(name);
+	
+	return record(BenchRow(name, Benchmark(f), size, unit));
+}
 
+template <class Container>
+BenchRow ProduceRowForward(std::string name, const Container& A, const std::string& unit = "objects")
+{
 	name += " Forward";
+	if (!benchmark_selected(name) || benchmark_options().list_only)
+		return BenchRow::Skipped(name);
 	
-	return BenchRow(name, t, A.size());
+	return record(BenchRow(name, FWIterationBenchmark(A), A.size(), unit));
 }
 
 template <class Container>
-BenchRow ProduceRowReverse(std::string name, const Container& A)
+BenchRow ProduceRowReverse(std::string name, const Container& A, const std::string& unit = "objects")
 {
-	double t = ReverseIterationBenchmark(A);
-
 	name += " Reverse";
+	if (!benchmark_selected(name) || benchmark_options().list_only)
+		return BenchRow::Skipped(name);
 	
-	return BenchRow(name, t, A.size());
+	return record(BenchRow(name, ReverseIterationBenchmark(A), A.size(), unit));
 }
 
 template <class Container>
-BenchRow ProduceRowForEach(std::string name, const Container& A)
+BenchRow ProduceRowForEach(std::string name, const Container& A, const std::string& unit = "objects")
 {
-	double t = ForEachBenchmark(A);
-
 	name += " for_each";
+	if (!benchmark_selected(name) || benchmark_options().list_only)
+		return BenchRow::Skipped(name);
 	
-	return BenchRow(name, t, A.size());
+	return record(BenchRow(name, ForEachBenchmark(A), A.size(), unit));
 }
 
 template <class Container>
 BenchRow ProduceRowConstruct(std::string name, const Container& A, int numtimes = 100000)
 {
-	double t = ConstructionBenchmark(A,numtimes);
-
 	name += " Construct";
+	if (!benchmark_selected(name) || benchmark_options().list_only)
+		return BenchRow::Skipped(name);
+	
+	return record(BenchRow(name, ConstructionBenchmark(A,numtimes), numtimes, "unranks"));
+}
+
+template <class Container>
+BenchRow ProduceRowRank(std::string name, const Container& A, int numtimes = 100000)
+{
+	name += " Rank";
+	if (!benchmark_selected(name) || benchmark_options().list_only)
+		return BenchRow::Skipped(name);
+	
+	return record(BenchRow(name, RankBenchmark(A,numtimes), numtimes, "ranks"));
+}
+
+template <class Container>
+BenchRow ProduceRowParallel(std::string name, const Container& A, const std::string& unit = "objects")
+{
+	name += " Parallel";
+	if (!benchmark_selected(name) || benchmark_options().list_only)
+		return BenchRow::Skipped(name);
+	
+	return record(BenchRow(name, ParallelBenchmark(A,benchmark_threads()), A.size(), unit));
+}
+
+//////////////////////////////////////////////
+/// \brief Iterates over everything A.find_all(pred) finds. The size column is how many were found.
+//////////////////////////////////////////////
+template <class Container, class PartialPredicate>
+BenchRow ProduceRowFindAll(std::string name, Container A, PartialPredicate pred)
+{
+	name += " find_all";
+	if (!benchmark_selected(name) || benchmark_options().list_only)
+		return BenchRow::Skipped(name);
 	
-	return BenchRow(name, t, numtimes);
+	auto F = A.find_all(pred);
+	size_t found = std::distance(F.begin(), F.end());
+	return record(BenchRow(name, FindAllBenchmark(F), found, "objects"));
 }
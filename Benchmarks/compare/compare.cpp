@@ -0,0 +1,113 @@
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <string>
+#include <cstdlib>
+#include "../benchmarker.hpp"
+#include "../benchreport.hpp"
+
+// Compares two result files written by discreture_benchmark --json/--csv.
+// Exits with 1 if some case got slower than the threshold, 2 on usage errors.
+
+void print_usage(const char* program)
+{
+	std::cerr << "Usage: " << program << " BASELINE CURRENT [--threshold=X] [filter...]\n"
+			  << "  BASELINE and CURRENT are files written by discreture_benchmark --json=... or --csv=...\n"
+			  << "  --threshold=X   relative slowdown of the rate that counts as a regression (default 0.05)\n"
+			  << "  Only cases whose name contains one of the filters are compared." << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+	double threshold = 0.05;
+	std::vector<std::string> files;
+	auto& options = benchmark_options();
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg.compare(0, 12, "--threshold=") == 0)
+			threshold = std::atof(arg.c_str() + 12);
+		else if (arg == "--help" || arg == "-h")
+		{
+			print_usage(argv[0]);
+			return 0;
+		}
+		else if (arg.size() > 1 && arg[0] == '-')
+		{
+			print_usage(argv[0]);
+			return 2;
+		}
+		else if (files.size() < 2)
+			files.push_back(arg);
+		else
+			options.filters.push_back(arg);
+	}
+
+	if (files.size() != 2)
+	{
+		print_usage(argv[0]);
+		return 2;
+	}
+
+	std::vector<BenchRow> baseline, current;
+	try
+	{
+		baseline = read_benchmark_results(files[0]);
+		current = read_benchmark_results(files[1]);
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return 2;
+	}
+
+	std::map<std::string, BenchRow> base;
+	for (const auto& row : baseline)
+		base[row.name] = row;
+
+	int regressions = 0;
+	int compared = 0;
+	std::cout << std::left << std::setw(40) << "Benchmark name" << std::right << std::setw(14) << "baseline" << std::setw(14) << "current" << std::setw(10) << "change" << std::endl;
+	for (const auto& row : current)
+	{
+		if (!benchmark_selected(row.name))
+			continue;
+
+		auto it = base.find(row.name);
+		if (it == base.end())
+		{
+			std::cout << std::left << std::setw(40) << row.name << "  (new)" << std::endl;
+			continue;
+		}
+
+		const auto& old = it->second;
+		double change = row.speed()/old.speed() - 1.0;
+		// The intervals are on times. The rate bounds are their reciprocals (1/ci_high to 1/ci_low),
+		// and those overlap exactly when the time intervals do.
+		bool overlap = row.stats.ci_low <= old.stats.ci_high && old.stats.ci_low <= row.stats.ci_high;
+		bool regression = change < -threshold;
+
+		std::cout << std::left << std::setw(40) << row.name << std::right << std::scientific << std::setprecision(3)
+				  << std::setw(14) << old.speed() << std::setw(14) << row.speed()
+				  << std::fixed << std::setprecision(1) << std::setw(9) << 100.0*change << "%";
+		if (regression)
+			std::cout << "  REGRESSION";
+		if (overlap && change != 0.0)
+			std::cout << "  (within noise)";
+		std::cout << std::endl;
+
+		regressions += regression;
+		++compared;
+		base.erase(it);
+	}
+
+	for (const auto& kv : base)
+	{
+		if (benchmark_selected(kv.first))
+			std::cout << std::left << std::setw(40) << kv.first << "  (missing)" << std::endl;
+	}
+
+	std::cout << "\n" << compared << " compared, " << regressions << " slower than " << 100.0*threshold << "%" << std::endl;
+	return regressions > 0 ? 1 : 0;
+}
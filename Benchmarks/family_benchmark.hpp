@@ -0,0 +1,124 @@
+#pragma once
+
+#include <iterator>
+#include <type_traits>
+#include "benchtable.hpp"
+
+// Runs every access mode a family supports (for_each, forward, reverse, unrank, rank, parallel),
+// for a std::vector family and its static_vector ("Stack") counterpart. Modes a family doesn't
+// have are just left out.
+
+namespace detail
+{
+template <class...>
+using void_t = void;
+
+struct no_op
+{
+	template <class T>
+	void operator()(const T&) const {}
+};
+
+template <class T, class = void>
+struct has_for_each : std::false_type {};
+template <class T>
+struct has_for_each<T, void_t<decltype(std::declval<const T&>().for_each(no_op()))>> : std::true_type {};
+
+template <class T, class = void>
+struct has_reverse : std::false_type {};
+template <class T>
+struct has_reverse<T, void_t<decltype(std::declval<const T&>().rbegin())>> : std::true_type {};
+
+template <class T, class = void>
+struct has_unrank : std::false_type {};
+template <class T>
+struct has_unrank<T, void_t<decltype(std::declval<const T&>()[0])>> : std::true_type {};
+
+template <class T, class = void>
+struct has_rank : std::false_type {};
+template <class T>
+struct has_rank<T, void_t<decltype(std::declval<const T&>().get_index(std::declval<const T&>()[0]))>> : std::true_type {};
+
+// parallel_for_each splits the range with std::advance, so only random access families are worth it.
+template <class T>
+using has_random_access = std::is_convertible<typename std::iterator_traits<typename T::iterator>::iterator_category, std::random_access_iterator_tag>;
+
+template <class Family>
+void family_for_each(std::ostream& os, const std::string& name, const Family& A, std::true_type)
+{
+	os << ProduceRowForEach(name, A);
+}
+
+template <class Family>
+void family_reverse(std::ostream& os, const std::string& name, const Family& A, std::true_type)
+{
+	os << ProduceRowReverse(name, A);
+}
+
+template <class Family>
+void family_unrank(std::ostream& os, const std::string& name, const Family& A, int numtimes, std::true_type)
+{
+	os << ProduceRowConstruct(name, A, numtimes);
+}
+
+template <class Family>
+void family_rank(std::ostream& os, const std::string& name, const Family& A, int numtimes, std::true_type)
+{
+	os << ProduceRowRank(name, A, numtimes);
+}
+
+template <class Family>
+void family_parallel(std::ostream& os, const std::string& name, const Family& A, std::true_type)
+{
+	os << ProduceRowParallel(name, A);
+}
+
+template <class Family>
+void family_for_each(std::ostream&, const std::string&, const Family&, std::false_type) {}
+template <class Family>
+void family_reverse(std::ostream&, const std::string&, const Family&, std::false_type) {}
+template <class Family>
+void family_unrank(std::ostream&, const std::string&, const Family&, int, std::false_type) {}
+template <class Family>
+void family_rank(std::ostream&, const std::string&, const Family&, int, std::false_type) {}
+template <class Family>
+void family_parallel(std::ostream&, const std::string&, const Family&, std::false_type) {}
+} // namespace detail
+
+//////////////////////////////////////////////
+/// \brief Benchmarks every mode A and AF (the same family with a static_vector) support. Rows
+/// for AF are named name + " Stack".
+/// \param numtimes is how many objects are unranked/ranked in the Construct and Rank rows.
+//////////////////////////////////////////////
+template <class Family, class FamilyStack>
+void BenchmarkFamily(std::ostream& os, const std::string& name, const Family& A, const FamilyStack& AF, int numtimes)
+{
+	const std::string stack = name + " Stack";
+
+	detail::family_for_each(os, name, A, detail::has_for_each<Family>());
+	detail::family_for_each(os, stack, AF, detail::has_for_each<FamilyStack>());
+	os << ProduceRowForward(name, A);
+	os << ProduceRowForward(stack, AF);
+	detail::family_reverse(os, name, A, detail::has_reverse<Family>());
+	detail::family_reverse(os, stack, AF, detail::has_reverse<FamilyStack>());
+	detail::family_unrank(os, name, A, numtimes, detail::has_unrank<Family>());
+	detail::family_unrank(os, stack, AF, numtimes, detail::has_unrank<FamilyStack>());
+	detail::family_rank(os, name, A, numtimes, detail::has_rank<Family>());
+	detail::family_rank(os, stack, AF, numtimes, detail::has_rank<FamilyStack>());
+	detail::family_parallel(os, name, A, detail::has_random_access<Family>());
+	detail::family_parallel(os, stack, AF, detail::has_random_access<FamilyStack>());
+}
+
+//////////////////////////////////////////////
+/// \brief Same as above, for families that don't have a static_vector version.
+//////////////////////////////////////////////
+template <class Family>
+void BenchmarkFamily(std::ostream& os, const std::string& name, const Family& A, int numtimes)
+{
+	detail::family_for_each(os, name, A, detail::has_for_each<Family>());
+	os << ProduceRowForward(name, A);
+	detail::family_reverse(os, name, A, detail::has_reverse<Family>());
+	detail::family_unrank(os, name, A, numtimes, detail::has_unrank<Family>());
+	detail::family_rank(os, name, A, numtimes, detail::has_rank<Family>());
+	detail::family_parallel(os, name, A, detail::has_random_access<Family>());
+}
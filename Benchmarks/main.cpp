@@ -1,17 +1,308 @@
+#ifdef DISCRETURE_BENCHMARK_ALLOCATIONS
+#define DISCRETURE_COUNT_ALLOCATIONS // installs the counting operator new, see AllocationCounter.hpp
+#endif
+#include "AllocationCounter.hpp"
+#include <unordered_map>
+#include <numeric>
 #include "combinations_benchmark.hpp"
 #include "benchmarker.hpp"
 #include "benchtable.hpp"
+#include "benchreport.hpp"
 #include "combinations_tree_benchmark.hpp"
 #include "discreture.hpp"
+#include "family_benchmark.hpp"
 #include "multiset_benchmark.hpp"
+#include "parallel_benchmark.hpp"
 #include "permutations_benchmark.hpp"
 
 
 
-int main()
+// Subsets of [0,40) with no two elements at distance 1 or 3 and sum at most 400, kept up to date
+// as the search goes (see PartialPredicate.hpp). Compare with the spaced lambda in main.
+struct spaced_incremental
+{
+	int sum {0};
+	int conflicts {0};
+	std::uint64_t used {0};
+	
+	bool conflicting(int x) const
+	{
+		std::uint64_t near = (x >= 1 ? 1ULL << (x - 1) : 0) | (x >= 3 ? 1ULL << (x - 3) : 0);
+		return (used & near) != 0;
+	}
+	
+	void on_push(int x)
+	{
+		sum += x;
+		conflicts += conflicting(x);
+		used |= 1ULL << x;
+	}
+	
+	void on_pop(int x)
+	{
+		used &= ~(1ULL << x);
+		conflicts -= conflicting(x);
+		sum -= x;
+	}
+	
+	bool accept() const
+	{
+		return conflicts == 0 && sum <= 400;
+	}
+};
+
+// The 10 best 8-subsets of 30 weighted items with a penalty for consecutive items, by branch and
+// bound (sequential and parallel) and by scoring every combination.
+void optimize_rows(std::ostream& os)
+{
+	const int n = 30;
+	const int k = 8;
+	const size_t m = 10;
+	std::vector<double> w(n);
+	std::uint64_t seed = 12345;
+	for (auto& x : w)
+	{
+		seed = seed*6364136223846793005ULL + 1442695040888963407ULL;
+		x = (seed >> 40)%1000;
+	}
+	
+	std::vector<double> max_after(n + 1, 0.0);
+	for (int i = n - 1; i >= 0; --i)
+		max_after[i] = std::max(max_after[i + 1], w[i]);
+	
+	auto score = [&w](const dscr::combinations_tree::combination& comb)
+	{
+		double s = 0;
+		for (size_t i = 0; i < comb.size(); ++i)
+		{
+			s += w[comb[i]];
+			if (i > 0 && comb[i] == comb[i - 1] + 1)
+				s -= 300;
+		}
+		return s;
+	};
+	
+	auto bound = [&](const dscr::combinations_tree::combination& comb)
+	{
+		return score(comb) + (k - comb.size())*max_after[comb.back() + 1];
+	};
+	
+	dscr::combinations_tree X(n,k);
+	os << ProduceRow("Combinations Tree optimize top 10", [&]()
+	{
+		DoNotOptimize(X.optimize(score, bound, m).scores[0]);
+	}, X.size());
+	os << ProduceRow("Combinations Tree optimize top 10 Parallel", [&]()
+	{
+		DoNotOptimize(X.optimize(score, bound, m, benchmark_threads()).scores[0]);
+	}, X.size());
+	os << ProduceRow("Combinations Tree score all, top 10", [&]()
+	{
+		std::vector<double> best;
+		best.reserve(m + 1);
+		X.for_each([&](const auto& comb)
+		{
+			best.push_back(score(comb));
+			std::push_heap(best.begin(), best.end(), std::greater<double>());
+			if (best.size() > m)
+			{
+				std::pop_heap(best.begin(), best.end(), std::greater<double>());
+				best.pop_back();
+			}
+		});
+		DoNotOptimize(best[0]);
+	}, X.size());
+}
+
+// A memo table keyed by 6-subsets of [0,24): every combination is looked up once, by hashing it,
+// by computing its rank, and by taking the rank from the iterator.
+void rank_map_rows(std::ostream& os)
+{
+	struct combination_hash
+	{
+		std::size_t operator()(const dscr::combinations::combination& c) const
+		{
+			std::size_t h = 0;
+			for (int x : c)
+				h = h*1000003 + x;
+			return h;
+		}
+	};
+
+	dscr::combinations X(24,6);
+	std::unordered_map<dscr::combinations::combination, long long, combination_hash> hashed;
+	dscr::combination_map<long long> direct(24,6);
+	for (auto it = X.begin(); it != X.end(); ++it)
+	{
+		hashed[*it] = it.ID();
+		direct.at(it) = it.ID();
+	}
+
+	os << ProduceRow("Combination memo unordered_map", [&]()
+	{
+		long long total = 0;
+		X.for_each([&](const auto& c) { total += hashed.find(c)->second; });
+		DoNotOptimize(total);
+	}, X.size());
+	os << ProduceRow("Combination memo combination_map", [&]()
+	{
+		long long total = 0;
+		X.for_each([&](const auto& c) { total += direct[c]; });
+		DoNotOptimize(total);
+	}, X.size());
+	os << ProduceRow("Combination memo combination_map by ID", [&]()
+	{
+		long long total = 0;
+		for (auto it = X.begin(); it != X.end(); ++it)
+			total += direct.at(it);
+		DoNotOptimize(total);
+	}, X.size());
+}
+
+// Sum over subsets of 2^16 values: directly over every submask (3^n steps) and with the zeta
+// transform (n passes), and the same transform over the submultisets of {3,3,3,3,3,3,3,3}.
+void subset_transform_rows(std::ostream& os)
+{
+	const int n = 16;
+	std::vector<long long> a(1 << n);
+	std::iota(a.begin(), a.end(), 0LL);
+	std::vector<long long> b(a.size());
+
+	os << ProduceRow("Sum over subsets 3^n", [&]()
+	{
+		for (std::size_t S = 0; S < a.size(); ++S)
+		{
+			long long sum = 0;
+			for (std::size_t R = S; ; R = (R - 1) & S)
+			{
+				sum += a[R];
+				if (R == 0)
+					break;
+			}
+			b[S] = sum;
+		}
+		DoNotOptimize(b.data());
+	}, a.size());
+	os << ProduceRow("Sum over subsets zeta_transform", [&]()
+	{
+		b = a;
+		dscr::power_set_zeta_transform(b);
+		DoNotOptimize(b.data());
+	}, a.size());
+
+	dscr::multisets X(8,3);
+	std::vector<long long> c(X.size());
+	os << ProduceRow("Sum over submultisets zeta_transform", [&]()
+	{
+		std::iota(c.begin(), c.end(), 0LL);
+		dscr::zeta_transform(X, c);
+		DoNotOptimize(c.data());
+	}, X.size());
+}
+
+// Counting the 7-subsets of [0,32) that add up to 112: walking find_all, and with the counting DP of
+// constrained_combinations (which includes building it), then sampling from it.
+struct sum_is_112
+{
+	using state_type = int;
+	int initial() const { return 0; }
+	int state(int sum, int x) const { return sum + x; }
+	bool viable(int sum) const { return sum <= 112; }
+	bool accept(int sum) const { return sum == 112; }
+};
+
+void constrained_rows(std::ostream& os)
+{
+	dscr::constrained_combinations<sum_is_112> X(32,7);
+
+	os << ProduceRow("Constrained count find_all", [&]()
+	{
+		struct sum_at_most
+		{
+			int sum = 0;
+			void on_push(int x) { sum += x; }
+			void on_pop(int x) { sum -= x; }
+			bool accept() const { return sum <= 112; }
+		};
+		long long count = 0;
+		for (auto& x : dscr::combinations(32,7).find_all(sum_at_most()))
+			count += (std::accumulate(x.begin(), x.end(), 0) == 112);
+		DoNotOptimize(count);
+	}, X.size());
+	os << ProduceRow("Constrained count DP", [&]()
+	{
+		dscr::constrained_combinations<sum_is_112> Y(32,7);
+		DoNotOptimize(Y.size());
+	}, X.size());
+	os << ProduceRow("Constrained uniform sample", [&]()
+	{
+		auto x = X.random();
+		DoNotOptimize(x);
+	}, 1);
+}
+
+// The same families at increasing sizes, to see how the speed scales (and where caches run out).
+void size_sweeps(std::ostream& os)
+{
+	const int construct = 100000;
+	
+	BenchRow::print_line(os);
+	for (int n = 16; n <= 28; n += 4)
+	{
+		std::string size = " n=" + std::to_string(n) + " k=" + std::to_string(n/2);
+		BenchmarkFamily(os, "Combinations" + size, dscr::combinations(n,n/2), dscr::combinations_fast(n,n/2), construct);
+		BenchmarkFamily(os, "Combinations Tree" + size, dscr::combinations_tree(n,n/2), dscr::combinations_tree_fast(n,n/2), construct);
+	}
+	
+	BenchRow::print_line(os);
+	for (int n = 8; n <= 11; ++n)
+	{
+		std::string size = " n=" + std::to_string(n);
+		BenchmarkFamily(os, "Permutations" + size, dscr::permutations(n), dscr::permutations_fast(n), construct);
+	}
+	
+	BenchRow::print_line(os);
+	for (int n = 6; n <= 12; n += 2)
+	{
+		std::string size = " n=" + std::to_string(n) + " (3 each)";
+		std::vector<int> total(n, 3);
+		dscr::multisets_fast::multiset total_fast(n, 3);
+		BenchmarkFamily(os, "Multisets" + size, dscr::multisets(total), dscr::multisets_fast(total_fast), construct);
+		BenchmarkFamily(os, "Multisets Gray" + size, dscr::multisets_gray(total), dscr::multisets_gray_fast(total_fast), construct);
+	}
+	
+	BenchRow::print_line(os);
+	for (int n = 12; n <= 18; n += 2)
+	{
+		std::string size = " n=" + std::to_string(n);
+		BenchmarkFamily(os, "Dyck Paths" + size, dscr::dyck_paths(n), dscr::dyck_paths_fast(n), construct);
+		BenchmarkFamily(os, "Dyck Paths Packed" + size, dscr::dyck_paths_packed(n), construct);
+		std::string motzkin_size = " n=" + std::to_string(n + 2);
+		BenchmarkFamily(os, "Motzkin Paths" + motzkin_size, dscr::motzkin_paths(n + 2), dscr::motzkin_paths_fast(n + 2), construct);
+	}
+	
+	BenchRow::print_line(os);
+	for (int n = 40; n <= 70; n += 10)
+	{
+		std::string size = " n=" + std::to_string(n);
+		BenchmarkFamily(os, "Partitions" + size, dscr::partitions(n), dscr::partitions_fast(n), construct);
+	}
+	
+	BenchRow::print_line(os);
+	for (int n = 8; n <= 12; n += 2)
+	{
+		std::string size = " n=" + std::to_string(n);
+		BenchmarkFamily(os, "Set Partitions" + size, dscr::set_partitions(n), construct);
+	}
+}
+
+int main(int argc, char* argv[])
 {
 	using std::cout;
 	using std::endl;
+	
+	if (!parse_benchmark_options(argc, argv))
+		return 0;
 
 	using dscr::binomial;
 	std::ios_base::sync_with_stdio(false);
@@ -26,6 +317,7 @@ int main()
 	const int nperm = 12;
 	
 	const int npart = 75;
+	const int npartk = 120;
 	const int nsetpart = 13;
 	const int ndyck = 18;
 	const int nmotzkin = 20;
@@ -33,6 +325,9 @@ int main()
 	
 	dscr::combinations C(n,k);
 	dscr::basic_combinations<int,boost::container::static_vector<int,k>> CF(n,k);
+	std::vector<int> objects(n);
+	std::iota(objects.begin(), objects.end(), 0);
+	auto UC = dscr::compound_combinations(objects,k);
 	dscr::combinations_tree CT(n,k);
 	dscr::basic_combinations_tree<int,boost::container::static_vector<int,k>> CTF(n,k);
 	
@@ -41,78 +336,122 @@ int main()
 	
 	dscr::dyck_paths DP(ndyck);
 	dscr::basic_dyck_paths<int,boost::container::static_vector<int,2*ndyck>> DPF(ndyck);
+	dscr::dyck_paths_packed DPP(ndyck);
 	dscr::motzkin_paths MP(nmotzkin);
 	dscr::basic_motzkin_paths<int,boost::container::static_vector<int,nmotzkin>> MPF(nmotzkin);
 	
 	dscr::partitions PT(npart);
 	dscr::basic_partitions<int,boost::container::static_vector<int,npart+1>> PTF(npart);
+	dscr::partitions PTK(npartk, 10);
+	dscr::basic_partitions<int,boost::container::static_vector<int,npartk+1>> PTKF(npartk, 10);
 	dscr::set_partitions SPT(nsetpart);
+	dscr::set_partitions SPTK(nsetpart + 1, 4);
 	
 	auto ms = {4,2,3,1,0,1,5,0,5,4,0,1,1,5,2,0,2,1};
 	dscr::multisets MS(ms);
 	dscr::multisets_fast MSF(ms);
+	dscr::multisets_gray MSG(ms);
+	dscr::multisets_gray_fast MSGF(ms);
+	
 	
+	auto gaps = [](const auto& comb)
+	{
+		if (comb.size() < 2)
+			return true;
+		
+		long k = comb.size();
+		return comb[k - 1] > comb[k - 2] + 2;
+	};
+	
+	auto spaced = [](const dscr::combinations::combination& comb)
+	{
+		long k = comb.size();
+		int sum = 0;
+		for (int x : comb)
+			sum += x;
+		for (long i = 0; i + 1 < k; ++i)
+		{
+			int d = comb[k - 1] - comb[i];
+			if (d == 1 || d == 3)
+				return false;
+		}
+		return sum <= 400;
+	};
 	
 	BenchRow::print_header(cout);
 	BenchRow::print_line(cout);
-	cout << ProduceRowForEach("Combinations", C);
-	cout << ProduceRowForEach("Combinations Stack", CF);
-	cout << ProduceRowForward("Combinations", C);	
-	cout << ProduceRowForward("Combinations Stack", CF);	
-	cout << ProduceRowReverse("Combinations", C);
-	cout << ProduceRowReverse("Combinations Stack", CF);
-	cout << ProduceRowConstruct("Combinations", C, construct);
-	cout << ProduceRowConstruct("Combinations Stack", CF, construct);
+	BenchmarkFamily(cout, "Combinations", C, CF, construct);
+	cout << ProduceRowFindAll("Combinations", dscr::combinations(100,5), gaps);
+	cout << ProduceRowFindAll("Combinations Stack", dscr::combinations_fast(100,5), gaps);
+	cout << ProduceRowFindAll("Combinations k=15 partial", dscr::combinations(40,15), spaced);
+	cout << ProduceRowFindAll("Combinations k=15 incremental", dscr::combinations(40,15), spaced_incremental());
+	BenchmarkFamily(cout, "Compound Combinations", UC, construct);
+	cout << ProduceRow("Compound Combinations gather_many", [&UC]()
+	{
+		const long block = 4096;
+		std::vector<int> buffer(block*k);
+		for (auto it = UC.begin(); it < UC.end(); it += block)
+		{
+			UC.gather_many(it, std::min(it + block, UC.end()), buffer.data());
+			DoNotOptimize(buffer[0]);
+		}
+	}, UC.size());
+	
+	rank_map_rows(cout);
+	subset_transform_rows(cout);
+	constrained_rows(cout);
 	
 	BenchRow::print_line(cout);
-	cout << ProduceRowForEach("Combinations Tree", CT);
-	cout << ProduceRowForEach("Combinations Tree Stack", CTF);
-	cout << ProduceRowForward("Combinations Tree", CT);
-	cout << ProduceRowForward("Combinations Tree Stack", CTF);
-	cout << ProduceRowReverse("Combinations Tree", CT);
-	cout << ProduceRowReverse("Combinations Tree Stack", CTF);
+	BenchmarkFamily(cout, "Combinations Tree", CT, CTF, construct);
+	cout << ProduceRowFindAll("Combinations Tree", dscr::combinations_tree(100,5), gaps);
+	cout << ProduceRowFindAll("Combinations Tree Stack", dscr::combinations_tree_fast(100,5), gaps);
+	optimize_rows(cout);
 #ifdef TEST_GSL_COMBINATIONS
-	cout << BenchRow("Combinations Tree GSL", Benchmark([](){BM_CombinationsTreeGSL(n,k);}), binomial<std::int64_t>(n,k));
+	cout << ProduceRow("Combinations Tree GSL", [](){BM_CombinationsTreeGSL(n,k);}, binomial<std::int64_t>(n,k));
 #endif
-	cout << ProduceRowConstruct("Combinations Tree", CT, construct);
-	cout << ProduceRowConstruct("Combinations Tree Stack", CTF, construct);
 	
 	BenchRow::print_line(cout);
-	cout << ProduceRowForward("Permutations", P);
-	cout << ProduceRowForward("Permutations Stack", PF);
-	cout << ProduceRowReverse("Permutations", P);
-	cout << ProduceRowReverse("Permutations Stack", PF);
-	cout << ProduceRowConstruct("Permutations", P, construct);
-	cout << ProduceRowConstruct("Permutations Stack", PF, construct);
+	BenchmarkFamily(cout, "Permutations", P, PF, construct);
 	
 	BenchRow::print_line(cout);
-	cout << ProduceRowForward("Multisets", MS);
-	cout << ProduceRowForward("Multisets Stack", MSF);
-	cout << ProduceRowReverse("Multisets", MS);
-	cout << ProduceRowReverse("Multisets Stack", MSF);
-	cout << ProduceRowConstruct("Multisets", MS, construct);
-	cout << ProduceRowConstruct("Multisets Stack", MSF, construct);
+	BenchmarkFamily(cout, "Multisets", MS, MSF, construct);
+	BenchmarkFamily(cout, "Multisets Gray", MSG, MSGF, construct);
 	
 	BenchRow::print_line(cout);
-	cout << ProduceRowForward("Dyck Paths", DP);
-	cout << ProduceRowForward("Dyck Paths Stack", DPF);
+	BenchmarkFamily(cout, "Dyck Paths", DP, DPF, construct);
+	BenchmarkFamily(cout, "Dyck Paths Packed", DPP, construct);
 	
-// 	BenchRow::print_line(cout);
-	cout << ProduceRowForward("Motzkin Paths", MP);
-	cout << ProduceRowForward("Motzkin Paths Stack", MPF);
+	BenchRow::print_line(cout);
+	BenchmarkFamily(cout, "Motzkin Paths", MP, MPF, construct);
 	
 	BenchRow::print_line(cout);
-	cout << ProduceRowForward("Partitions", PT);
-	cout << ProduceRowForward("Partitions Stack", PTF);
-	cout << ProduceRowReverse("Partitions", PT);
-	cout << ProduceRowReverse("Partitions Stack", PTF);
+	BenchmarkFamily(cout, "Partitions", PT, PTF, construct);
+	BenchmarkFamily(cout, "Partitions 10 parts", PTK, PTKF, construct);
 	
 	BenchRow::print_line(cout);
-	cout << ProduceRowForward("Set Partitions", SPT);
-
+	BenchmarkFamily(cout, "Set Partitions", SPT, construct);
+	BenchmarkFamily(cout, "Set Partitions 4 parts", SPTK, construct);
+	
+	ScalingBenchmarks(cout);
+	
+	if (benchmark_options().sweep)
+		size_sweeps(cout);
+	
 	BenchRow::print_line(cout);
 	cout << std::defaultfloat;
 	cout << "\nTotal Time taken = " << chrono.Reset() << "s" << endl;
+	
+	if (dscr::instrumentation::enabled)
+	{
+		cout << '\n';
+		dscr::dump_instrumentation(cout);
+	}
+	
+	if (!write_benchmark_reports())
+	{
+		std::cerr << "Could not write the benchmark reports" << endl;
+		return 1;
+	}
 	return 0;
 
 }
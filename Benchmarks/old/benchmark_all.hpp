@@ -1,14 +0,0 @@
-#pragma once
-
-#include "combinations_benchmark.hpp"
-#include "combinations_benchmark.hpp"
-#include "dyck_benchmark.hpp"
-#include "misc_benchmark.hpp"
-#include "motzkin_benchmark.hpp"
-#include "multisets_benchmark.hpp"
-#include "partitions_benchmark.hpp"
-#include "permutations_benchmark.hpp"
-#include "range_benchmark.hpp"
-#include "sequence_benchmark.hpp"
-#include "set_partitions_benchmark.hpp"
-
@@ -1,9 +0,0 @@
-#pragma once
-#include "Combinations.hpp"
-
-
-
-void testCombinationsSpeed(int n = 32, int k = 16);
-void testCombinationsTreeSpeed(int n = 32, int k = 16);
-
-void produceAllCombinationBenchmarkData(int from, int to);
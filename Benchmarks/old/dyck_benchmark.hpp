@@ -1,5 +0,0 @@
-#pragma once
-#include "DyckPaths.hpp"
-#include <vector>
-
-void testDyckPathsSpeed(int n);
@@ -1,4 +0,0 @@
-#pragma once
-#include "Motzkin.hpp"
-
-void testMotzkinSpeed(int n);
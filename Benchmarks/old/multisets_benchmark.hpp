@@ -1,4 +0,0 @@
-#pragma once
-#include "Multisets.hpp"
-
-void testMultisetSpeed();
@@ -1,4 +0,0 @@
-#pragma once
-#include "Partitions.hpp"
-
-void testPartitionsSpeed(int n);
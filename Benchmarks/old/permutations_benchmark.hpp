@@ -1,4 +0,0 @@
-#pragma once
-#include "Permutations.hpp"
-
-void testPermutationsSpeed(int n);
@@ -1 +0,0 @@
-#include "range_benchmark.hpp"
@@ -1,2 +0,0 @@
-#include "sequence_benchmark.hpp"
-
@@ -1,4 +0,0 @@
-#pragma once
-#include "SetPartitions.hpp"
-
-void testSetPartitionSpeed(int n);
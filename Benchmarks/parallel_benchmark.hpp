@@ -0,0 +1,171 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include "benchtable.hpp"
+#include "Parallel.hpp"
+#include "Pipeline.hpp"
+#include "Combinations.hpp"
+#include "Permutations.hpp"
+#include "Multisets.hpp"
+#include "Partitions.hpp"
+
+// How parallel_for_each scales with the number of threads, with the same amount of work per
+// element (uniform) and with work that grows along the iteration order (skewed), which is the
+// worst case for splitting the range into equal contiguous blocks.
+
+////////////////////////////////////////////////////////////
+/// \brief Some cpu work proportional to units, that the compiler can't remove.
+////////////////////////////////////////////////////////////
+inline void busy_work(long units)
+{
+	std::uint64_t x = units;
+	for (long i = 0; i < units; ++i)
+		x = x*6364136223846793005ULL + 1442695040888963407ULL;
+	DoNotOptimize(x);
+}
+
+////////////////////////////////////////////////////////////
+/// \brief 1, 2, 4, ... up to benchmark_threads(), which is always included.
+////////////////////////////////////////////////////////////
+inline std::vector<int> scaling_thread_counts()
+{
+	std::vector<int> counts;
+	int max_threads = benchmark_threads();
+	for (int t = 1; t < max_threads; t *= 2)
+		counts.push_back(t);
+	counts.push_back(max_threads);
+	return counts;
+}
+
+// Slowest thread over the average thread.
+inline double imbalance(const std::vector<double>& thread_times)
+{
+	if (thread_times.empty())
+		return 1.0;
+	double total = std::accumulate(thread_times.begin(), thread_times.end(), 0.0);
+	double slowest = *std::max_element(thread_times.begin(), thread_times.end());
+	return total > 0.0 ? slowest*thread_times.size()/total : 1.0;
+}
+
+////////////////////////////////////////////////////////////
+/// \brief Runs f on every element of A with parallel_for_each at each of scaling_thread_counts().
+///
+/// Rows are named name + " t=" + threads. The single thread run is always measured (if any row is
+/// selected) since speedup and efficiency are relative to it.
+////////////////////////////////////////////////////////////
+template <class Container, class Work>
+void ProduceRowsScaling(std::ostream& os, const std::string& name, const Container& A, Work f)
+{
+	auto counts = scaling_thread_counts();
+	auto row_name = [&name](int threads)
+	{
+		return name + " t=" + std::to_string(threads);
+	};
+
+	bool any = std::any_of(counts.begin(), counts.end(), [&row_name](int t) { return benchmark_selected(row_name(t)); });
+	if (!any || benchmark_options().list_only)
+	{
+		for (int t : counts)
+			os << BenchRow::Skipped(row_name(t));
+		return;
+	}
+
+	double single_thread_time = 0.0;
+	for (int t : counts)
+	{
+		std::vector<double> thread_times;
+		std::vector<double> imbalances;
+		auto stats = Benchmark([&]()
+		{
+			dscr::parallel_for_each(A, f, t, &thread_times);
+			imbalances.push_back(imbalance(thread_times));
+		});
+		std::sort(imbalances.begin(), imbalances.end());
+
+		BenchRow row(row_name(t), stats, A.size(), "objects");
+		if (t == 1)
+			single_thread_time = row.avg_time;
+		row.speedup = single_thread_time/row.avg_time;
+		row.efficiency = row.speedup/t;
+		row.imbalance = median_of_sorted(imbalances);
+
+		if (benchmark_selected(row.name))
+			os << record(row);
+	}
+}
+
+template <class Container, class Weight>
+void ProduceRowsScaling(std::ostream& os, const std::string& name, const Container& A, long uniform_units, Weight skewed_units)
+{
+	ProduceRowsScaling(os, name + " uniform", A, [uniform_units](const auto& x)
+	{
+		DoNotOptimize(x);
+		busy_work(uniform_units);
+	});
+
+	ProduceRowsScaling(os, name + " skewed", A, [skewed_units](const auto& x)
+	{
+		busy_work(skewed_units(x));
+	});
+}
+
+////////////////////////////////////////////////////////////
+/// \brief Runs f on every element of A with pipeline_for_each: one enumerator thread and 1, 2, 4, ... consumers.
+////////////////////////////////////////////////////////////
+template <class Container, class Work>
+void ProduceRowsPipeline(std::ostream& os, const std::string& name, const Container& A, Work f)
+{
+	for (int t : scaling_thread_counts())
+	{
+		dscr::pipeline_options options;
+		options.num_consumers = t;
+		os << ProduceRow(name + " t=" + std::to_string(t), [&A, &f, &options]()
+		{
+			dscr::pipeline_for_each(A, f, options);
+		}, A.size());
+	}
+}
+
+////////////////////////////////////////////////////////////
+/// \brief The scaling suite. In every skewed case the later elements (in iteration order) are
+/// several times more expensive than the first ones, with about the same average as uniform.
+////////////////////////////////////////////////////////////
+inline void ScalingBenchmarks(std::ostream& os)
+{
+	const long units = 64;
+
+	BenchRow::print_line(os);
+	dscr::combinations C(26,7);
+	ProduceRowsScaling(os, "Scaling Combinations", C, units, [](const auto& x)
+	{
+		return 4L*(x.back() - 6); // colex order: the last element only goes up
+	});
+	ProduceRowsPipeline(os, "Pipeline Combinations skewed", C, [](const auto& x)
+	{
+		busy_work(4L*(x.back() - 6));
+	});
+
+	BenchRow::print_line(os);
+	dscr::permutations P(9);
+	ProduceRowsScaling(os, "Scaling Permutations", P, units, [](const auto& x)
+	{
+		return 16L*x[0];
+	});
+
+	BenchRow::print_line(os);
+	dscr::multisets MS(std::vector<int>(9, 3));
+	ProduceRowsScaling(os, "Scaling Multisets", MS, units, [](const auto& x)
+	{
+		return 32L*x.back() + 16; // the last coordinate is the most significant one
+	});
+
+	// parallel_for_each needs random access, but a pipeline only needs one enumerator.
+	BenchRow::print_line(os);
+	dscr::partitions PT(60);
+	ProduceRowsPipeline(os, "Pipeline Partitions skewed", PT, [](const auto& x)
+	{
+		busy_work(2L*x.size());
+	});
+}
@@ -0,0 +1,78 @@
+#include "Discreture/Combinations.hpp"
+#include "Discreture/Sharding.hpp"
+#include <cstdlib>
+#include <numeric>
+#include <string>
+#include <vector>
+
+using std::cout;
+using std::cerr;
+using std::endl;
+using dscr::combinations;
+
+// How many combinations of the shard add up to s.
+long long count_shard(const dscr::subrange<combinations::iterator>& shard, int s)
+{
+	long long count = 0;
+	for (auto& x : shard)
+		count += (std::accumulate(x.begin(), x.end(), 0) == s);
+	return count;
+}
+
+void print_usage(const char* name)
+{
+	cout << "Usage: " << name << " n k s workers\n"
+		 << "       " << name << " n k s --shard i N\n"
+		 << "Counts the combinations of size k of {0,...,n-1} whose elements add up to s.\n"
+		 << "The first form splits the work among that many local worker processes.\n"
+		 << "The second one only counts shard i of N, so N processes (on any machines) can\n"
+		 << "each do one, and the total is the sum of what they print.\n"
+		 << "Example:\n"
+		 << name << " 30 8 116 4\n";
+}
+
+int main(int argc, char* argv[])
+{
+	std::vector<std::string> arguments(argv + 1, argv + argc);
+
+	if (arguments.size() != 4 && !(arguments.size() == 6 && arguments[3] == "--shard"))
+	{
+		cout << "\nERROR: Wrong number of arguments!\n\n";
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	try
+	{
+		int n = std::stoi(arguments[0]);
+		int k = std::stoi(arguments[1]);
+		int s = std::stoi(arguments[2]);
+		combinations X(n,k);
+
+		if (arguments.size() == 6)
+		{
+			long long i = std::stoll(arguments[4]);
+			long long N = std::stoll(arguments[5]);
+			cout << count_shard(X.shard(i,N), s) << endl;
+			return 0;
+		}
+
+		int workers = std::stoi(arguments[3]);
+		auto results = dscr::fork_shards(X, workers, [s](const dscr::subrange<combinations::iterator>& shard)
+		{
+			return std::to_string(count_shard(shard, s));
+		});
+
+		long long total = 0;
+		for (auto& r : results)
+			total += std::stoll(r);
+		cout << total << endl;
+	}
+	catch (const std::exception& e)
+	{
+		cerr << "ERROR: " << e.what() << endl;
+		return 1;
+	}
+
+	return 0;
+}
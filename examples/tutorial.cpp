@@ -45,8 +45,8 @@ int main()
 	 *   2. It does not check for repeats! So if you do compound_combinations on "aaaaa", 
 	 *      it will just produce many sets with "aaa".
 	 *   3. The std::string is necessary, because "abcde" is not a proper container. It's an C-style char array.
-	 *   4. Note that auto& combination does NOT compile. 
-	 * 	    This is because "combination" is of type dscr::arrangement, which vanishes.
+	 *   4. x is of type dscr::arrangement, which is just a view of the current combination.
+	 * 	    Nothing is copied, but it's only valid until the loop moves on.
 	 */
 	
 	cout << "\nNow in reverse!" << endl;
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+////////////////////////////////////////////////////////////
+/// \file AllocationCounter.hpp
+/// \brief Counts calls to the global operator new, to check that enumeration doesn't allocate.
+///
+/// This is a debugging/benchmarking aid and is not included by discreture.hpp. Exactly one
+/// translation unit of the program must define DISCRETURE_COUNT_ALLOCATIONS before including
+/// this header; that replaces the global operator new and delete with counting versions.
+/// Anywhere else, just include it and use allocation_scope:
+///
+/// 	dscr::allocation_scope scope;
+/// 	for (auto& x : X)
+/// 		f(x);
+/// 	std::cout << scope.allocations() << std::endl;
+///
+/// Without the hook, allocation_counting_enabled() is false and everything counts zero.
+////////////////////////////////////////////////////////////
+
+namespace dscr
+{
+namespace detail
+{
+inline std::atomic<long long>& allocation_counter()
+{
+	static std::atomic<long long> counter {0};
+	return counter;
+}
+
+inline std::atomic<long long>& allocated_bytes_counter()
+{
+	static std::atomic<long long> counter {0};
+	return counter;
+}
+
+inline std::atomic<bool>& allocation_hook_installed()
+{
+	static std::atomic<bool> installed {false};
+	return installed;
+}
+
+inline void count_allocation(std::size_t size)
+{
+	allocation_counter().fetch_add(1, std::memory_order_relaxed);
+	allocated_bytes_counter().fetch_add(size, std::memory_order_relaxed);
+}
+} // namespace detail
+
+////////////////////////////////////////////////////////////
+/// \brief true if the counting operator new is linked in (see above).
+////////////////////////////////////////////////////////////
+inline bool allocation_counting_enabled()
+{
+	return detail::allocation_hook_installed().load(std::memory_order_relaxed);
+}
+
+////////////////////////////////////////////////////////////
+/// \brief Total number of calls to operator new so far, in all threads.
+////////////////////////////////////////////////////////////
+inline long long allocation_count()
+{
+	return detail::allocation_counter().load(std::memory_order_relaxed);
+}
+
+inline long long allocated_bytes()
+{
+	return detail::allocated_bytes_counter().load(std::memory_order_relaxed);
+}
+
+////////////////////////////////////////////////////////////
+/// \brief Number of allocations (and bytes) since construction.
+////////////////////////////////////////////////////////////
+class allocation_scope
+{
+public:
+	allocation_scope() : m_count(allocation_count()), m_bytes(allocated_bytes()) {}
+
+	long long allocations() const
+	{
+		return allocation_count() - m_count;
+	}
+
+	long long bytes() const
+	{
+		return allocated_bytes() - m_bytes;
+	}
+
+private:
+	long long m_count;
+	long long m_bytes;
+};
+} // namespace dscr
+
+#ifdef DISCRETURE_COUNT_ALLOCATIONS
+
+namespace dscr
+{
+namespace detail
+{
+inline void* counted_allocation(std::size_t size)
+{
+	count_allocation(size);
+	if (size == 0)
+		size = 1;
+	while (true)
+	{
+		void* p = std::malloc(size);
+		if (p)
+			return p;
+		auto handler = std::get_new_handler();
+		if (!handler)
+			throw std::bad_alloc();
+		handler();
+	}
+}
+
+struct allocation_hook_marker
+{
+	allocation_hook_marker()
+	{
+		allocation_hook_installed() = true;
+	}
+};
+
+static allocation_hook_marker install_allocation_hook;
+} // namespace detail
+} // namespace dscr
+
+void* operator new(std::size_t size)
+{
+	return dscr::detail::counted_allocation(size);
+}
+
+void* operator new[](std::size_t size)
+{
+	return dscr::detail::counted_allocation(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	try
+	{
+		return dscr::detail::counted_allocation(size);
+	}
+	catch (...)
+	{
+		return nullptr;
+	}
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	try
+	{
+		return dscr::detail::counted_allocation(size);
+	}
+	catch (...)
+	{
+		return nullptr;
+	}
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+#endif // DISCRETURE_COUNT_ALLOCATIONS
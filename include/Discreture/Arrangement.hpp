@@ -1,14 +1,146 @@
 #pragma once
 #include "Misc.hpp"
+#include <type_traits>
+#include <cstring>
+
+// Hardware gathers (vpgather) are only a win on some CPUs: with the microcode mitigations for
+// "gather data sampling" they are slower than plain unrolled loads. Define DISCRETURE_USE_AVX2_GATHER to use them.
+#if defined(__AVX2__) && defined(DISCRETURE_USE_AVX2_GATHER)
+#define DISCRETURE_AVX2_GATHER 1
+#include <immintrin.h>
+#endif
 
 namespace dscr
 {
 
+namespace detail
+{
+template <class T, class = void>
+struct has_data : std::false_type {};
+
+template <class T>
+struct has_data<T, decltype(static_cast<void>(std::declval<const T&>().data()))> : std::true_type {};
+
+// out[i] = src[idx[i]], four at a time.
+template <class T, class I>
+inline T* gather_unrolled(const T* src, const I* idx, long n, T* out)
+{
+	long i = 0;
+	for ( ; i + 4 <= n; i += 4)
+	{
+		T a = src[idx[i]];
+		T b = src[idx[i+1]];
+		T c = src[idx[i+2]];
+		T d = src[idx[i+3]];
+		out[i] = a;
+		out[i+1] = b;
+		out[i+2] = c;
+		out[i+3] = d;
+	}
+	for ( ; i < n; ++i)
+		out[i] = src[idx[i]];
+	return out + n;
+}
+
+template <class T, class I>
+inline T* gather_contiguous(const T* src, const I* idx, long n, T* out, std::false_type /*simd*/)
+{
+	return gather_unrolled(src, idx, n, out);
+}
+
+#if defined(DISCRETURE_AVX2_GATHER)
+// T is trivially copyable with sizeof(T) 4 or 8, and I is a 32 bit integer.
+template <class T, class I>
+inline T* gather_contiguous(const T* src, const I* idx, long n, T* out, std::true_type /*simd*/)
+{
+	long i = 0;
+	if (sizeof(T) == 4)
+	{
+		for ( ; i + 8 <= n; i += 8)
+		{
+			__m256i vi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(idx + i));
+			__m256i v = _mm256_i32gather_epi32(reinterpret_cast<const int*>(src), vi, 4);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), v);
+		}
+	}
+	else
+	{
+		for ( ; i + 4 <= n; i += 4)
+		{
+			__m128i vi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(idx + i));
+			__m256i v = _mm256_i32gather_epi64(reinterpret_cast<const long long*>(src), vi, 8);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), v);
+		}
+	}
+	for ( ; i < n; ++i)
+		std::memcpy(out + i, src + idx[i], sizeof(T));
+	return out + n;
+}
+#endif
+
+template <class T, class I>
+struct can_simd_gather : std::integral_constant<bool,
+#if defined(DISCRETURE_AVX2_GATHER)
+	std::is_trivially_copyable<T>::value && (sizeof(T) == 4 || sizeof(T) == 8) &&
+	std::is_integral<I>::value && sizeof(I) == 4
+#else
+	false
+#endif
+	> {};
+
+template <class RAContainer, class RAIndexContainer, class OutputIt>
+inline OutputIt gather(const RAContainer& objects, const RAIndexContainer& indices, OutputIt out, std::false_type /*contiguous*/)
+{
+	for (const auto& i : indices)
+	{
+		*out = objects[i];
+		++out;
+	}
+	return out;
+}
+
+template <class RAContainer, class RAIndexContainer, class T>
+inline T* gather(const RAContainer& objects, const RAIndexContainer& indices, T* out, std::true_type /*contiguous*/)
+{
+	using I = typename std::decay<decltype(*indices.data())>::type;
+	return gather_contiguous(objects.data(), indices.data(), indices.size(), out, can_simd_gather<T, I>());
+}
+
+template <class RAContainer, class RAIndexContainer, class OutputIt>
+inline OutputIt gather(const RAContainer& objects, const RAIndexContainer& indices, OutputIt out)
+{
+	using contiguous = std::integral_constant<bool, 
+		std::is_pointer<OutputIt>::value && has_data<RAContainer>::value && has_data<RAIndexContainer>::value &&
+		std::is_same<typename std::remove_cv<typename std::remove_pointer<OutputIt>::type>::type, typename RAContainer::value_type>::value>;
+	return gather(objects, indices, out, contiguous());
+}
+} // namespace detail
+
+///////////////////////////////////////////////
+/// \brief Writes objects[I[0]], objects[I[1]], ... for each index container I in [first, last) consecutively into out.
+///
+/// This is the batched version of arrangement::gather_into, e.g. to materialize a block of combinations
+/// into a scoring buffer with a single call. With contiguous containers it's an unrolled copy, or
+/// hardware gathers for 4 or 8 byte objects and 32 bit indices if DISCRETURE_USE_AVX2_GATHER is defined.
+///
+/// \return the position in out after the last element written.
+///////////////////////////////////////////////
+template <class RAContainer, class IndexIterator, class OutputIt>
+OutputIt gather_many(const RAContainer& objects, IndexIterator first, IndexIterator last, OutputIt out)
+{
+	for ( ; first != last; ++first)
+		out = detail::gather(objects, *first, out);
+	return out;
+}
+
 ///////////////////////////////////////////////
 /// \brief class for composing two containers "A" and "B", where the elements of B are integers between 0 and A.size()
 /// Then the elements of arrangement(A,B) are {A[B[0]], A[B[1]], ...}, but arrangement is lazy.
+///
+/// By default it just points to A and B, so it's as cheap to copy as two pointers and both must outlive it.
+/// If OwnsIndices is true, it keeps its own copy of B instead (but still points to A).
 ///////////////////////////////////////////////
-template <class RAContainer, class RAIndexContainer>
+template <class RAContainer, class RAIndexContainer, bool OwnsIndices = false>
 class arrangement
 {
 public:
@@ -18,36 +150,68 @@ public:
 	class iterator;
 	using const_iterator = iterator;
 	
+	arrangement() {}
+	
 	arrangement(const RAContainer& objects, 
 				const RAIndexContainer& indices) : 
-							m_objects(objects),
-							m_indices(indices)
+							m_objects(&objects),
+							m_indices(store(indices))
+	{
+	}
+	
+	///////////////////////////////////////////////
+	/// \brief An arrangement that owns its indices, from a view: copies the indices.
+	///////////////////////////////////////////////
+	template <bool Owns = OwnsIndices, class = typename std::enable_if<Owns>::type>
+	arrangement(const arrangement<RAContainer, RAIndexContainer, false>& view) :
+							m_objects(&view.objects()),
+							m_indices(view.indices())
 	{
 	}
 	
 	iterator begin() const
 	{
-		return iterator(m_objects,m_indices.begin());
+		return iterator(*m_objects,indices().begin());
 	}
 
 	iterator end() const
 	{
-		return iterator(m_objects,m_indices.end());
+		return iterator(*m_objects,indices().end());
 	}
 	
 	size_type size() const 
 	{
-		return m_indices.size();
+		return indices().size();
 	}
 	
 	const value_type& operator[](difference_type m) const
 	{
-		return m_objects[m_indices[m]];
+		return (*m_objects)[indices()[m]];
+	}
+	
+	const RAIndexContainer& indices() const
+	{
+		return get(m_indices);
+	}
+	
+	const RAContainer& objects() const
+	{
+		return *m_objects;
 	}
 	
 	RAContainer bake() const
 	{
-		return RAContainer(begin(),end());
+		return bake(std::integral_constant<bool, detail::has_data<RAContainer>::value && std::is_trivially_copyable<value_type>::value>());
+	}
+	
+	///////////////////////////////////////////////
+	/// \brief Writes the elements of the arrangement into out, which must have room for size() elements.
+	/// \return out + size()
+	///////////////////////////////////////////////
+	template <class OutputIt>
+	OutputIt gather_into(OutputIt out) const
+	{
+		return detail::gather(*m_objects, indices(), out);
 	}
 	
 	// ****************** start iterator
@@ -61,10 +225,12 @@ public:
 	public:
 		using index_iter = typename RAIndexContainer::const_iterator;
 		
+		iterator() {}
+		
 		iterator(const RAContainer& objects, 
 				 const index_iter& index) :
 					m_index_iter(index),
-					m_objects(objects)
+					m_objects(&objects)
 		{
 		}
 		
@@ -86,7 +252,7 @@ public:
 		
 		const value_type& dereference() const
 		{
-			return m_objects[*m_index_iter];
+			return (*m_objects)[*m_index_iter];
 		}
 		
 		bool equal(const iterator& other) const
@@ -100,14 +266,36 @@ public:
 		}
 		
 	private:
-		index_iter m_index_iter;
-		const RAContainer& m_objects;
+		index_iter m_index_iter {};
+		const RAContainer* m_objects {nullptr};
 		friend class boost::iterator_core_access;
 	};
 	// ********** end iterator
 private:
-	const RAContainer& m_objects;
-	const RAIndexContainer& m_indices;
+	RAContainer bake(std::false_type) const
+	{
+		return RAContainer(begin(),end());
+	}
+	
+	RAContainer bake(std::true_type) const
+	{
+		RAContainer result(size(), value_type());
+		if (!result.empty())
+			gather_into(&result[0]);
+		return result;
+	}
+	
+	using index_storage = typename std::conditional<OwnsIndices, RAIndexContainer, const RAIndexContainer*>::type;
+	
+	static const RAIndexContainer* store(const RAIndexContainer& indices, std::false_type) { return &indices; }
+	static const RAIndexContainer& store(const RAIndexContainer& indices, std::true_type) { return indices; }
+	static index_storage store(const RAIndexContainer& indices) { return store(indices, std::integral_constant<bool, OwnsIndices>()); }
+	
+	static const RAIndexContainer& get(const RAIndexContainer* indices) { return *indices; }
+	static const RAIndexContainer& get(const RAIndexContainer& indices) { return indices; }
+	
+	const RAContainer* m_objects {nullptr};
+	index_storage m_indices {};
 };
 
 template <class RAContainer, 
@@ -119,8 +307,8 @@ make_arrangement(const RAContainer& objects,
 	return arrangement<RAContainer, RAIndexContainer>(objects, indices);
 }
 
-template <class RAContainer, class RAIndexContainer>
-std::ostream& operator<<(std::ostream& os, const arrangement<RAContainer, RAIndexContainer>& A)
+template <class RAContainer, class RAIndexContainer, bool OwnsIndices>
+std::ostream& operator<<(std::ostream& os, const arrangement<RAContainer, RAIndexContainer, OwnsIndices>& A)
 {
 	for (auto& a : A)
 		os << a << ' ';
@@ -0,0 +1,712 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <boost/iterator/iterator_facade.hpp>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+////////////////////////////////////////////////////////////
+/// \file BinaryExport.hpp
+/// \brief Writes enumerated objects to a compact binary file and reads them back with mmap.
+///
+/// A file is a binary_header followed by count records, all of the same width. There are two kinds:
+///
+/// - objects: every object is stored as record_length integers of element_size bytes each (1, 2, 4
+///   or 8, signed, in the machine's byte order). Read them back with basic_binary_objects.
+/// - ranks: every object is stored as its index in the family (8 bytes). Much smaller when the
+///   objects are long, but reading them back needs the family to unrank (see binary_ranks).
+///
+/// For example,
+///
+/// 	dscr::combinations X(40,10);
+/// 	dscr::export_ranks_if("filtered.bin", X, pred, "combinations", {40,10});
+/// 	...
+/// 	dscr::binary_ranks<dscr::combinations> Y("filtered.bin", X);
+/// 	for (auto& x : Y)
+/// 		f(x);
+///
+/// The header records the name of the family and up to four parameters, so a later stage can check
+/// it is reading what it expects. This is POSIX only, and not included by discreture.hpp.
+////////////////////////////////////////////////////////////
+
+namespace dscr
+{
+enum binary_kind : std::uint32_t
+{
+	binary_objects_kind = 0,
+	binary_ranks_kind = 1
+};
+
+struct binary_header
+{
+	char magic[8];
+	std::uint32_t version;
+	std::uint32_t kind;
+	std::uint32_t element_size; // bytes per integer
+	std::uint32_t record_length; // integers per object (1 for ranks)
+	std::uint64_t count;
+	char family[32];
+	std::int64_t params[4];
+
+	static constexpr const char* expected_magic = "DSCRBIN";
+	static constexpr std::uint32_t current_version = 1;
+
+	std::uint64_t record_size() const
+	{
+		return std::uint64_t(element_size)*record_length;
+	}
+};
+
+static_assert(sizeof(binary_header) == 96, "binary_header must have no padding");
+
+namespace detail
+{
+template <class Int>
+inline void store_int(char* out, long long value)
+{
+	if (value < std::numeric_limits<Int>::min() || value > std::numeric_limits<Int>::max())
+		throw std::out_of_range("dscr::binary_writer: value doesn't fit in element_size bytes");
+	Int v = static_cast<Int>(value);
+	std::memcpy(out, &v, sizeof(Int));
+}
+
+template <class Int>
+inline long long load_int(const char* in)
+{
+	Int v;
+	std::memcpy(&v, in, sizeof(Int));
+	return v;
+}
+
+template <class Int, class Object>
+inline void store_record(char* out, const Object& x)
+{
+	for (auto v : x)
+	{
+		store_int<Int>(out, v);
+		out += sizeof(Int);
+	}
+}
+
+template <class Int, class RAContainerInt>
+inline void load_record(RAContainerInt& x, const char* in)
+{
+	for (auto& v : x)
+	{
+		v = load_int<Int>(in);
+		in += sizeof(Int);
+	}
+}
+} // namespace detail
+
+////////////////////////////////////////////////////////////
+/// \brief Writes objects (or ranks) one by one to a binary file.
+///
+/// The count is filled in by close() (which the destructor calls), so a file whose writer didn't
+/// finish properly is rejected by the readers.
+////////////////////////////////////////////////////////////
+class binary_writer
+{
+public:
+	////////////////////////////////////////////////////////////
+	/// \param kind is either binary_objects_kind or binary_ranks_kind.
+	/// \param family is a name of at most 31 characters, e.g. "combinations".
+	/// \param params are up to 4 parameters of the family, e.g. {n, k}.
+	/// \param element_size is the number of bytes of every integer of an object (1, 2, 4 or 8). Ignored for ranks.
+	////////////////////////////////////////////////////////////
+	binary_writer(const std::string& filename,
+				  binary_kind kind,
+				  const std::string& family,
+				  std::initializer_list<std::int64_t> params,
+				  std::uint32_t element_size = 1) : m_header(), m_buffer(1 << 16)
+	{
+		if (family.size() >= sizeof(m_header.family))
+			throw std::invalid_argument("dscr::binary_writer: family name too long");
+		if (params.size() > 4)
+			throw std::invalid_argument("dscr::binary_writer: at most 4 parameters");
+		if (kind == binary_ranks_kind)
+			element_size = 8;
+		if (element_size != 1 && element_size != 2 && element_size != 4 && element_size != 8)
+			throw std::invalid_argument("dscr::binary_writer: element_size must be 1, 2, 4 or 8");
+
+		std::strcpy(m_header.magic, binary_header::expected_magic);
+		m_header.version = binary_header::current_version;
+		m_header.kind = kind;
+		m_header.element_size = element_size;
+		m_header.record_length = (kind == binary_ranks_kind) ? 1 : 0; // objects: set by the first write
+		std::strcpy(m_header.family, family.c_str());
+		std::copy(params.begin(), params.end(), m_header.params);
+
+		m_file = std::fopen(filename.c_str(), "wb");
+		if (!m_file)
+			throw std::runtime_error("dscr::binary_writer: could not open " + filename);
+
+		write_header();
+	}
+
+	~binary_writer()
+	{
+		try
+		{
+			close();
+		}
+		catch (...)
+		{
+		}
+	}
+
+	binary_writer(const binary_writer&) = delete;
+	binary_writer& operator=(const binary_writer&) = delete;
+
+	////////////////////////////////////////////////////////////
+	/// \brief Appends an object. All objects must have the same size.
+	////////////////////////////////////////////////////////////
+	template <class Object>
+	void write(const Object& x)
+	{
+		if (m_header.kind != binary_objects_kind)
+			throw std::logic_error("dscr::binary_writer: this file stores ranks");
+
+		if (m_header.count == 0 && m_header.record_length == 0)
+			m_header.record_length = x.size();
+		else if (static_cast<std::uint64_t>(x.size()) != m_header.record_length)
+			throw std::invalid_argument("dscr::binary_writer: all objects must have the same size");
+
+		char* out = reserve(m_header.record_size());
+
+		switch (m_header.element_size)
+		{
+		case 1:
+			detail::store_record<std::int8_t>(out, x);
+			break;
+		case 2:
+			detail::store_record<std::int16_t>(out, x);
+			break;
+		case 4:
+			detail::store_record<std::int32_t>(out, x);
+			break;
+		default:
+			detail::store_record<std::int64_t>(out, x);
+			break;
+		}
+
+		m_used += m_header.record_size();
+		++m_header.count;
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief Appends the index of an object.
+	////////////////////////////////////////////////////////////
+	void write_rank(std::uint64_t rank)
+	{
+		if (m_header.kind != binary_ranks_kind)
+			throw std::logic_error("dscr::binary_writer: this file stores objects");
+
+		std::memcpy(reserve(sizeof(rank)), &rank, sizeof(rank));
+		m_used += sizeof(rank);
+		++m_header.count;
+	}
+
+	std::uint64_t count() const { return m_header.count; }
+
+	////////////////////////////////////////////////////////////
+	/// \brief Writes what's left and the final header. Nothing can be written afterwards.
+	////////////////////////////////////////////////////////////
+	void close()
+	{
+		if (!m_file)
+			return;
+
+		bool ok = std::fwrite(m_buffer.data(), 1, m_used, m_file) == m_used;
+		m_used = 0;
+		ok = ok && std::fseek(m_file, 0, SEEK_SET) == 0;
+		ok = ok && std::fwrite(&m_header, sizeof(m_header), 1, m_file) == 1;
+		ok = (std::fclose(m_file) == 0) && ok;
+		m_file = nullptr;
+
+		if (!ok)
+			throw std::runtime_error("dscr::binary_writer: could not finish writing the file");
+	}
+
+private:
+	binary_header m_header;
+	std::FILE* m_file {nullptr};
+	std::vector<char> m_buffer;
+	std::size_t m_used {0};
+
+	char* reserve(std::size_t bytes)
+	{
+		if (m_used + bytes > m_buffer.size())
+		{
+			flush();
+			if (bytes > m_buffer.size())
+				m_buffer.resize(bytes);
+		}
+		return m_buffer.data() + m_used;
+	}
+
+	void flush()
+	{
+		if (m_used > 0 && std::fwrite(m_buffer.data(), 1, m_used, m_file) != m_used)
+			throw std::runtime_error("dscr::binary_writer: write failed");
+		m_used = 0;
+	}
+
+	void write_header()
+	{
+		if (std::fwrite(&m_header, sizeof(m_header), 1, m_file) != 1)
+			throw std::runtime_error("dscr::binary_writer: write failed");
+	}
+}; // end class binary_writer
+
+////////////////////////////////////////////////////////////
+/// \brief Writes every object of X. Returns how many were written.
+////////////////////////////////////////////////////////////
+template <class Container>
+std::uint64_t export_objects(const std::string& filename,
+							 const Container& X,
+							 const std::string& family,
+							 std::initializer_list<std::int64_t> params,
+							 std::uint32_t element_size = 1)
+{
+	binary_writer writer(filename, binary_objects_kind, family, params, element_size);
+	for (const auto& x : X)
+		writer.write(x);
+	writer.close();
+	return writer.count();
+}
+
+////////////////////////////////////////////////////////////
+/// \brief Writes the objects x of X for which pred(x) is true.
+////////////////////////////////////////////////////////////
+template <class Container, class Predicate>
+std::uint64_t export_objects_if(const std::string& filename,
+								const Container& X,
+								Predicate pred,
+								const std::string& family,
+								std::initializer_list<std::int64_t> params,
+								std::uint32_t element_size = 1)
+{
+	binary_writer writer(filename, binary_objects_kind, family, params, element_size);
+	for (const auto& x : X)
+	{
+		if (pred(x))
+			writer.write(x);
+	}
+	writer.close();
+	return writer.count();
+}
+
+////////////////////////////////////////////////////////////
+/// \brief Writes the index (in X) of the objects x of X for which pred(x) is true.
+///
+/// The index is the iterator's ID(), so nothing is ranked. Read it back with binary_ranks.
+////////////////////////////////////////////////////////////
+template <class Container, class Predicate>
+std::uint64_t export_ranks_if(const std::string& filename,
+							  const Container& X,
+							  Predicate pred,
+							  const std::string& family,
+							  std::initializer_list<std::int64_t> params)
+{
+	binary_writer writer(filename, binary_ranks_kind, family, params);
+	for (auto it = X.begin(), last = X.end(); it != last; ++it)
+	{
+		if (pred(*it))
+			writer.write_rank(it.ID());
+	}
+	writer.close();
+	return writer.count();
+}
+
+////////////////////////////////////////////////////////////
+/// \brief A read-only memory mapping of a whole file.
+////////////////////////////////////////////////////////////
+class mapped_file
+{
+public:
+	explicit mapped_file(const std::string& filename)
+	{
+		int fd = ::open(filename.c_str(), O_RDONLY);
+		if (fd < 0)
+			throw std::runtime_error("dscr::mapped_file: could not open " + filename);
+
+		struct stat st;
+		if (::fstat(fd, &st) != 0)
+		{
+			::close(fd);
+			throw std::runtime_error("dscr::mapped_file: could not stat " + filename);
+		}
+
+		m_size = st.st_size;
+		if (m_size > 0)
+		{
+			void* p = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (p == MAP_FAILED)
+			{
+				::close(fd);
+				throw std::runtime_error("dscr::mapped_file: could not map " + filename);
+			}
+			m_data = static_cast<const char*>(p);
+		}
+		::close(fd); // the mapping stays valid
+	}
+
+	~mapped_file()
+	{
+		if (m_data)
+			::munmap(const_cast<char*>(m_data), m_size);
+	}
+
+	mapped_file(const mapped_file&) = delete;
+	mapped_file& operator=(const mapped_file&) = delete;
+
+	const char* data() const { return m_data; }
+	std::size_t size() const { return m_size; }
+
+private:
+	const char* m_data {nullptr};
+	std::size_t m_size {0};
+};
+
+////////////////////////////////////////////////////////////
+/// \brief A writable array of size T's kept in a file, through a shared memory mapping.
+///
+/// If the file doesn't exist (or is empty) it's created, filled with zeros. If it already has
+/// exactly size T's, they are kept, so a table computed in one run can be used in the next. Any
+/// other size is an error. Pages are loaded as they are used and written back by the OS, so the
+/// array can be much bigger than the memory. See rank_map (RankMap.hpp).
+////////////////////////////////////////////////////////////
+template <class T>
+class mapped_array
+{
+public:
+	static_assert(std::is_trivially_copyable<T>::value, "dscr::mapped_array: T must be trivially copyable");
+
+	using value_type = T;
+	using iterator = T*;
+	using const_iterator = const T*;
+
+	mapped_array(const std::string& filename, std::size_t size) : m_size(size)
+	{
+		int fd = ::open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+		if (fd < 0)
+			throw std::runtime_error("dscr::mapped_array: could not open " + filename);
+
+		struct stat st;
+		const std::size_t bytes = size*sizeof(T);
+		if (::fstat(fd, &st) != 0 || (st.st_size != 0 && static_cast<std::size_t>(st.st_size) != bytes))
+		{
+			::close(fd);
+			throw std::runtime_error("dscr::mapped_array: " + filename + " exists and doesn't have " + std::to_string(size) + " values");
+		}
+
+		if (bytes > 0)
+		{
+			void* p = MAP_FAILED;
+			if (::ftruncate(fd, bytes) == 0)
+				p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			if (p == MAP_FAILED)
+			{
+				::close(fd);
+				throw std::runtime_error("dscr::mapped_array: could not map " + filename);
+			}
+			m_data = static_cast<T*>(p);
+		}
+		::close(fd); // the mapping stays valid
+	}
+
+	mapped_array(mapped_array&& other) noexcept : m_data(other.m_data), m_size(other.m_size)
+	{
+		other.m_data = nullptr;
+		other.m_size = 0;
+	}
+
+	mapped_array& operator=(mapped_array&& other) noexcept
+	{
+		std::swap(m_data, other.m_data);
+		std::swap(m_size, other.m_size);
+		return *this;
+	}
+
+	mapped_array(const mapped_array&) = delete;
+	mapped_array& operator=(const mapped_array&) = delete;
+
+	~mapped_array()
+	{
+		if (m_data)
+			::munmap(m_data, m_size*sizeof(T));
+	}
+
+	std::size_t size() const { return m_size; }
+
+	T* data() { return m_data; }
+	const T* data() const { return m_data; }
+
+	T& operator[](std::size_t i) { return m_data[i]; }
+	const T& operator[](std::size_t i) const { return m_data[i]; }
+
+	iterator begin() { return m_data; }
+	iterator end() { return m_data + m_size; }
+	const_iterator begin() const { return m_data; }
+	const_iterator end() const { return m_data + m_size; }
+
+	////////////////////////////////////////////////////////////
+	/// \brief Writes the changes to the file now (the OS does it eventually anyway, or at the latest when unmapping).
+	////////////////////////////////////////////////////////////
+	void sync()
+	{
+		if (m_data && ::msync(m_data, m_size*sizeof(T), MS_SYNC) != 0)
+			throw std::runtime_error("dscr::mapped_array: msync failed");
+	}
+
+private:
+	T* m_data {nullptr};
+	std::size_t m_size {0};
+};
+
+namespace detail
+{
+// Maps the file and checks the header is complete and consistent with the file size.
+class binary_file
+{
+public:
+	binary_file(const std::string& filename, binary_kind kind) : m_file(filename), m_header()
+	{
+		if (m_file.size() < sizeof(binary_header))
+			throw std::runtime_error("dscr: " + filename + " is not a discreture binary file");
+
+		std::memcpy(&m_header, m_file.data(), sizeof(binary_header));
+
+		if (std::strncmp(m_header.magic, binary_header::expected_magic, sizeof(m_header.magic)) != 0 ||
+			m_header.version != binary_header::current_version)
+			throw std::runtime_error("dscr: " + filename + " is not a discreture binary file");
+
+		if (m_header.kind != kind)
+			throw std::runtime_error("dscr: " + filename + (kind == binary_ranks_kind ? " stores objects, not ranks" : " stores ranks, not objects"));
+
+		if (m_file.size() != sizeof(binary_header) + m_header.count*m_header.record_size())
+			throw std::runtime_error("dscr: " + filename + " is truncated (or was not closed properly)");
+	}
+
+	const binary_header& header() const { return m_header; }
+	std::string family() const { return std::string(m_header.family); }
+	std::int64_t param(int i) const { return m_header.params[i]; }
+
+protected:
+	const char* records() const { return m_file.data() + sizeof(binary_header); }
+
+private:
+	mapped_file m_file;
+	binary_header m_header;
+};
+} // namespace detail
+
+////////////////////////////////////////////////////////////
+/// \brief The objects of a file written with binary_objects_kind, as a random access container.
+///
+/// Iterating decodes each record into the iterator (like the other families do), so dereferencing
+/// gives a const object&.
+////////////////////////////////////////////////////////////
+template <class IntType, class RAContainerInt = std::vector<IntType>>
+class basic_binary_objects : public detail::binary_file
+{
+public:
+	using difference_type = long long;
+	using size_type = long long; //yeah, signed.
+	using value_type = RAContainerInt;
+	using object = value_type;
+	class iterator;
+	using const_iterator = iterator;
+
+	explicit basic_binary_objects(const std::string& filename) : binary_file(filename, binary_objects_kind) {}
+
+	size_type size() const { return header().count; }
+
+	////////////////////////////////////////////////////////////
+	/// \brief The m-th object of the file
+	////////////////////////////////////////////////////////////
+	object operator[](size_type m) const
+	{
+		assert(m >= 0 && m < size());
+		object x(header().record_length);
+		decode(x, m);
+		return x;
+	}
+
+	iterator begin() const { return iterator(this, 0); }
+
+	iterator end() const { return iterator(this, size()); }
+
+	class iterator : public boost::iterator_facade<
+													iterator,
+													const object&,
+													boost::random_access_traversal_tag
+													>
+	{
+	public:
+		iterator() {}
+
+		iterator(const basic_binary_objects* parent, size_type id) : m_parent(parent), m_ID(id), m_data(parent->header().record_length)
+		{
+			if (m_ID < m_parent->size())
+				m_parent->decode(m_data, m_ID);
+		}
+
+		size_type ID() const { return m_ID; }
+
+	private:
+		void increment() { advance(1); }
+
+		void decrement() { advance(-1); }
+
+		void advance(difference_type m)
+		{
+			m_ID += m;
+			if (0 <= m_ID && m_ID < m_parent->size())
+				m_parent->decode(m_data, m_ID);
+		}
+
+		const object& dereference() const { return m_data; }
+
+		difference_type distance_to(const iterator& other) const { return other.m_ID - m_ID; }
+
+		bool equal(const iterator& other) const { return m_ID == other.m_ID; }
+
+		const basic_binary_objects* m_parent {nullptr};
+		size_type m_ID {0};
+		object m_data {};
+
+		friend class boost::iterator_core_access;
+	}; // end class iterator
+
+private:
+	void decode(object& x, size_type m) const
+	{
+		const char* in = records() + m*header().record_size();
+
+		switch (header().element_size)
+		{
+		case 1:
+			detail::load_record<std::int8_t>(x, in);
+			break;
+		case 2:
+			detail::load_record<std::int16_t>(x, in);
+			break;
+		case 4:
+			detail::load_record<std::int32_t>(x, in);
+			break;
+		default:
+			detail::load_record<std::int64_t>(x, in);
+			break;
+		}
+	}
+}; // end class basic_binary_objects
+
+using binary_objects = basic_binary_objects<int>;
+
+////////////////////////////////////////////////////////////
+/// \brief The objects of a file written with binary_ranks_kind, unranked with a copy of X.
+///
+/// X must be the family the ranks were taken from (check family() and param() if unsure). The
+/// iterator moves an iterator of X, so consecutive ranks that are close together are reached by
+/// stepping instead of unranking.
+////////////////////////////////////////////////////////////
+template <class Family>
+class binary_ranks : public detail::binary_file
+{
+public:
+	using difference_type = long long;
+	using size_type = long long; //yeah, signed.
+	using value_type = typename Family::value_type;
+	using object = value_type;
+	class iterator;
+	using const_iterator = iterator;
+
+	binary_ranks(const std::string& filename, const Family& X) : binary_file(filename, binary_ranks_kind), m_family(X) {}
+
+	size_type size() const { return header().count; }
+
+	////////////////////////////////////////////////////////////
+	/// \brief The index (in the family) of the m-th object of the file
+	////////////////////////////////////////////////////////////
+	size_type rank(size_type m) const
+	{
+		assert(m >= 0 && m < size());
+		std::uint64_t r;
+		std::memcpy(&r, records() + m*sizeof(r), sizeof(r));
+		return r;
+	}
+
+	object operator[](size_type m) const { return m_family[rank(m)]; }
+
+	const Family& family_container() const { return m_family; }
+
+	iterator begin() const { return iterator(this, 0); }
+
+	iterator end() const { return iterator(this, size()); }
+
+	class iterator : public boost::iterator_facade<
+													iterator,
+													const object&,
+													boost::random_access_traversal_tag
+													>
+	{
+	public:
+		iterator() {}
+
+		iterator(const binary_ranks* parent, size_type id) : m_parent(parent), m_ID(id), m_it(parent->m_family.begin())
+		{
+			seek();
+		}
+
+		size_type ID() const { return m_ID; }
+
+	private:
+		void increment() { advance(1); }
+
+		void decrement() { advance(-1); }
+
+		void advance(difference_type m)
+		{
+			m_ID += m;
+			seek();
+		}
+
+		void seek()
+		{
+			if (0 <= m_ID && m_ID < m_parent->size())
+				m_it += m_parent->rank(m_ID) - m_it.ID();
+		}
+
+		const object& dereference() const { return *m_it; }
+
+		difference_type distance_to(const iterator& other) const { return other.m_ID - m_ID; }
+
+		bool equal(const iterator& other) const { return m_ID == other.m_ID; }
+
+		const binary_ranks* m_parent {nullptr};
+		size_type m_ID {0};
+		typename Family::iterator m_it {};
+
+		friend class boost::iterator_core_access;
+	}; // end class iterator
+
+private:
+	Family m_family;
+}; // end class binary_ranks
+} // namespace dscr
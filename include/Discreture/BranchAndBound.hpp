@@ -0,0 +1,233 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+////////////////////////////////////////////////////////////
+/// \file BranchAndBound.hpp
+/// \brief The search behind basic_combinations_tree::optimize.
+////////////////////////////////////////////////////////////
+
+namespace dscr
+{
+////////////////////////////////////////////////////////////
+/// \brief What optimize returns: the best combinations found (best first) and how much of the tree was searched.
+////////////////////////////////////////////////////////////
+template <class Combination, class Value>
+struct optimization_result
+{
+	std::vector<Combination> best; // sorted by score, best first
+	std::vector<Value> scores; // scores[i] is the score of best[i]
+	long long nodes {0}; // combinations visited, partial or complete
+	long long pruned {0}; // partial ones cut because their bound couldn't beat the incumbent
+	long long leaves {0}; // complete ones, which were scored
+};
+
+namespace detail
+{
+// The m-th best score found by any thread so far. Any thread's own m-th best is a lower bound of it.
+template <class Value>
+class shared_incumbent
+{
+public:
+	bool known() const { return m_known.load(std::memory_order_acquire); }
+
+	Value value() const { return m_value.load(std::memory_order_relaxed); }
+
+	void raise(Value v)
+	{
+		Value current = m_value.load(std::memory_order_relaxed);
+		while (v > current && !m_value.compare_exchange_weak(current, v, std::memory_order_relaxed)) {}
+		m_known.store(true, std::memory_order_release);
+	}
+
+private:
+	std::atomic<Value> m_value {std::numeric_limits<Value>::lowest()};
+	std::atomic<bool> m_known {false};
+};
+
+// Depth first search over the k-subsets of [0,n) with a fixed first element, keeping the m best.
+template <class Combination, class IntType, class Score, class Bound, class Value>
+class branch_and_bound
+{
+public:
+	using candidate = std::pair<Value, Combination>;
+
+	branch_and_bound(IntType n, IntType k, Score& score, Bound& bound, std::size_t m, shared_incumbent<Value>& incumbent) :
+		m_n(n), m_k(k), m_score(score), m_bound(bound), m_m(m), m_incumbent(incumbent), m_comb(), m_best()
+	{
+		m_comb.reserve(k);
+		m_best.reserve(m + 1);
+	}
+
+	void search_from(IntType first)
+	{
+		m_comb.clear();
+		m_comb.push_back(first);
+		visit(first + 1);
+	}
+
+	std::vector<candidate>& best() { return m_best; }
+
+	long long nodes {0};
+	long long pruned {0};
+	long long leaves {0};
+
+private:
+	IntType m_n;
+	IntType m_k;
+	Score& m_score;
+	Bound& m_bound;
+	std::size_t m_m;
+	shared_incumbent<Value>& m_incumbent;
+	Combination m_comb;
+	std::vector<candidate> m_best; // min-heap by score
+
+	static bool worse(const candidate& a, const candidate& b) { return a.first > b.first; }
+
+	bool full() const { return m_best.size() == m_m; }
+
+	// Can a subtree whose completions score at most b still get into the m best?
+	bool promising(Value b) const
+	{
+		if (full() && b <= m_best.front().first)
+			return false;
+		return !m_incumbent.known() || b > m_incumbent.value();
+	}
+
+	void offer(Value s)
+	{
+		if (full())
+		{
+			if (s <= m_best.front().first)
+				return;
+			std::pop_heap(m_best.begin(), m_best.end(), worse);
+			m_best.pop_back();
+		}
+
+		m_best.emplace_back(s, m_comb);
+		std::push_heap(m_best.begin(), m_best.end(), worse);
+
+		if (full())
+			m_incumbent.raise(m_best.front().first);
+	}
+
+	// m_comb is a partial combination whose bound was promising. Its next element is at least start.
+	void visit(IntType start)
+	{
+		++nodes;
+
+		if (m_comb.size() == static_cast<std::size_t>(m_k))
+		{
+			++leaves;
+			offer(m_score(static_cast<const Combination&>(m_comb)));
+			return;
+		}
+
+		if (!promising(m_bound(static_cast<const Combination&>(m_comb))))
+		{
+			++pruned;
+			return;
+		}
+
+		IntType guysleft = m_k - m_comb.size();
+		for (IntType i = start; i < m_n - guysleft + 1; ++i)
+		{
+			m_comb.push_back(i);
+			visit(i + 1);
+			m_comb.pop_back();
+		}
+	}
+};
+
+////////////////////////////////////////////////////////////
+/// \brief Branch and bound over the k-subsets of [0,n). See basic_combinations_tree::optimize.
+///
+/// The subtrees of each first element are handed out to num_threads threads one at a time (the
+/// early ones are the largest), and the threads share the m-th best score found so far.
+////////////////////////////////////////////////////////////
+template <class Combination, class IntType, class Score, class Bound>
+auto optimize_combinations(IntType n, IntType k, Score score, Bound bound, std::size_t m, std::size_t num_threads)
+{
+	using Value = std::decay_t<decltype(score(std::declval<const Combination&>()))>;
+	static_assert(std::is_arithmetic<Value>::value, "optimize: the score must be a number");
+	using search = branch_and_bound<Combination, IntType, Score, Bound, Value>;
+
+	optimization_result<Combination, Value> result;
+
+	if (m == 0 || k < 0 || k > n)
+		return result;
+
+	if (k == 0)
+	{
+		Combination empty;
+		result.scores.push_back(score(static_cast<const Combination&>(empty)));
+		result.best.push_back(empty);
+		result.nodes = result.leaves = 1;
+		return result;
+	}
+
+	num_threads = std::max<std::size_t>(num_threads, 1);
+	shared_incumbent<Value> incumbent;
+
+	// Every thread gets its own copy of score and bound, in case they keep some scratch space.
+	std::vector<Score> scores(num_threads, score);
+	std::vector<Bound> bounds(num_threads, bound);
+	std::vector<search> searches;
+	searches.reserve(num_threads);
+	for (std::size_t t = 0; t < num_threads; ++t)
+		searches.emplace_back(n, k, scores[t], bounds[t], m, incumbent);
+
+	std::atomic<long long> next_first {0};
+	const long long num_first = n - k + 1;
+	auto work = [&next_first, num_first](search& s)
+	{
+		for (long long first = next_first++; first < num_first; first = next_first++)
+			s.search_from(static_cast<IntType>(first));
+	};
+
+	if (num_threads == 1)
+	{
+		work(searches[0]);
+	}
+	else
+	{
+		std::vector<std::thread> threads;
+		threads.reserve(num_threads);
+		for (auto& s : searches)
+			threads.emplace_back([&work, &s]() { work(s); });
+		for (auto& t : threads)
+			t.join();
+	}
+
+	std::vector<typename search::candidate> all;
+	for (auto& s : searches)
+	{
+		result.nodes += s.nodes;
+		result.pruned += s.pruned;
+		result.leaves += s.leaves;
+		std::move(s.best().begin(), s.best().end(), std::back_inserter(all));
+	}
+
+	std::stable_sort(all.begin(), all.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+	if (all.size() > m)
+		all.erase(all.begin() + m, all.end());
+
+	for (auto& c : all)
+	{
+		result.scores.push_back(c.first);
+		result.best.push_back(std::move(c.second));
+	}
+
+	return result;
+}
+} // namespace detail
+} // namespace dscr
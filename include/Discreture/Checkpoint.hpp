@@ -0,0 +1,367 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+////////////////////////////////////////////////////////////
+/// \file Checkpoint.hpp
+/// \brief Saving the state of a long enumeration, and resuming it later from there.
+///
+/// A checkpoint is the rank of the next object to process along with the object itself. That's all
+/// it takes to restore an iterator of any family, in O(size of the object) and without iterating
+/// again from the start: the ones that can unrank jump straight to the rank, and the ones that
+/// can't (partitions and set partitions) rebuild their iterator from the object (see their resume()).
+///
+/// 	dscr::combinations X(64,12);
+/// 	auto save = [](const auto& cp) { dscr::save_checkpoint("sweep.ckpt", cp); };
+///
+/// 	dscr::checkpoint<dscr::combinations::combination> cp; // from the start...
+/// 	if (std::ifstream("sweep.ckpt"))
+/// 		dscr::load_checkpoint("sweep.ckpt", cp); // ...unless we were interrupted
+///
+/// 	dscr::for_each_with_checkpoints(X, cp, f, 1000000, save);
+///
+/// The parallel version splits the work in fixed blocks, one per thread, and its checkpoint records
+/// where each thread is in its own block.
+////////////////////////////////////////////////////////////
+
+namespace dscr
+{
+////////////////////////////////////////////////////////////
+/// \brief Every object of rank less than rank has been processed, and current is the one of that rank.
+///
+/// When rank is the size of the container (or the end of a block) there's nothing left, and current is empty.
+////////////////////////////////////////////////////////////
+template <class Object>
+struct checkpoint
+{
+	long long rank {0};
+	Object current {};
+};
+
+////////////////////////////////////////////////////////////
+/// \brief The state of a parallel_for_each_with_checkpoints: thread i is at positions[i], and stops at rank ends[i].
+////////////////////////////////////////////////////////////
+template <class Object>
+struct parallel_checkpoint
+{
+	std::vector<checkpoint<Object>> positions;
+	std::vector<long long> ends;
+
+	////////////////////////////////////////////////////////////
+	/// \brief How many objects haven't been processed yet.
+	////////////////////////////////////////////////////////////
+	long long remaining() const
+	{
+		long long total = 0;
+		for (std::size_t i = 0; i < positions.size(); ++i)
+			total += ends[i] - positions[i].rank;
+		return total;
+	}
+};
+
+////////////////////////////////////////////////////////////
+/// \brief The checkpoint of a (dereferenceable) iterator: the next object to process is *it.
+////////////////////////////////////////////////////////////
+template <class Iterator>
+auto make_checkpoint(const Iterator& it)
+{
+	return checkpoint<std::decay_t<decltype(*it)>> {static_cast<long long>(it.ID()), *it};
+}
+
+namespace detail
+{
+template <class Container, class Object>
+auto resume(const Container& X, const checkpoint<Object>& cp, std::random_access_iterator_tag)
+{
+	return X.begin() + cp.rank;
+}
+
+template <class Container, class Object>
+auto resume(const Container& X, const checkpoint<Object>& cp, std::forward_iterator_tag)
+{
+	return X.resume(cp.rank, cp.current);
+}
+} // namespace detail
+
+////////////////////////////////////////////////////////////
+/// \brief An iterator of X pointing at the object of cp (or X.end(), if there's nothing left).
+////////////////////////////////////////////////////////////
+template <class Container, class Object>
+auto resume(const Container& X, const checkpoint<Object>& cp)
+{
+	if (cp.rank >= static_cast<long long>(X.size()))
+		return X.end();
+
+	if (cp.rank == 0) // a default constructed checkpoint: the start
+		return X.begin();
+
+	using category = typename std::iterator_traits<decltype(X.begin())>::iterator_category;
+	return detail::resume(X, cp, category());
+}
+
+////////////////////////////////////////////////////////////
+/// \brief Applies f to every object of X from cp on, and calls on_checkpoint(checkpoint) every interval objects.
+///
+/// on_checkpoint is also called once at the end, with rank X.size(), so a saved checkpoint always says whether the work is done.
+////////////////////////////////////////////////////////////
+template <class Container, class Object, class Function, class OnCheckpoint>
+void for_each_with_checkpoints(const Container& X, const checkpoint<Object>& cp, Function f, long long interval, OnCheckpoint on_checkpoint)
+{
+	const long long size = X.size();
+	interval = std::max(interval, 1LL);
+
+	auto it = resume(X, cp);
+	long long rank = cp.rank;
+	long long since_last = 0;
+
+	for ( ; rank < size; ++rank, ++it)
+	{
+		if (since_last == interval)
+		{
+			on_checkpoint(make_checkpoint(it));
+			since_last = 0;
+		}
+
+		f(*it);
+		++since_last;
+	}
+
+	on_checkpoint(checkpoint<Object> {size, Object()});
+}
+
+template <class Container, class Function, class OnCheckpoint>
+void for_each_with_checkpoints(const Container& X, Function f, long long interval, OnCheckpoint on_checkpoint)
+{
+	for_each_with_checkpoints(X, checkpoint<typename Container::value_type>(), f, interval, on_checkpoint);
+}
+
+////////////////////////////////////////////////////////////
+/// \brief The checkpoint of a parallel run that hasn't started: X split in num_processors blocks.
+///
+/// Needs random access iterators, like parallel_for_each. The blocks never change afterwards, so a run
+/// must be resumed with as many threads as it started with (but each one may be on any machine).
+////////////////////////////////////////////////////////////
+template <class Container>
+parallel_checkpoint<typename Container::value_type> make_parallel_checkpoint(const Container& X, std::size_t num_processors)
+{
+	num_processors = std::max<std::size_t>(num_processors, 1);
+	const long long size = X.size();
+
+	parallel_checkpoint<typename Container::value_type> cp;
+	for (std::size_t i = 0; i < num_processors; ++i)
+	{
+		long long begin = (size*i)/num_processors;
+		long long end = (size*(i + 1))/num_processors;
+
+		cp.positions.push_back({begin, {}});
+		if (begin < end)
+			cp.positions.back().current = *(X.begin() + begin);
+		cp.ends.push_back(end);
+	}
+
+	return cp;
+}
+
+////////////////////////////////////////////////////////////
+/// \brief Like parallel_for_each, but every thread records its progress every interval objects.
+///
+/// Each time it does, on_checkpoint(cp) is called with the state of all threads, from that thread but
+/// never from two threads at once. Every thread starts from cp.positions[i], so this also resumes
+/// a run from a saved parallel_checkpoint, even of a family without random access (partitions, ...).
+/// on_checkpoint is called once more at the end, when cp.remaining() is 0.
+////////////////////////////////////////////////////////////
+template <class Container, class Object, class Function, class OnCheckpoint>
+void parallel_for_each_with_checkpoints(const Container& X, parallel_checkpoint<Object> cp, Function f, long long interval, OnCheckpoint on_checkpoint)
+{
+	interval = std::max(interval, 1LL);
+	std::mutex mtx;
+
+	auto work = [&](std::size_t i)
+	{
+		auto it = resume(X, cp.positions[i]);
+		long long rank = cp.positions[i].rank;
+		const long long end = cp.ends[i];
+		long long since_last = 0;
+
+		for ( ; rank < end; ++rank, ++it)
+		{
+			if (since_last == interval)
+			{
+				auto position = make_checkpoint(it);
+				std::lock_guard<std::mutex> lock(mtx);
+				cp.positions[i] = std::move(position);
+				on_checkpoint(static_cast<const parallel_checkpoint<Object>&>(cp));
+				since_last = 0;
+			}
+
+			f(*it);
+			++since_last;
+		}
+
+		std::lock_guard<std::mutex> lock(mtx);
+		cp.positions[i] = checkpoint<Object> {end, Object()};
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(cp.positions.size());
+	for (std::size_t i = 0; i < cp.positions.size(); ++i)
+		threads.emplace_back(work, i);
+	for (auto& t : threads)
+		t.join();
+
+	on_checkpoint(static_cast<const parallel_checkpoint<Object>&>(cp));
+}
+
+template <class Container, class Function, class OnCheckpoint>
+void parallel_for_each_with_checkpoints(const Container& X, Function f, std::size_t num_processors, long long interval, OnCheckpoint on_checkpoint)
+{
+	parallel_for_each_with_checkpoints(X, make_parallel_checkpoint(X, num_processors), f, interval, on_checkpoint);
+}
+
+namespace detail
+{
+// Objects are written as numbers separated by spaces. A container is its size followed by its elements.
+template <class T>
+std::enable_if_t<std::is_arithmetic<T>::value> write_object(std::ostream& os, const T& x)
+{
+	os << ' ' << +x;
+}
+
+template <class Container>
+std::enable_if_t<!std::is_arithmetic<Container>::value> write_object(std::ostream& os, const Container& x)
+{
+	os << ' ' << x.size();
+	for (auto& y : x)
+		write_object(os, y);
+}
+
+template <class T>
+std::enable_if_t<std::is_arithmetic<T>::value> read_object(std::istream& is, T& x)
+{
+	long long y;
+	is >> y;
+	x = static_cast<T>(y);
+}
+
+template <class Container>
+std::enable_if_t<!std::is_arithmetic<Container>::value> read_object(std::istream& is, Container& x)
+{
+	std::size_t size = 0;
+	if (!(is >> size))
+		return;
+	x.resize(size);
+	for (auto& y : x)
+		read_object(is, y);
+}
+
+inline void expect(std::istream& is, const std::string& word)
+{
+	std::string got;
+	if (!(is >> got) || got != word)
+		throw std::runtime_error("checkpoint: expected \"" + word + "\", found \"" + got + "\"");
+}
+} // namespace detail
+
+////////////////////////////////////////////////////////////
+/// \brief Writes cp as one line of text: "checkpoint rank object".
+////////////////////////////////////////////////////////////
+template <class Object>
+std::ostream& write_checkpoint(std::ostream& os, const checkpoint<Object>& cp)
+{
+	os << "checkpoint " << cp.rank;
+	detail::write_object(os, cp.current);
+	return os << '\n';
+}
+
+////////////////////////////////////////////////////////////
+/// \brief Writes cp as a line "parallel_checkpoint blocks" followed by a line "end checkpoint rank object" for each thread.
+////////////////////////////////////////////////////////////
+template <class Object>
+std::ostream& write_checkpoint(std::ostream& os, const parallel_checkpoint<Object>& cp)
+{
+	os << "parallel_checkpoint " << cp.positions.size() << '\n';
+	for (std::size_t i = 0; i < cp.positions.size(); ++i)
+	{
+		os << cp.ends[i] << ' ';
+		write_checkpoint(os, cp.positions[i]);
+	}
+	return os;
+}
+
+////////////////////////////////////////////////////////////
+/// \brief Reads what write_checkpoint wrote. Throws std::runtime_error if it isn't a checkpoint.
+////////////////////////////////////////////////////////////
+template <class Object>
+std::istream& read_checkpoint(std::istream& is, checkpoint<Object>& cp)
+{
+	detail::expect(is, "checkpoint");
+	if (!(is >> cp.rank))
+		throw std::runtime_error("checkpoint: missing rank");
+	detail::read_object(is, cp.current);
+	if (!is)
+		throw std::runtime_error("checkpoint: truncated object");
+	return is;
+}
+
+template <class Object>
+std::istream& read_checkpoint(std::istream& is, parallel_checkpoint<Object>& cp)
+{
+	detail::expect(is, "parallel_checkpoint");
+	std::size_t blocks = 0;
+	if (!(is >> blocks))
+		throw std::runtime_error("checkpoint: missing number of blocks");
+
+	cp.positions.assign(blocks, {});
+	cp.ends.assign(blocks, 0);
+	for (std::size_t i = 0; i < blocks; ++i)
+	{
+		if (!(is >> cp.ends[i]))
+			throw std::runtime_error("checkpoint: missing end of block");
+		read_checkpoint(is, cp.positions[i]);
+	}
+	return is;
+}
+
+////////////////////////////////////////////////////////////
+/// \brief Writes cp to filename. It's first written to filename.tmp and then renamed, so an interruption never leaves a broken checkpoint behind.
+////////////////////////////////////////////////////////////
+template <class Checkpoint>
+void save_checkpoint(const std::string& filename, const Checkpoint& cp)
+{
+	const std::string temp = filename + ".tmp";
+	{
+		std::ofstream file(temp);
+		if (!file)
+			throw std::runtime_error("save_checkpoint: can't write " + temp);
+		write_checkpoint(file, cp);
+		file.flush();
+		if (!file)
+			throw std::runtime_error("save_checkpoint: can't write " + temp);
+	}
+
+	if (std::rename(temp.c_str(), filename.c_str()) != 0)
+		throw std::runtime_error("save_checkpoint: can't rename " + temp + " to " + filename);
+}
+
+////////////////////////////////////////////////////////////
+/// \brief Reads a checkpoint written by save_checkpoint.
+////////////////////////////////////////////////////////////
+template <class Checkpoint>
+void load_checkpoint(const std::string& filename, Checkpoint& cp)
+{
+	std::ifstream file(filename);
+	if (!file)
+		throw std::runtime_error("load_checkpoint: can't open " + filename);
+	read_checkpoint(file, cp);
+}
+} // namespace dscr
@@ -11,6 +11,9 @@
 #include "detail_combinations_bf.hpp" //Horrible. Do NOT read. Please. But I can't find another way. Sorry about that. If you think you can do better, please, tell me about it.
 #include "NaturalNumber.hpp"
 #include "CompoundContainer.hpp"
+#include "PartialPredicate.hpp"
+#include "Instrumentation.hpp"
+#include "Subrange.hpp"
 
 namespace dscr
 {
@@ -202,7 +205,13 @@ public:
 	{
 		IntType k = data.size();
 		
-		size_type upper = 68; //this is the biggest for which binomial is still well defined. Hopefully it's enough for most use cases.
+		using wide = typename detail::wider<size_type>::type;
+		const size_type max_upper = 68; //this is the biggest for which binomial is still well defined. Hopefully it's enough for most use cases.
+		
+		// Gallop to the first upper bound with binomial(upper,k) > m, so the search (and binomial's table) stays as small as n.
+		size_type upper = k;
+		while (k > 1 && upper < max_upper && binomial<wide>(upper,k) <= m)
+			upper = std::min(2*upper, max_upper);
 		
 		for (IntType r = k; r > 1; --r)
 		{
@@ -210,9 +219,10 @@ public:
 			
 			big_number_range NR(r,upper);
 			
+			// binomial(x,r) might not fit in size_type near the top of the range, but then it's certainly bigger than m.
 			t = NR.partition_point([m,r](auto x)
 			{
-				return binomial<size_type>(x,r) <= m;
+				return binomial<wide>(x,r) <= m;
 			}) - 1;
 			data[r - 1] = t;
 			upper = t;
@@ -322,6 +332,7 @@ public:
 		assert(m >= 0 && m < size());
 		combination comb(m_k);
 		construct_combination(comb,m);
+		instrument(instrumented::combinations, instrumented::unrank);
 		return comb;
 	}
 	
@@ -336,6 +347,26 @@ public:
 		return iterator(comb);
 	}
 
+	////////////////////////////////////////////////////////////
+	/// \brief The combinations of ranks [first, last) (see Subrange.hpp).
+	////////////////////////////////////////////////////////////
+	subrange<iterator> range(size_type first, size_type last) const
+	{
+		return make_subrange(*this, first, last);
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief The i-th of num_shards consecutive slices of the combinations, of (almost) equal sizes.
+	///
+	/// For splitting the work among processes or machines: the shards of i = 0, 1, ..., num_shards-1
+	/// are disjoint and cover everything, and each one unranks only once, at its start.
+	////////////////////////////////////////////////////////////
+	subrange<iterator> shard(size_type i, size_type num_shards) const
+	{
+		auto bounds = shard_bounds(size(), i, num_shards);
+		return range(bounds.first, bounds.second);
+	}
+
 	reverse_iterator rbegin() const
 	{
 		return reverse_iterator(m_n,m_k);
@@ -381,6 +412,7 @@ public:
 
 		void reset(IntType n, IntType k)
 		{
+			instrument(instrumented::combinations, instrumented::reset);
 			m_ID = 0;
 			m_hint = k;
 			m_last = k-1;
@@ -405,6 +437,7 @@ public:
 		
 		void increment()
 		{
+			instrument(instrumented::combinations, instrumented::step);
 			next_combination(m_data,m_hint,m_last);
 			++m_ID;
 		}
@@ -444,11 +477,13 @@ public:
 					++n;
 				}
 
+				return;
 			}
 
 			// If n is large, then it's better to just construct it from scratch.
 			m_ID += n;
 			construct_combination(m_data, m_ID);
+			instrument(instrumented::combinations, instrumented::unrank);
 			m_hint = 0;
 		}
 		
@@ -462,6 +497,7 @@ public:
 			if (m_ID == 0)
 				return;
 
+			instrument(instrumented::combinations, instrumented::step);
 			--m_ID;
 			m_hint = 0;
 
@@ -504,6 +540,7 @@ public:
 
 		void reset(IntType n, IntType k)
 		{
+			instrument(instrumented::combinations, instrumented::reset);
 			m_n = n;
 			m_ID = 0;
 			m_last = k-1;
@@ -526,6 +563,7 @@ public:
 		
 		void increment()
 		{
+			instrument(instrumented::combinations, instrumented::step);
 			++m_ID;
 
 			prev_combination(m_data,m_last);
@@ -535,6 +573,7 @@ public:
 		{
 			assert(m_ID != 0);
 
+			instrument(instrumented::combinations, instrumented::step);
 			--m_ID;
 
 			next_combination(m_data);
@@ -581,6 +620,7 @@ public:
 			auto num = binomial<size_type>(m_n, m_data.size()) - m_ID - 1;
 			// If n is large, then it's better to just construct it from scratch.
 			construct_combination(m_data, num);
+			instrument(instrumented::combinations, instrumented::unrank);
 		}
 
 		bool equal(const reverse_iterator& it) const
@@ -635,7 +675,7 @@ public:
 		combination A;
 		A.reserve(m_k);
 
-		while (DFSUtil(A, pred))
+		while (detail::DFSUtil(A, pred, m_n, m_k))
 		{
 			if (A.size() == static_cast<size_t>(m_k))
 				return get_iterator(A);
@@ -720,6 +760,9 @@ public:
 	template <class Func>
 	void for_each(Func f) const
 	{
+		if (m_k < 20)
+			instrument(instrumented::combinations, instrumented::step, size());
+
 		//I'm really sorry about this. I don't know how to improve it. If you do, by all means, tell me about it.
 		switch (m_k)
 		{
@@ -817,69 +860,6 @@ private:
 	IntType m_n;
 	IntType m_k;
 	size_type m_size;
-
-	template <class P>
-	bool augment(combination& comb, P pred, IntType start = 0)
-	{
-		if (comb.empty())
-		{
-			if (start < m_n - m_k + 1)
-			{
-				comb.push_back(start);
-				return true;
-			}
-			else
-			{
-				return false;
-			}
-		}
-
-		auto last = comb.back();
-		auto guysleft = m_k - comb.size();
-
-		start = std::max(static_cast<IntType>(last + 1), start);
-
-		for (size_t i = start; i < m_n - guysleft + 1; ++i)
-		{
-			comb.push_back(i);
-
-			if (pred(comb))
-				return true;
-
-			comb.pop_back();
-		}
-
-		return false;
-	}
-
-	template <class P>
-	bool DFSUtil(combination& comb, P pred)
-	{
-// 			auto currsize = comb.size();
-
-		if (comb.size() < static_cast<size_t>(m_k))
-		{
-			if (augment(comb, pred))
-				return true;
-		}
-
-		auto last = comb.back();
-
-		// If it can't be augmented, be it because size is already k or else, we have to start backtracking
-		while (!comb.empty())
-		{
-			last = comb.back();
-			comb.pop_back();
-
-			if (augment(comb, pred, last + 1))
-				return true;
-		}
-
-		return false;
-	}
-
-	
-	
 }; // end class basic_combinations
 
 using combinations = basic_combinations<int>;
@@ -7,6 +7,10 @@
 #include "detail_combinations_tree_bf.hpp"
 #include "CombinationsTreePrunned.hpp"
 #include "CompoundContainer.hpp"
+#include "PartialPredicate.hpp"
+#include "BranchAndBound.hpp"
+#include "Instrumentation.hpp"
+#include "Subrange.hpp"
 #include <numeric>
 #include <algorithm>
 
@@ -112,7 +116,8 @@ public:
             // i <= n-t-1 <= n-r implies that the range is this
             big_number_range N(r,n-i);
             auto t = N.partition_point([m,r](auto t) {
-                return binomial<size_type>(t, r) <= m;
+                using wide = typename detail::wider<size_type>::type;
+                return binomial<wide>(t, r) <= m;
             })-1;
 
             data[i] = n - t - 1;
@@ -225,6 +230,7 @@ public:
         assert(m >= 0 && m < size());
         combination comb(m_k);
         construct_combination(comb,m,m_n);
+        instrument(instrumented::combinations_tree, instrumented::unrank);
         return comb;
     }
 
@@ -238,6 +244,26 @@ public:
         return iterator(comb,m_n);
     }
 
+    ////////////////////////////////////////////////////////////
+    /// \brief The combinations of ranks [first, last) (see Subrange.hpp).
+    ////////////////////////////////////////////////////////////
+    subrange<iterator> range(size_type first, size_type last) const
+    {
+        return make_subrange(*this, first, last);
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// \brief The i-th of num_shards consecutive slices of the combinations, of (almost) equal sizes.
+    ///
+    /// For splitting the work among processes or machines: the shards of i = 0, 1, ..., num_shards-1
+    /// are disjoint and cover everything, and each one unranks only once, at its start.
+    ////////////////////////////////////////////////////////////
+    subrange<iterator> shard(size_type i, size_type num_shards) const
+    {
+        auto bounds = shard_bounds(size(), i, num_shards);
+        return range(bounds.first, bounds.second);
+    }
+
     ////////////////////////////////////////////////////////////
     /// \brief Random access iterator class. It's much more efficient as a bidirectional iterator than purely random access.
     ////////////////////////////////////////////////////////////
@@ -286,6 +312,7 @@ public:
         //prefix
         void increment()
         {
+            instrument(instrumented::combinations_tree, instrumented::step);
             next_combination(m_data, m_n, m_k, m_s);
             ++m_ID;
         }
@@ -295,6 +322,7 @@ public:
             if (m_ID == 0)
                 return;
 
+            instrument(instrumented::combinations_tree, instrumented::step);
             --m_ID;
 
             prev_combination(m_data, m_n);
@@ -337,6 +365,7 @@ public:
             // If n is large, then it's better to just construct it from scratch.
             m_ID += n;
             construct_combination(m_data, m_ID, m_n);
+            instrument(instrumented::combinations_tree, instrumented::unrank);
         }
 
         difference_type distance_to(const iterator& other) const
@@ -390,6 +419,7 @@ public:
 
         void reset(IntType n, IntType r)
         {
+            instrument(instrumented::combinations_tree, instrumented::reset);
             m_n = n;
             m_ID = 0;
             m_data = basic_number_range<IntType>(n - r, n);
@@ -399,6 +429,7 @@ public:
 
         void increment()
         {
+            instrument(instrumented::combinations_tree, instrumented::step);
             ++m_ID;
 
             prev_combination(m_data, m_n);
@@ -408,6 +439,7 @@ public:
         {
             assert(m_ID != 0);
 
+            instrument(instrumented::combinations_tree, instrumented::step);
             --m_ID;
 
             next_combination(m_data, m_n);
@@ -449,6 +481,7 @@ public:
             auto num = binomial<size_type>(m_n, m_data.size()) - m_ID - 1;
             // If n is large, then it's better to just construct it from scratch.
             construct_combination(m_data, num, m_n);
+            instrument(instrumented::combinations_tree, instrumented::unrank);
 
         }
 
@@ -512,7 +545,7 @@ public:
         combination A;
         A.reserve(m_k);
 
-        while (DFSUtil(A, pred))
+        while (detail::DFSUtil(A, pred, m_n, m_k))
         {
             if (A.size() == static_cast<size_t>(m_k))
                 return get_iterator(A);
@@ -586,9 +619,53 @@ public:
         return basic_combinations_tree_prunned<IntType, PartialPredicate, RAContainerInt>(m_n, m_k, pred);
     }
 
+    ///////////////////////////////////////////////
+    /// \brief Finds the m combinations with the largest score, by branch and bound.
+    ///
+    /// Instead of scoring every combination, the search goes down the same tree as find_all and
+    /// skips every partial combination whose bound can't beat the m-th best score found so far.
+    ///
+    /// # Example (the 3 heaviest combinations of 4 distinct items, with weights w):
+    ///
+    /// 	auto score = [&w](const auto& comb)
+    /// 	{
+    /// 		double s = 0;
+    /// 		for (auto x : comb) s += w[x];
+    /// 		return s;
+    /// 	};
+    /// 	auto bound = [&](const auto& comb)
+    /// 	{
+    /// 		// whatever comes next is at most the largest weight after comb.back()
+    /// 		return score(comb) + (4 - comb.size())*max_weight_after[comb.back()];
+    /// 	};
+    /// 	auto result = combinations_tree(w.size(), 4).optimize(score, bound, 3);
+    /// 	// result.best[0] is the heaviest, result.scores[0] its weight.
+    ///
+    /// \param score takes a combination of size k and returns a number (larger is better).
+    /// \param bound takes a partial combination (of size between 1 and k-1) and returns an upper
+    /// bound of the score of every combination that starts with it. If it's not really an upper
+    /// bound, the result can miss the best combinations.
+    /// \param m is how many combinations are wanted.
+    /// \param num_threads if more than 1, the subtrees of each first element are searched in
+    /// parallel, and the threads share the m-th best score (atomically) to prune each other's subtrees.
+    /// Every thread uses its own copy of score and bound.
+    ///
+    /// \return an optimization_result, with the best combinations (best first, and fewer than m if
+    /// there aren't m combinations), their scores, and how many nodes were visited and pruned.
+    /// Among combinations with the same score, which ones are returned is unspecified.
+    /////////////////////////////////////////////
+    template <class Score, class Bound>
+    auto optimize(Score score, Bound bound, size_t m = 1, size_t num_threads = 1) const
+    {
+        return detail::optimize_combinations<combination>(m_n, m_k, score, bound, m, num_threads);
+    }
+
     template <class Func>
     void for_each(Func f) const
     {
+        if (m_k < 19)
+            instrument(instrumented::combinations_tree, instrumented::step, size());
+
         //I'm really sorry about this. I don't know how to improve the readability without sacrificing speed. If you do, by all means, tell me about it.
         switch (m_k)
         {
@@ -682,68 +759,6 @@ private:
     IntType m_n;
     IntType m_k;
     size_type m_size;
-
-private:
-    template <class P>
-    bool augment(combination& comb, P pred, IntType start = 0)
-    {
-        if (comb.empty())
-        {
-            if (start < m_n - m_k + 1)
-            {
-                comb.push_back(start);
-                return true;
-            }
-            else
-            {
-                return false;
-            }
-        }
-
-        auto last = comb.back();
-        auto guysleft = m_k - comb.size();
-
-        start = std::max(static_cast<IntType>(last + 1), start);
-
-        for (size_t i = start; i < m_n - guysleft + 1; ++i)
-        {
-            comb.push_back(i);
-
-            if (pred(comb))
-                return true;
-
-            comb.pop_back();
-        }
-
-        return false;
-    }
-
-    template <class P>
-    bool DFSUtil(combination& comb, P pred)
-    {
-// 			auto currsize = comb.size();
-
-        if (comb.size() < static_cast<size_t>(m_k))
-        {
-            if (augment(comb, pred))
-                return true;
-        }
-
-        auto last = comb.back();
-
-        // If it can't be augmented, be it because size is already k or else, we have to start backtracking
-        while (!comb.empty())
-        {
-            last = comb.back();
-            comb.pop_back();
-
-            if (augment(comb, pred, last + 1))
-                return true;
-        }
-
-        return false;
-    }
-
 }; // end class basic_combinations_tree
 
 using combinations_tree = basic_combinations_tree<int>;
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "CombinationsTree.hpp"
+#include "Instrumentation.hpp"
+#include "PartialPredicate.hpp"
 
 namespace dscr
 {
@@ -57,7 +59,7 @@ public:
 		{
 			m_data.reserve(m_k);
 
-			while (DFSUtil(m_data, m_pred, m_n, m_k))
+			while (detail::DFSUtil(m_data, m_pred, m_n, m_k))
 			{
 				if (m_data.size() == static_cast<size_t>(m_k))
 				{
@@ -77,8 +79,9 @@ public:
 		//prefix
 		void increment()
 		{
+			instrument(instrumented::combinations_tree_prunned, instrumented::step);
 // 				cout << "size of pred: " << sizeof(m_pred) << endl;
-			while (DFSUtil(m_data, m_pred, m_n, m_k))
+			while (detail::DFSUtil(m_data, m_pred, m_n, m_k))
 			{
 				if (m_data.size() == static_cast<size_t>(m_k))
 					return;
@@ -133,64 +136,6 @@ private:
 	iterator m_begin;
 	iterator m_end;
 	Predicate m_pred;
-
-	static bool augment(combination& comb, Predicate pred, IntType m_n, IntType m_k, IntType start = 0)
-	{
-		if (comb.empty())
-		{
-			if (start < m_n - m_k + 1)
-			{
-				comb.push_back(start);
-				return true;
-			}
-			else
-			{
-				return false;
-			}
-		}
-
-		auto last = comb.back();
-		auto guysleft = m_k - comb.size();
-
-		start = std::max(static_cast<IntType>(last + 1), start);
-
-		for (size_t i = start; i < m_n - guysleft + 1; ++i)
-		{
-			comb.push_back(i);
-
-			if (pred(comb))
-				return true;
-
-			comb.pop_back();
-		}
-
-		return false;
-	}
-
-	static bool DFSUtil(combination& comb, Predicate pred, IntType m_n, IntType m_k)
-	{
-// 			cout << "n,k = " << m_n << " " << m_k << endl;
-		if (comb.size() < static_cast<size_t>(m_k))
-		{
-			if (augment(comb, pred, m_n, m_k))
-				return true;
-		}
-
-		auto last = comb.back();
-
-		// If it can't be augmented, be it because size is already k or else, we have to start backtracking
-		while (!comb.empty())
-		{
-			last = comb.back();
-			comb.pop_back();
-
-			if (augment(comb, pred, m_n, m_k, last + 1))
-				return true;
-		}
-
-		return false;
-	}
-
 }; // end class basic_combinations_tree_prunned
 
 // 	using combinations_tree_prunned = basic_combinations_tree_prunned<int>;
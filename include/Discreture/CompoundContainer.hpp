@@ -1,11 +1,25 @@
 #pragma once
 #include "Arrangement.hpp"
 #include "VectorHelpers.hpp"
-#include <unordered_map>
+#include <iterator>
+#include <type_traits>
 
 namespace dscr
 {
 
+//////////////////////////////////////////////////////////////
+/// \brief A container of arrangements: the i-th element is make_arrangement(objects, Indices[i]).
+///
+/// Dereferencing an iterator (as a range for does) yields a view (value_type) of the index
+/// iterator's current element, so it costs the same as iterating Indices. The view points into
+/// the iterator, so it must not outlive it. Everything that dereferences an iterator that is about
+/// to disappear returns an arrangement that owns its indices (owning_value_type) instead:
+/// container[i], it[n], *(it + n), *it++ and std::reverse_iterator (whose reference is
+/// owning_value_type). it-> copies the indices too.
+///
+/// Like std::vector<bool>::iterator, the iterator is random access even though its reference
+/// isn't a real reference.
+//////////////////////////////////////////////////////////////
 template < 	class Container,
 			class IndexContainerOfContainers>
 class compound_container
@@ -16,6 +30,7 @@ public:
 	using indices = typename IndexContainerOfContainers::value_type;
 	using index = typename indices::value_type;
 	using value_type = arrangement<Container,indices>;
+	using owning_value_type = arrangement<Container,indices,true>;
 	class iterator;
 	using const_iterator = iterator;
 public:
@@ -41,28 +56,82 @@ public:
 		return iterator(m_container,m_indices.end());
 	}
 	
-	value_type operator[](size_type i) const
+	owning_value_type operator[](size_type i) const
 	{
-		auto it = m_cache.find(i);
-		if (it == m_cache.end())
-		{
-			it = m_cache.insert({i,m_indices[i]}).first;
-		}
-		return make_arrangement(m_container,it->second);
+		return owning_value_type(m_container,m_indices[i]);
+	}
+	
+	//////////////////////////////////////////////////////////////
+	/// \brief Materializes every element in [first, last) consecutively into out. See dscr::gather_many.
+	/// \return the position in out after the last element written.
+	//////////////////////////////////////////////////////////////
+	template <class OutputIt>
+	OutputIt gather_many(const iterator& first, const iterator& last, OutputIt out) const
+	{
+		return dscr::gather_many(m_container, first.get_index_iterator(), last.get_index_iterator(), out);
+	}
+	
+	//////////////////////////////////////////////////////////////
+	/// \brief Materializes the elements first, first+1, ..., first+count-1 consecutively into out.
+	//////////////////////////////////////////////////////////////
+	template <class OutputIt>
+	OutputIt gather_many(size_type first, size_type count, OutputIt out) const
+	{
+		auto it = begin() + first;
+		return gather_many(it, it + count, out);
 	}
 	
 	class iterator : public boost::iterator_facade< iterator,
 													value_type,
 													boost::random_access_traversal_tag,
-													value_type>
+													owning_value_type>
 	{
 	public:
 		using indexcontainer_iter = typename IndexContainerOfContainers::const_iterator;
+		using iterator_category = std::random_access_iterator_tag;
+		static_assert(std::is_reference<typename std::iterator_traits<indexcontainer_iter>::reference>::value, 
+					  "compound_container needs an index container whose iterators dereference to references");
+		
 		iterator() {}
 		iterator (const Container& objects, const indexcontainer_iter& iiter) : m_container(&objects), 
 																			m_index_container_iter(iiter) 
 		{}
 		
+		// A view into this iterator, without copying the indices.
+		value_type operator*() const &
+		{
+			return value_type(*m_container,*m_index_container_iter);
+		}
+		
+		// This iterator is a temporary, so the indices are copied.
+		owning_value_type operator*() const &&
+		{
+			return dereference();
+		}
+		
+		owning_value_type operator[](difference_type n) const
+		{
+			return *(*this + n);
+		}
+		
+		using boost::iterator_facade<iterator, value_type, boost::random_access_traversal_tag, owning_value_type>::operator++;
+		using boost::iterator_facade<iterator, value_type, boost::random_access_traversal_tag, owning_value_type>::operator--;
+		
+		// Returns the old iterator itself (boost returns a proxy that would hold a view into this one).
+		iterator operator++(int)
+		{
+			iterator old = *this;
+			++*this;
+			return old;
+		}
+		
+		iterator operator--(int)
+		{
+			iterator old = *this;
+			--*this;
+			return old;
+		}
+		
 	private:
 		void increment()
 		{
@@ -84,9 +153,9 @@ public:
 			return m_index_container_iter == other.m_index_container_iter;
 		}
 		
-		value_type dereference() const
+		owning_value_type dereference() const
 		{
-			return make_arrangement(*m_container,*m_index_container_iter);
+			return owning_value_type(*m_container,*m_index_container_iter);
 		}
 		
 		difference_type distance_to(const iterator& other) const
@@ -108,7 +177,6 @@ public:
 private:
 	const Container& m_container;
 	IndexContainerOfContainers m_indices;
-	mutable std::unordered_map<size_type, typename IndexContainerOfContainers::value_type> m_cache;
 };
 
 template < 	class Container,
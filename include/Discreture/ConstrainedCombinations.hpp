@@ -0,0 +1,329 @@
+#pragma once
+
+#include <cassert>
+#include <map>
+#include <random>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "CombinationsTreePrunned.hpp"
+#include "Misc.hpp"
+#include "PartialPredicate.hpp"
+#include "Probability.hpp"
+
+////////////////////////////////////////////////////////////
+/// \file ConstrainedCombinations.hpp
+/// \brief Counting, unranking and uniform sampling of the k-subsets of [0,n) accepted by a state machine.
+///
+/// find_all prunes the search tree with a predicate, but it still has to walk every surviving
+/// combination to know how many there are. When the predicate only depends on a small state that
+/// is updated element by element (in increasing order), the combinations can be counted without
+/// listing them: the number of ways to complete a partial combination only depends on its size,
+/// its last element and its state, so it is memoized on those three. With the counts, the r-th
+/// combination (in the order of find_all) is built directly, and a uniform random one is the r-th
+/// for a uniform random r.
+///
+/// The machine is an object with
+///
+/// 		using state_type = ...;                                  // copyable, with operator<
+/// 		state_type initial() const;                              // the state of the empty combination
+/// 		state_type state(const state_type& prev, int x) const;   // the state after appending x
+/// 		bool accept(const state_type& s) const;                  // is a complete combination in state s accepted?
+/// 		bool viable(const state_type& s) const;                  // optional: false prunes every combination with this prefix
+///
+/// For example, the 8-subsets of [0,40) that add up to exactly 150:
+///
+/// 		struct sum_is_150
+/// 		{
+/// 			using state_type = int;
+/// 			int initial() const { return 0; }
+/// 			int state(int sum, int x) const { return sum + x; }
+/// 			bool viable(int sum) const { return sum <= 150; }
+/// 			bool accept(int sum) const { return sum == 150; }
+/// 		};
+/// 		dscr::constrained_combinations<sum_is_150> X(40,8);
+/// 		std::cout << X.size() << std::endl; // without enumerating any of them
+/// 		auto x = X.random(); // uniformly among all of them
+/// 		auto y = X[12345]; // the same one as the 12345th of X.find_all()
+////////////////////////////////////////////////////////////
+
+namespace dscr
+{
+////////////////////////////////////////////////////////////
+/// \brief true if the machine M has viable(state).
+////////////////////////////////////////////////////////////
+template <class M, class = void>
+struct has_viable : std::false_type {};
+
+template <class M>
+struct has_viable<M, detail::void_t<decltype(bool(std::declval<const M&>().viable(std::declval<const typename M::state_type&>())))>> : std::true_type {};
+
+template <class Machine, class IntType = int, class RAContainerInt = std::vector<IntType>>
+class basic_constrained_combinations
+{
+public:
+	using difference_type = long long;
+	using size_type = long long;
+	using value_type = RAContainerInt;
+	using combination = value_type;
+	using machine_type = Machine;
+	using state_type = typename Machine::state_type;
+	class predicate;
+
+	////////////////////////////////////////////////////////////
+	/// \brief The k-subsets of {0,...,n-1} accepted by machine. Counts them all right away.
+	/// \throws std::overflow_error if there are too many to count with a long long.
+	////////////////////////////////////////////////////////////
+	basic_constrained_combinations(IntType n, IntType k, Machine machine = Machine()) : m_n(n), m_k(k), m_machine(machine), m_memo(k*(n + 1) + 1)
+	{
+		assert(0 <= k && k <= n);
+		m_size = count(0, -1, m_machine.initial());
+	}
+
+	IntType get_n() const { return m_n; }
+
+	IntType get_k() const { return m_k; }
+
+	const Machine& machine() const { return m_machine; }
+
+	////////////////////////////////////////////////////////////
+	/// \brief How many combinations the machine accepts.
+	////////////////////////////////////////////////////////////
+	size_type size() const { return m_size; }
+
+	bool empty() const { return m_size == 0; }
+
+	////////////////////////////////////////////////////////////
+	/// \brief Number of (size, last element, state) triples memoized. The counting takes time proportional to this times n.
+	////////////////////////////////////////////////////////////
+	size_type num_states() const
+	{
+		size_type result = 0;
+		for (auto& level : m_memo)
+			result += level.size();
+		return result;
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief The m-th accepted combination, in lexicographic order (the order of find_all).
+	////////////////////////////////////////////////////////////
+	combination operator[](size_type m) const
+	{
+		assert(0 <= m && m < size());
+		combination result;
+		result.reserve(m_k);
+
+		state_type s = m_machine.initial();
+		IntType last = -1;
+		for (IntType pos = 0; pos < m_k; ++pos)
+		{
+			for (IntType x = last + 1; ; ++x)
+			{
+				assert(x <= m_n - (m_k - pos));
+				state_type t = m_machine.state(s, x);
+				if (!viable(t))
+					continue;
+
+				size_type c = completions(pos + 1, x, t);
+				if (m < c)
+				{
+					result.push_back(x);
+					s = std::move(t);
+					last = x;
+					break;
+				}
+				m -= c;
+			}
+		}
+
+		return result;
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief Opposite of operator[]: the position of comb, which must be accepted, among the accepted combinations.
+	////////////////////////////////////////////////////////////
+	size_type get_index(const combination& comb) const
+	{
+		assert(comb.size() == static_cast<std::size_t>(m_k));
+		size_type result = 0;
+
+		state_type s = m_machine.initial();
+		IntType last = -1;
+		for (IntType pos = 0; pos < m_k; ++pos)
+		{
+			for (IntType x = last + 1; x < comb[pos]; ++x)
+			{
+				state_type t = m_machine.state(s, x);
+				if (viable(t))
+					result = checked_add<size_type>(result, completions(pos + 1, x, t));
+			}
+			s = m_machine.state(s, comb[pos]);
+			last = comb[pos];
+		}
+
+		assert(m_machine.accept(s));
+		return result;
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief An accepted combination, chosen uniformly at random with g.
+	////////////////////////////////////////////////////////////
+	template <class URNG>
+	combination random(URNG& g) const
+	{
+		assert(!empty());
+		std::uniform_int_distribution<size_type> d(0, size() - 1);
+		return (*this)[d(g)];
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief An accepted combination, chosen uniformly at random.
+	////////////////////////////////////////////////////////////
+	combination random() const
+	{
+		return random(random::random_engine());
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief Applies f to every accepted combination, in order. Only visits prefixes that can be completed.
+	////////////////////////////////////////////////////////////
+	template <class Func>
+	void for_each(Func f) const
+	{
+		if (empty())
+			return;
+
+		combination comb;
+		comb.reserve(m_k);
+		for_each_completion(comb, m_machine.initial(), f);
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief An incremental predicate (see PartialPredicate.hpp) that accepts exactly the prefixes of accepted combinations.
+	///
+	/// It uses the counts, so find_all with it never enters a branch without solutions. It keeps a
+	/// pointer to *this, which must outlive it.
+	////////////////////////////////////////////////////////////
+	predicate get_predicate() const { return predicate(this); }
+
+	////////////////////////////////////////////////////////////
+	/// \brief All the accepted combinations, through the usual find_all search tree (with get_predicate()).
+	////////////////////////////////////////////////////////////
+	auto find_all() const
+	{
+		return basic_combinations_tree_prunned<IntType, predicate, combination>(m_n, m_k, get_predicate());
+	}
+
+	class predicate
+	{
+	public:
+		explicit predicate(const basic_constrained_combinations* X) : m_X(X), m_states(1, X->m_machine.initial()), m_last(1, -1)
+		{
+			m_states.reserve(X->m_k + 1);
+			m_last.reserve(X->m_k + 1);
+		}
+
+		void on_push(IntType x)
+		{
+			m_states.push_back(m_X->m_machine.state(m_states.back(), x));
+			m_last.push_back(x);
+		}
+
+		void on_pop(IntType)
+		{
+			m_states.pop_back();
+			m_last.pop_back();
+		}
+
+		bool accept() const
+		{
+			const state_type& s = m_states.back();
+			return m_X->viable(s) && m_X->completions(m_states.size() - 1, m_last.back(), s) > 0;
+		}
+
+	private:
+		const basic_constrained_combinations* m_X;
+		std::vector<state_type> m_states; // m_states[i] is the state after the first i elements
+		std::vector<IntType> m_last;
+	};
+
+private:
+	bool viable(const state_type& s) const { return viable(s, has_viable<Machine>()); }
+
+	bool viable(const state_type& s, std::true_type) const { return m_machine.viable(s); }
+
+	bool viable(const state_type&, std::false_type) const { return true; }
+
+	std::map<state_type, size_type>& level(IntType pos, IntType last) { return m_memo[pos*(m_n + 1) + last + 1]; }
+
+	const std::map<state_type, size_type>& level(IntType pos, IntType last) const { return m_memo[pos*(m_n + 1) + last + 1]; }
+
+	// Number of ways to complete a combination with pos elements, the last one being last, in state s.
+	size_type count(IntType pos, IntType last, const state_type& s)
+	{
+		if (pos == m_k)
+			return m_machine.accept(s);
+
+		auto& memo = level(pos, last);
+		auto found = memo.find(s);
+		if (found != memo.end())
+			return found->second;
+
+		size_type total = 0;
+		for (IntType x = last + 1; x <= m_n - (m_k - pos); ++x)
+		{
+			state_type t = m_machine.state(s, x);
+			if (viable(t))
+				total = checked_add<size_type>(total, count(pos + 1, x, t));
+		}
+
+		memo.emplace(s, total);
+		return total;
+	}
+
+	// The same, once everything is counted. Every viable node reachable from the empty combination is in the memo.
+	size_type completions(IntType pos, IntType last, const state_type& s) const
+	{
+		if (pos == m_k)
+			return m_machine.accept(s);
+
+		auto& memo = level(pos, last);
+		auto found = memo.find(s);
+		assert(found != memo.end());
+		return found->second;
+	}
+
+	template <class Func>
+	void for_each_completion(combination& comb, const state_type& s, Func& f) const
+	{
+		IntType pos = comb.size();
+		if (pos == m_k)
+		{
+			f(static_cast<const combination&>(comb));
+			return;
+		}
+
+		IntType last = comb.empty() ? -1 : comb.back();
+		for (IntType x = last + 1; x <= m_n - (m_k - pos); ++x)
+		{
+			state_type t = m_machine.state(s, x);
+			if (!viable(t) || completions(pos + 1, x, t) == 0)
+				continue;
+
+			comb.push_back(x);
+			for_each_completion(comb, t, f);
+			comb.pop_back();
+		}
+	}
+
+	IntType m_n;
+	IntType m_k;
+	Machine m_machine;
+	size_type m_size {0};
+	std::vector<std::map<state_type, size_type>> m_memo; // by (number of elements, last element)
+}; // end class basic_constrained_combinations
+
+template <class Machine>
+using constrained_combinations = basic_constrained_combinations<Machine, int>;
+} // namespace dscr
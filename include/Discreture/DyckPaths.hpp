@@ -4,6 +4,9 @@
 #include "Misc.hpp"
 #include "Sequences.hpp"
 #include "NumberRange.hpp"
+#include "DyckPathsPacked.hpp"
+#include "Instrumentation.hpp"
+#include "Subrange.hpp"
 #include <boost/iterator/iterator_facade.hpp>
 
 namespace dscr
@@ -41,6 +44,9 @@ namespace dscr
 ///     (())()
 ///     ()()()
 ///
+/// The order of iteration is colexicographic: reading each path from its last step to
+/// its first, with -1 < 1. This is what makes get_index and operator[] possible.
+///
 /////////////////////////////////////////////////////////////////////////////////////
 template <class IntType, class RAContainerInt = std::vector<IntType>>
 class basic_dyck_paths
@@ -53,6 +59,8 @@ public:
     using dyck_path = value_type;
     class iterator;
     using const_iterator = iterator;
+    class reverse_iterator;
+    using const_reverse_iterator = reverse_iterator;
 
     // **************** Begin static functions
     static void next_dyck_path(dyck_path& data)
@@ -126,6 +134,96 @@ public:
         }
     }
 
+    ////////////////////////////////////////////////////////////
+    /// \brief Inverse of next_dyck_path. Does nothing if data is the first path.
+    ///
+    /// The first up step after the first down step becomes a down step, and everything
+    /// before it is replaced by the largest possible prefix: ()()...()((...(
+    ////////////////////////////////////////////////////////////
+    static void prev_dyck_path(dyck_path& data)
+    {
+        const size_t size = data.size();
+
+        size_t z = 0;
+
+        while (z < size && data[z] == 1)
+            ++z;
+
+        size_t p = z;
+
+        while (p < size && data[p] == -1)
+            ++p;
+
+        if (p == size)
+            return;
+
+        data[p] = -1;
+
+        const size_t H = 2*z + 2 - p; // height at which the new prefix has to end
+        size_t i = 0;
+
+        for ( ; i + H < p; i += 2)
+        {
+            data[i] = 1;
+            data[i + 1] = -1;
+        }
+
+        for ( ; i < p; ++i)
+            data[i] = 1;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Constructs the m-th dyck path (in the order of iteration) into data.
+    ///
+    /// \param data must already have size 2n.
+    /// \param m must be an integer in [0, catalan(n)).
+    ////////////////////////////////////////////////////////////
+    static void construct_dyck_path(dyck_path& data, size_type m)
+    {
+        size_type h = 0;
+
+        for (size_type i = static_cast<size_type>(data.size()) - 1; i >= 0; --i)
+        {
+            // number of paths which go down at step i, given the steps after i
+            size_type num_down = ballot_number<size_type>(i, h + 1);
+
+            if (m < num_down)
+            {
+                data[i] = -1;
+                ++h;
+            }
+            else
+            {
+                m -= num_down;
+                data[i] = 1;
+                --h;
+            }
+        }
+    }
+
+    /////////////////////////////////////////////////////////////////////////////
+    /// \brief Returns the ID of the iterator whose value is path. That is, the index of path in the order of iteration.
+    ///
+    /// Inverse of operator[]. If dyck path x is the m-th dyck path, then get_index(x) is m.
+    /// \note This constructs the proper index from scratch. If an iterator is already known, calling ID() on the iterator is much more efficient.
+    /////////////////////////////////////////////////////////////////////////////
+    static size_type get_index(const dyck_path& path)
+    {
+        const size_type size = path.size();
+        size_type result = 0;
+        size_type h = 0; // height after step i
+
+        for (size_type i = 0; i < size; ++i)
+        {
+            h += path[i];
+
+            if (path[i] == 1)
+                result += ballot_number<size_type>(i, h + 1);
+        }
+
+        return result;
+    }
+
     static std::string to_string(const dyck_path& data, const std::string& delim = "()")
     {
         std::string toReturn;
@@ -169,14 +267,41 @@ public:
         return m_n;
     }
 
+    ////////////////////////////////////////////////////////////
+    /// \brief Access to the m-th dyck path (slow for iteration)
+    ///
+    /// This is equivalent to calling *(begin()+m)
+    /// \param m should be an integer between 0 and size(). Undefined behavior otherwise.
+    /// \return The m-th dyck path, as defined in the order of iteration
+    ////////////////////////////////////////////////////////////
+    dyck_path operator[](size_type m) const
+    {
+        assert(m >= 0 && m < size());
+        dyck_path path(2*m_n);
+        construct_dyck_path(path, m);
+        instrument(instrumented::dyck_paths, instrumented::unrank);
+        return path;
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Get an iterator whose current value is path
+    ///
+    /// \param path the wanted dyck path
+    /// \return An iterator currently pointing at path.
+    ////////////////////////////////////////////////////////////
+    iterator get_iterator(const dyck_path& path) const
+    {
+        return iterator(path);
+    }
+
 
     ////////////////////////////////////////////////////////////
-    /// \brief Forward iterator class.
+    /// \brief Random access iterator class. It's much more efficient as a bidirectional iterator than purely random access.
     ////////////////////////////////////////////////////////////
     class iterator :  public boost::iterator_facade <
         iterator,
         const dyck_path&,
-        boost::forward_traversal_tag
+        boost::random_access_traversal_tag
         >
     {
     public:
@@ -187,6 +312,10 @@ public:
                 m_data[i] = -1;
         }
 
+        explicit iterator(const dyck_path& path) : m_ID(get_index(path)), m_data(path)
+        {
+        }
+
         size_type ID() const
         {
             return m_ID;
@@ -199,6 +328,7 @@ public:
 
         void reset(IntType n)
         {
+            instrument(instrumented::dyck_paths, instrumented::reset);
             m_ID = 0;
             m_data.resize(2*n);
 			auto r = static_cast<size_t>(n);
@@ -220,17 +350,64 @@ public:
 		
         void increment()
         {
+            instrument(instrumented::dyck_paths, instrumented::step);
             ++m_ID;
 
             next_dyck_path(m_data);
         }
 
+        void decrement()
+        {
+            instrument(instrumented::dyck_paths, instrumented::step);
+            assert(m_ID != 0);
+
+            --m_ID;
+
+            prev_dyck_path(m_data);
+        }
 
         const dyck_path& dereference() const
         {
             return m_data;
         }
 
+        ////////////////////////////////////////
+        ///
+        /// \brief Random access capabilities to the iterators
+        /// \param m -> This assumes 0 <= m+ID <= size()
+        ///
+        ////////////////////////////////////////
+        void advance(difference_type m)
+        {
+            assert(0 <= m + m_ID);
+
+            if (std::abs(m) < 20)
+            {
+                while (m > 0)
+                {
+                    increment();
+                    --m;
+                }
+
+                while (m < 0)
+                {
+                    decrement();
+                    ++m;
+                }
+
+                return;
+            }
+
+            // If m is large, then it's better to just construct it from scratch.
+            m_ID += m;
+            construct_dyck_path(m_data, m_ID);
+            instrument(instrumented::dyck_paths, instrumented::unrank);
+        }
+
+        difference_type distance_to(const iterator& other) const
+        {
+            return other.m_ID - m_ID;
+        }
 
         bool equal(const iterator& it) const
         {
@@ -244,6 +421,110 @@ public:
         friend class boost::iterator_core_access;
     }; // end class iterator
 
+    ////////////////////////////////////////////////////////////
+    /// \brief Reverse random access iterator class.
+    ////////////////////////////////////////////////////////////
+    class reverse_iterator :  public boost::iterator_facade <
+        reverse_iterator,
+        const dyck_path&,
+        boost::random_access_traversal_tag
+        >
+    {
+    public:
+        reverse_iterator() {} //empty initializer
+        explicit reverse_iterator(IntType n) : m_n(n), m_ID(0), m_data(2 * n, 1)
+        {
+            for (size_t i = 1; i < m_data.size(); i += 2)
+                m_data[i] = -1;
+        }
+
+        size_type ID() const
+        {
+            return m_ID;
+        }
+
+        static const reverse_iterator make_invalid_with_id(size_type id)
+        {
+            reverse_iterator it;
+            it.m_ID = id;
+            return it;
+        }
+
+    private:
+
+        void increment()
+        {
+            instrument(instrumented::dyck_paths, instrumented::step);
+            ++m_ID;
+
+            prev_dyck_path(m_data);
+        }
+
+        void decrement()
+        {
+            instrument(instrumented::dyck_paths, instrumented::step);
+            assert(m_ID != 0);
+
+            --m_ID;
+
+            next_dyck_path(m_data);
+        }
+
+        const dyck_path& dereference() const
+        {
+            return m_data;
+        }
+
+        ////////////////////////////////////////
+        ///
+        /// \brief Random access capabilities to the iterators
+        /// \param m -> This assumes 0 <= m+ID <= size()
+        ///
+        ////////////////////////////////////////
+        void advance(difference_type m)
+        {
+            assert(0 <= m + m_ID);
+
+            if (std::abs(m) < 20)
+            {
+                while (m > 0)
+                {
+                    increment();
+                    --m;
+                }
+
+                while (m < 0)
+                {
+                    decrement();
+                    ++m;
+                }
+
+                return;
+            }
+
+            m_ID += m;
+            construct_dyck_path(m_data, catalan(m_n) - m_ID - 1);
+            instrument(instrumented::dyck_paths, instrumented::unrank);
+        }
+
+        difference_type distance_to(const reverse_iterator& other) const
+        {
+            return other.m_ID - m_ID;
+        }
+
+        bool equal(const reverse_iterator& it) const
+        {
+            return it.ID() == ID();
+        }
+
+    private:
+        IntType m_n {0};
+        size_type m_ID {0};
+        dyck_path m_data {};
+
+        friend class boost::iterator_core_access;
+    }; // end class reverse_iterator
+
     iterator begin() const
     {
         return iterator(m_n);
@@ -254,6 +535,72 @@ public:
         return iterator::make_invalid_with_id(size());
     }
 
+    ////////////////////////////////////////////////////////////
+    /// \brief The dyck paths of ranks [first, last) (see Subrange.hpp).
+    ////////////////////////////////////////////////////////////
+    subrange<iterator> range(size_type first, size_type last) const
+    {
+        return make_subrange(*this, first, last);
+    }
+
+    reverse_iterator rbegin() const
+    {
+        return reverse_iterator(m_n);
+    }
+
+    const reverse_iterator rend() const
+    {
+        return reverse_iterator::make_invalid_with_id(size());
+    }
+
+    ////////////////////////////////////////////////////////////
+    /// \brief Applies function f to each element of *this. Equivalent (but faster) to:
+    ///			for (auto& x : (*this)) f(x);
+    ///
+    /// For n <= 32 the successor is computed on the packed form (see basic_dyck_paths_packed)
+    /// and only the steps that changed are written back.
+    ///
+    /// \param f is the function to apply. It should take a const dyck_path& as parameter.
+    ///////////////////////////////////////////////////////////
+    template <class Func>
+    void for_each(Func f) const
+    {
+        using packed = basic_dyck_paths_packed<IntType>;
+
+        dyck_path data = *begin();
+        size_type i = size();
+        instrument(instrumented::dyck_paths, instrumented::step, i);
+
+        if (m_n > packed::max_n)
+        {
+            for ( ; i > 0; --i)
+            {
+                f(static_cast<const dyck_path&>(data));
+                next_dyck_path(data);
+            }
+            return;
+        }
+
+        auto word = packed::first_dyck_path(m_n);
+
+        while (true)
+        {
+            f(static_cast<const dyck_path&>(data));
+
+            if (--i == 0)
+                break;
+
+            auto old = word;
+            packed::next_dyck_path(word, m_n);
+
+            for (auto changed = old ^ word; changed != 0; changed &= changed - 1)
+            {
+                auto j = count_trailing_zeros(changed);
+                data[j] = -data[j];
+            }
+        }
+    }
+
 
 private:
     IntType m_n;
@@ -0,0 +1,532 @@
+#pragma once
+
+#include "VectorHelpers.hpp"
+#include "Misc.hpp"
+#include "Sequences.hpp"
+#include "Instrumentation.hpp"
+#include "Subrange.hpp"
+#include <boost/iterator/iterator_facade.hpp>
+#include <cstdint>
+#include <string>
+
+namespace dscr
+{
+
+////////////////////////////////////////////////////////////////////////////////////
+/// \brief Class for iterating through all dyck paths of size 2n, with n <= 32, stored as bits of a single word.
+/// \param IntType must be a SIGNED integer type.
+///
+/// Bit i of a dyck_path is 1 if step i goes up and 0 if it goes down. The paths
+/// are generated in exactly the same order as basic_dyck_paths, but each step is
+/// a constant number of word operations (ctz/popcount) instead of a linear scan.
+/// In fact, the order of iteration is just increasing order of the packed words.
+///
+/// #Example Usage:
+///
+///     dyck_paths_packed X(3)
+///     for (const auto& x : X)
+///         cout << dyck_paths_packed::to_string(x, 3) << endl;
+///
+/// Prints out:
+///     ((()))
+///     (()())
+///     ()(())
+///     (())()
+///     ()()()
+///
+/////////////////////////////////////////////////////////////////////////////////////
+template <class IntType>
+class basic_dyck_paths_packed
+{
+public:
+
+	using difference_type = long long;
+	using size_type = long long;
+	using value_type = std::uint64_t;
+	using dyck_path = value_type;
+	class iterator;
+	using const_iterator = iterator;
+	class reverse_iterator;
+	using const_reverse_iterator = reverse_iterator;
+
+	static constexpr IntType max_n = 32;
+
+	// **************** Begin static functions
+
+	////////////////////////////////////////////////////////////
+	/// \brief The first dyck path: n up steps followed by n down steps.
+	////////////////////////////////////////////////////////////
+	static dyck_path first_dyck_path(IntType n)
+	{
+		assert(0 <= n && n <= max_n);
+		return low_bits_mask(n);
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief Same successor as basic_dyck_paths::next_dyck_path, but on the packed form.
+	/// \param data is the current path. Does nothing if data is the last path.
+	/// \param n is half the length of the path.
+	////////////////////////////////////////////////////////////
+	static void next_dyck_path(dyck_path& data, IntType n)
+	{
+		if (n < 2)
+			return;
+
+		if (data & 2)
+		{
+			// The path starts with at least two up steps: move the first down step one place to the left.
+			int loc = count_trailing_zeros(~data);
+			data ^= dyck_path(3) << (loc - 1);
+			return;
+		}
+
+		// The path starts with "()". Look for the first odd step (after the first two) that goes up.
+		const dyck_path odd_steps = 0xAAAAAAAAAAAAAAA8ULL & low_bits_mask(2*n);
+		const dyck_path candidates = data & odd_steps;
+
+		if (candidates == 0)
+			return;
+
+		int verif = count_trailing_zeros(candidates);
+		int cont = verif/2; // number of down steps before verif
+
+		data |= low_bits_mask(verif + 1);
+
+		int encontrar = count_trailing_zeros(~data);
+
+		data ^= dyck_path(3) << (encontrar - 1);
+		data &= ~(low_bits_mask(cont) << (encontrar - 1 - cont));
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief Inverse of next_dyck_path. Does nothing if data is the first path.
+	////////////////////////////////////////////////////////////
+	static void prev_dyck_path(dyck_path& data)
+	{
+		int z = count_trailing_zeros(~data); // first down step
+
+		if ((data >> z) == 0)
+			return;
+
+		int p = z + count_trailing_zeros(data >> z); // first up step after it
+		int H = 2*z + 2 - p;
+
+		data &= ~low_bits_mask(p + 1);
+		data |= (0x5555555555555555ULL & low_bits_mask(p - H)) | (low_bits_mask(H) << (p - H));
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief The m-th dyck path of size 2n (in the order of iteration).
+	/// \param m must be an integer in [0, catalan(n)).
+	////////////////////////////////////////////////////////////
+	static dyck_path construct_dyck_path(IntType n, size_type m)
+	{
+		dyck_path data = 0;
+		size_type h = 0;
+
+		for (IntType i = 2*n - 1; i >= 0; --i)
+		{
+			size_type num_down = ballot_number<size_type>(i, h + 1);
+
+			if (m < num_down)
+			{
+				++h;
+			}
+			else
+			{
+				m -= num_down;
+				data |= dyck_path(1) << i;
+				--h;
+			}
+		}
+
+		return data;
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+	/// \brief Returns the index of path in the order of iteration. Inverse of operator[].
+	/////////////////////////////////////////////////////////////////////////////
+	static size_type get_index(const dyck_path& path)
+	{
+		size_type result = 0;
+
+		for (dyck_path w = path; w != 0; w &= w - 1)
+		{
+			int i = count_trailing_zeros(w);
+			result += ballot_number<size_type>(i, height(path, i + 1) + 1);
+		}
+
+		return result;
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief Height of the path after the first i steps.
+	////////////////////////////////////////////////////////////
+	static int height(const dyck_path& data, IntType i)
+	{
+		assert(0 <= i && i <= 2*max_n);
+		return 2*popcount(data & low_bits_mask(i)) - i;
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief Whether step i goes up and step i+1 goes down.
+	////////////////////////////////////////////////////////////
+	static bool is_peak(const dyck_path& data, IntType i)
+	{
+		assert(0 <= i && i + 1 < 2*max_n);
+		return ((data >> i) & 3) == 1;
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief Number of peaks (up step immediately followed by a down step).
+	////////////////////////////////////////////////////////////
+	static int num_peaks(const dyck_path& data)
+	{
+		return popcount(data & ~(data >> 1));
+	}
+
+	static std::string to_string(const dyck_path& data, IntType n, const std::string& delim = "()")
+	{
+		std::string toReturn(2*n, delim[1]);
+
+		for (dyck_path w = data; w != 0; w &= w - 1)
+			toReturn[count_trailing_zeros(w)] = delim[0];
+
+		return toReturn;
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief Converts a packed path into the +1/-1 representation of basic_dyck_paths.
+	////////////////////////////////////////////////////////////
+	template <class RAContainerInt = std::vector<IntType>>
+	static RAContainerInt unpack(const dyck_path& data, IntType n)
+	{
+		RAContainerInt result(2*n);
+
+		for (IntType i = 0; i < 2*n; ++i)
+			result[i] = ((data >> i) & 1) ? 1 : -1;
+
+		return result;
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief Converts a +1/-1 path of at most 64 steps into its packed representation.
+	////////////////////////////////////////////////////////////
+	template <class RAContainerInt>
+	static dyck_path pack(const RAContainerInt& path)
+	{
+		assert(path.size() <= 2*static_cast<size_t>(max_n));
+		dyck_path result = 0;
+
+		for (size_t i = 0; i < path.size(); ++i)
+		{
+			if (path[i] == 1)
+				result |= dyck_path(1) << i;
+		}
+
+		return result;
+	}
+
+	// **************** End static functions
+
+public:
+
+	////////////////////////////////////////////////////////////
+	/// \brief Constructor
+	///
+	/// \param n is an integer with 0 <= n <= 32
+	///
+	////////////////////////////////////////////////////////////
+	explicit basic_dyck_paths_packed(IntType n) : m_n(n)
+	{
+		assert(0 <= n && n <= max_n);
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief The total number of dyck_paths
+	///
+	/// \return binomial(2n,n)/(n+1)
+	///
+	////////////////////////////////////////////////////////////
+	size_type size() const
+	{
+		return catalan(m_n);
+	}
+
+	IntType get_n() const
+	{
+		return m_n;
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief Access to the m-th dyck path (slow for iteration)
+	///
+	/// \param m should be an integer between 0 and size(). Undefined behavior otherwise.
+	////////////////////////////////////////////////////////////
+	dyck_path operator[](size_type m) const
+	{
+		assert(m >= 0 && m < size());
+		instrument(instrumented::dyck_paths_packed, instrumented::unrank);
+		return construct_dyck_path(m_n, m);
+	}
+
+	iterator get_iterator(const dyck_path& path) const
+	{
+		return iterator(m_n, path);
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief Random access iterator class.
+	////////////////////////////////////////////////////////////
+	class iterator : public boost::iterator_facade<
+													iterator,
+													const dyck_path&,
+													boost::random_access_traversal_tag
+													>
+	{
+	public:
+		iterator() {} //empty initializer
+
+		explicit iterator(IntType n) : m_ID(0), m_n(n), m_data(first_dyck_path(n))
+		{
+		}
+
+		iterator(IntType n, const dyck_path& path) : m_ID(get_index(path)), m_n(n), m_data(path)
+		{
+		}
+
+		size_type ID() const
+		{
+			return m_ID;
+		}
+
+		bool is_at_end(IntType n) const
+		{
+			return m_ID == catalan(n);
+		}
+
+		void reset(IntType n)
+		{
+			instrument(instrumented::dyck_paths_packed, instrumented::reset);
+			m_ID = 0;
+			m_n = n;
+			m_data = first_dyck_path(n);
+		}
+
+		static const iterator make_invalid_with_id(size_type id)
+		{
+			iterator it;
+			it.m_ID = id;
+			return it;
+		}
+
+	private:
+
+		void increment()
+		{
+			instrument(instrumented::dyck_paths_packed, instrumented::step);
+			++m_ID;
+
+			next_dyck_path(m_data, m_n);
+		}
+
+		void decrement()
+		{
+			instrument(instrumented::dyck_paths_packed, instrumented::step);
+			if (m_ID == 0)
+				return;
+
+			--m_ID;
+
+			prev_dyck_path(m_data);
+		}
+
+		const dyck_path& dereference() const
+		{
+			return m_data;
+		}
+
+		void advance(difference_type m)
+		{
+			assert(0 <= m + m_ID);
+
+			if (std::abs(m) < 20)
+			{
+				for ( ; m > 0; --m)
+					increment();
+
+				for ( ; m < 0; ++m)
+					decrement();
+
+				return;
+			}
+
+			m_ID += m;
+			m_data = construct_dyck_path(m_n, m_ID);
+			instrument(instrumented::dyck_paths_packed, instrumented::unrank);
+		}
+
+		difference_type distance_to(const iterator& other) const
+		{
+			return other.m_ID - m_ID;
+		}
+
+		bool equal(const iterator& it) const
+		{
+			return it.ID() == ID();
+		}
+
+	private:
+		size_type m_ID {0};
+		IntType m_n {0};
+		dyck_path m_data {0};
+
+		friend class boost::iterator_core_access;
+	}; // end class iterator
+
+	////////////////////////////////////////////////////////////
+	/// \brief Reverse random access iterator class.
+	////////////////////////////////////////////////////////////
+	class reverse_iterator : public boost::iterator_facade<
+													reverse_iterator,
+													const dyck_path&,
+													boost::random_access_traversal_tag
+													>
+	{
+	public:
+		reverse_iterator() {} //empty initializer
+
+		explicit reverse_iterator(IntType n) : m_ID(0), m_n(n), m_data(0x5555555555555555ULL & low_bits_mask(2*n))
+		{
+		}
+
+		size_type ID() const
+		{
+			return m_ID;
+		}
+
+		static const reverse_iterator make_invalid_with_id(size_type id)
+		{
+			reverse_iterator it;
+			it.m_ID = id;
+			return it;
+		}
+
+	private:
+
+		void increment()
+		{
+			instrument(instrumented::dyck_paths_packed, instrumented::step);
+			++m_ID;
+
+			prev_dyck_path(m_data);
+		}
+
+		void decrement()
+		{
+			instrument(instrumented::dyck_paths_packed, instrumented::step);
+			assert(m_ID != 0);
+
+			--m_ID;
+
+			next_dyck_path(m_data, m_n);
+		}
+
+		const dyck_path& dereference() const
+		{
+			return m_data;
+		}
+
+		void advance(difference_type m)
+		{
+			assert(0 <= m + m_ID);
+
+			if (std::abs(m) < 20)
+			{
+				for ( ; m > 0; --m)
+					increment();
+
+				for ( ; m < 0; ++m)
+					decrement();
+
+				return;
+			}
+
+			m_ID += m;
+			m_data = construct_dyck_path(m_n, catalan(m_n) - m_ID - 1);
+			instrument(instrumented::dyck_paths_packed, instrumented::unrank);
+		}
+
+		difference_type distance_to(const reverse_iterator& other) const
+		{
+			return other.m_ID - m_ID;
+		}
+
+		bool equal(const reverse_iterator& it) const
+		{
+			return it.ID() == ID();
+		}
+
+	private:
+		size_type m_ID {0};
+		IntType m_n {0};
+		dyck_path m_data {0};
+
+		friend class boost::iterator_core_access;
+	}; // end class reverse_iterator
+
+	iterator begin() const
+	{
+		return iterator(m_n);
+	}
+
+	const iterator end() const
+	{
+		return iterator::make_invalid_with_id(size());
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief The dyck paths of ranks [first, last) (see Subrange.hpp).
+	////////////////////////////////////////////////////////////
+	subrange<iterator> range(size_type first, size_type last) const
+	{
+		return make_subrange(*this, first, last);
+	}
+
+	reverse_iterator rbegin() const
+	{
+		return reverse_iterator(m_n);
+	}
+
+	const reverse_iterator rend() const
+	{
+		return reverse_iterator::make_invalid_with_id(size());
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief Applies function f to each element of *this. Equivalent (but faster) to:
+	///			for (auto& x : (*this)) f(x);
+	///
+	/// \param f is the function to apply. It should take a const dyck_path& as parameter.
+	///////////////////////////////////////////////////////////
+	template <class Func>
+	void for_each(Func f) const
+	{
+		dyck_path data = first_dyck_path(m_n);
+		instrument(instrumented::dyck_paths_packed, instrumented::step, size());
+
+		for (size_type i = size(); i > 0; --i)
+		{
+			f(static_cast<const dyck_path&>(data));
+			next_dyck_path(data, m_n);
+		}
+	}
+
+private:
+	IntType m_n;
+
+}; // end class basic_dyck_paths_packed
+
+using dyck_paths_packed = basic_dyck_paths_packed<int>;
+
+} // end namespace dscr;
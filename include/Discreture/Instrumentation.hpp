@@ -0,0 +1,280 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <vector>
+#include <algorithm>
+
+////////////////////////////////////////////////////////////
+/// \file Instrumentation.hpp
+/// \brief Optional counters of how many steps (successor/predecessor calls), resets and unranks
+/// each family's iterators perform.
+///
+/// The policy is chosen at compile time with the macro DISCRETURE_INSTRUMENTATION, which must be
+/// the same for the whole program. By default it is dscr::no_instrumentation, whose hooks are
+/// empty inline functions, so they compile to nothing. To count, build with
+///
+/// 	-DDISCRETURE_INSTRUMENTATION=dscr::counting_instrumentation
+///
+/// and then, for example:
+///
+/// 	dscr::reset_instrumentation();
+/// 	for (auto& x : dscr::motzkin_paths(20))
+/// 		f(x);
+/// 	dscr::dump_instrumentation(std::cout);
+///
+/// Every thread counts into its own counters, so counting costs no synchronization.
+/// instrumentation_snapshot() adds up all threads (including those that already finished).
+/// A step is one call to increment/decrement (for_each counts one per object, all at once), a reset
+/// is when an iterator has to rebuild its state from scratch (e.g. a Motzkin path moving to
+/// the next dyck path, or a set partition moving to the next integer partition) and an unrank
+/// is constructing the m-th object directly (operator[], jumping with an iterator, etc).
+////////////////////////////////////////////////////////////
+
+namespace dscr
+{
+namespace instrumented
+{
+enum family
+{
+	combinations,
+	combinations_tree,
+	combinations_tree_prunned,
+	permutations,
+	multisets,
+	multisets_gray,
+	partitions,
+	set_partitions,
+	dyck_paths,
+	dyck_paths_packed,
+	motzkin_paths,
+	num_families
+};
+
+enum event
+{
+	step,
+	reset,
+	unrank,
+	num_events
+};
+
+inline const char* family_name(int f)
+{
+	const char* names[] = {"combinations", "combinations_tree", "combinations_tree_prunned", "permutations", "multisets",
+							"multisets_gray", "partitions", "set_partitions", "dyck_paths", "dyck_paths_packed", "motzkin_paths"};
+	return names[f];
+}
+
+inline const char* event_name(int e)
+{
+	const char* names[] = {"steps", "resets", "unranks"};
+	return names[e];
+}
+} // namespace instrumented
+
+////////////////////////////////////////////////////////////
+/// \brief How many times each event happened, for each family.
+////////////////////////////////////////////////////////////
+struct instrumentation_counts
+{
+	std::array<std::uint64_t, instrumented::num_families*instrumented::num_events> values {};
+
+	std::uint64_t operator()(instrumented::family f, instrumented::event e) const
+	{
+		return values[f*instrumented::num_events + e];
+	}
+
+	instrumentation_counts& operator+=(const instrumentation_counts& other)
+	{
+		for (size_t i = 0; i < values.size(); ++i)
+			values[i] += other.values[i];
+		return *this;
+	}
+};
+
+////////////////////////////////////////////////////////////
+/// \brief The default policy: does nothing.
+////////////////////////////////////////////////////////////
+struct no_instrumentation
+{
+	static constexpr bool enabled = false;
+
+	static void count(instrumented::family, instrumented::event, std::uint64_t = 1) {}
+};
+
+namespace detail
+{
+// The counters of one thread. Only that thread writes them, so a relaxed load+store is enough.
+class thread_instrumentation
+{
+public:
+	thread_instrumentation()
+	{
+		for (auto& v : m_values)
+			v.store(0, std::memory_order_relaxed);
+		std::lock_guard<std::mutex> lock(mutex());
+		live().push_back(this);
+	}
+
+	~thread_instrumentation()
+	{
+		std::lock_guard<std::mutex> lock(mutex());
+		finished() += snapshot();
+		live().erase(std::remove(live().begin(), live().end(), this), live().end());
+	}
+
+	thread_instrumentation(const thread_instrumentation&) = delete;
+	thread_instrumentation& operator=(const thread_instrumentation&) = delete;
+
+	void add(instrumented::family f, instrumented::event e, std::uint64_t times)
+	{
+		auto& v = m_values[f*instrumented::num_events + e];
+		v.store(v.load(std::memory_order_relaxed) + times, std::memory_order_relaxed);
+	}
+
+	instrumentation_counts snapshot() const
+	{
+		instrumentation_counts result;
+		for (size_t i = 0; i < m_values.size(); ++i)
+			result.values[i] = m_values[i].load(std::memory_order_relaxed);
+		return result;
+	}
+
+	void clear()
+	{
+		for (auto& v : m_values)
+			v.store(0, std::memory_order_relaxed);
+	}
+
+	static std::mutex& mutex()
+	{
+		static std::mutex m;
+		return m;
+	}
+
+	static std::vector<thread_instrumentation*>& live()
+	{
+		static std::vector<thread_instrumentation*> threads;
+		return threads;
+	}
+
+	static instrumentation_counts& finished()
+	{
+		static instrumentation_counts counts;
+		return counts;
+	}
+
+private:
+	std::array<std::atomic<std::uint64_t>, instrumented::num_families*instrumented::num_events> m_values;
+};
+
+inline thread_instrumentation& this_thread_instrumentation()
+{
+	thread_local thread_instrumentation counters;
+	return counters;
+}
+} // namespace detail
+
+////////////////////////////////////////////////////////////
+/// \brief Counts every event into thread-local counters.
+////////////////////////////////////////////////////////////
+struct counting_instrumentation
+{
+	static constexpr bool enabled = true;
+
+	static void count(instrumented::family f, instrumented::event e, std::uint64_t times = 1)
+	{
+		detail::this_thread_instrumentation().add(f, e, times);
+	}
+};
+
+#ifndef DISCRETURE_INSTRUMENTATION
+#define DISCRETURE_INSTRUMENTATION ::dscr::no_instrumentation
+#endif
+
+using instrumentation = DISCRETURE_INSTRUMENTATION;
+
+////////////////////////////////////////////////////////////
+/// \brief The hook the iterators call. A no-op unless DISCRETURE_INSTRUMENTATION says otherwise.
+////////////////////////////////////////////////////////////
+inline void instrument(instrumented::family f, instrumented::event e, std::uint64_t times = 1)
+{
+	instrumentation::count(f, e, times);
+}
+
+////////////////////////////////////////////////////////////
+/// \brief The counts of the calling thread only.
+////////////////////////////////////////////////////////////
+inline instrumentation_counts thread_instrumentation_snapshot()
+{
+	if (!instrumentation::enabled)
+		return instrumentation_counts();
+	return detail::this_thread_instrumentation().snapshot();
+}
+
+////////////////////////////////////////////////////////////
+/// \brief The counts of all threads, running or finished.
+////////////////////////////////////////////////////////////
+inline instrumentation_counts instrumentation_snapshot()
+{
+	using detail::thread_instrumentation;
+	std::lock_guard<std::mutex> lock(thread_instrumentation::mutex());
+	instrumentation_counts result = thread_instrumentation::finished();
+	for (auto* t : thread_instrumentation::live())
+		result += t->snapshot();
+	return result;
+}
+
+////////////////////////////////////////////////////////////
+/// \brief Sets every counter of every thread to zero. Call it while no other thread is enumerating.
+////////////////////////////////////////////////////////////
+inline void reset_instrumentation()
+{
+	using detail::thread_instrumentation;
+	std::lock_guard<std::mutex> lock(thread_instrumentation::mutex());
+	thread_instrumentation::finished() = instrumentation_counts();
+	for (auto* t : thread_instrumentation::live())
+		t->clear();
+}
+
+////////////////////////////////////////////////////////////
+/// \brief Prints a table with the families that had any event.
+////////////////////////////////////////////////////////////
+inline void dump_instrumentation(std::ostream& os, const instrumentation_counts& counts)
+{
+	using namespace instrumented;
+	os << std::left << std::setw(28) << "family" << std::right;
+	for (int e = 0; e < num_events; ++e)
+		os << std::setw(16) << event_name(e);
+	os << '\n';
+
+	for (int f = 0; f < num_families; ++f)
+	{
+		bool any = false;
+		for (int e = 0; e < num_events; ++e)
+			any = any || counts(family(f), event(e)) != 0;
+		if (!any)
+			continue;
+
+		os << std::left << std::setw(28) << family_name(f) << std::right;
+		for (int e = 0; e < num_events; ++e)
+			os << std::setw(16) << counts(family(f), event(e));
+		os << '\n';
+	}
+}
+
+inline void dump_instrumentation(std::ostream& os)
+{
+	if (!instrumentation::enabled)
+	{
+		os << "Instrumentation is disabled (see DISCRETURE_INSTRUMENTATION)\n";
+		return;
+	}
+	dump_instrumentation(os, instrumentation_snapshot());
+}
+} // namespace dscr
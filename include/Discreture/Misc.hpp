@@ -3,7 +3,12 @@
 #include <cmath>
 #include <iostream>
 #include <cstdlib>
+#include <cassert>
 #include <numeric>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
 #include <boost/iterator/iterator_facade.hpp>
 #include <boost/container/static_vector.hpp>
 #include <boost/container/vector.hpp>
@@ -72,6 +77,170 @@ T gcd(T a, T b)
 	return a;
 }
 
+//////////////////////////////////////////
+/// \brief Number of trailing zero bits of x. x must NOT be 0.
+//////////////////////////////////////////
+inline int count_trailing_zeros(std::uint64_t x)
+{
+	assert(x != 0);
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_ctzll(x);
+#else
+	int r = 0;
+	while ((x & 1) == 0)
+	{
+		x >>= 1;
+		++r;
+	}
+	return r;
+#endif
+}
+
+//////////////////////////////////////////
+/// \brief Number of bits set to 1 in x.
+//////////////////////////////////////////
+inline int popcount(std::uint64_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_popcountll(x);
+#else
+	int r = 0;
+	for ( ; x != 0; x &= x - 1)
+		++r;
+	return r;
+#endif
+}
+
+//////////////////////////////////////////
+/// \brief A word whose lowest n bits are 1 and all others 0. Works for n = 64 too.
+//////////////////////////////////////////
+inline std::uint64_t low_bits_mask(int n)
+{
+	assert(0 <= n && n <= 64);
+	return n >= 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << n) - 1;
+}
+
+namespace detail
+{
+#if defined(__SIZEOF_INT128__)
+using int128 = __int128;
+
+template <class T>
+struct is_builtin_integer : std::integral_constant<bool,
+	std::is_integral<T>::value || std::is_same<T, __int128>::value || std::is_same<T, unsigned __int128>::value> {};
+#else
+using int128 = long long;
+
+template <class T>
+struct is_builtin_integer : std::is_integral<T> {};
+#endif
+
+//////////////////////////////////////////
+/// \brief The type used for intermediate results when computing numbers of type T: __int128 for long long (when available), T itself otherwise.
+//////////////////////////////////////////
+template <class T>
+struct wider { using type = T; };
+
+template <>
+struct wider<long long> { using type = int128; };
+
+template <>
+struct wider<long> { using type = typename std::conditional<sizeof(long) < sizeof(int128), int128, long>::type; };
+
+[[noreturn]] inline void throw_overflow(const char* what)
+{
+	throw std::overflow_error(what);
+}
+
+template <class T>
+inline T checked_mul(T a, T b, std::true_type /*builtin*/)
+{
+	T r;
+#if defined(__GNUC__) || defined(__clang__)
+	if (__builtin_mul_overflow(a, b, &r))
+		throw_overflow("dscr: integer overflow in multiplication");
+#else
+	assert(a >= 0 && b >= 0);
+	if (b != 0 && a > std::numeric_limits<T>::max()/b)
+		throw_overflow("dscr: integer overflow in multiplication");
+	r = a*b;
+#endif
+	return r;
+}
+
+template <class T>
+inline T checked_mul(T a, T b, std::false_type /*builtin*/)
+{
+	return a*b;
+}
+
+template <class T>
+inline T checked_add(T a, T b, std::true_type /*builtin*/)
+{
+	T r;
+#if defined(__GNUC__) || defined(__clang__)
+	if (__builtin_add_overflow(a, b, &r))
+		throw_overflow("dscr: integer overflow in addition");
+#else
+	assert(a >= 0 && b >= 0);
+	if (a > std::numeric_limits<T>::max() - b)
+		throw_overflow("dscr: integer overflow in addition");
+	r = a + b;
+#endif
+	return r;
+}
+
+template <class T>
+inline T checked_add(T a, T b, std::false_type /*builtin*/)
+{
+	return a + b;
+}
+
+template <class Target, class Source>
+inline Target checked_cast(const Source& x, std::true_type /*bounded*/)
+{
+	if (x > static_cast<Source>(std::numeric_limits<Target>::max()) || x < static_cast<Source>(std::numeric_limits<Target>::min()))
+		throw_overflow("dscr: integer overflow in conversion");
+	return static_cast<Target>(x);
+}
+
+template <class Target, class Source>
+inline Target checked_cast(const Source& x, std::false_type /*bounded*/)
+{
+	return static_cast<Target>(x);
+}
+} // namespace detail
+
+//////////////////////////////////////////
+/// \brief a*b, but throws std::overflow_error if the result doesn't fit in T.
+///
+/// For builtin integers (including __int128) this is __builtin_mul_overflow. For other types (e.g. boost::multiprecision::cpp_int) it's just a*b.
+//////////////////////////////////////////
+template <class T>
+inline T checked_mul(const T& a, const T& b)
+{
+	return detail::checked_mul(a, b, detail::is_builtin_integer<T>());
+}
+
+//////////////////////////////////////////
+/// \brief a+b, but throws std::overflow_error if the result doesn't fit in T.
+//////////////////////////////////////////
+template <class T>
+inline T checked_add(const T& a, const T& b)
+{
+	return detail::checked_add(a, b, detail::is_builtin_integer<T>());
+}
+
+//////////////////////////////////////////
+/// \brief static_cast<Target>(x), but throws std::overflow_error if x doesn't fit in Target.
+//////////////////////////////////////////
+template <class Target, class Source>
+inline Target checked_cast(const Source& x)
+{
+	using bounded = std::integral_constant<bool, std::numeric_limits<Target>::is_bounded && !std::is_same<Target, Source>::value>;
+	return detail::checked_cast<Target>(x, bounded());
+}
+
 template <class T, class Container>
 T reduce_fraction(Container Numerator, Container Denominator)
 {
@@ -89,7 +258,7 @@ T reduce_fraction(Container Numerator, Container Denominator)
 	
 	T result = 1;
 	for (auto a : Numerator)
-		result *= a;
+		result = checked_mul<T>(result, a);
 	return result;
 }
 
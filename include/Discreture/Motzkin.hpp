@@ -2,6 +2,8 @@
 
 #include "Combinations.hpp"
 #include "DyckPaths.hpp"
+#include "Instrumentation.hpp"
+#include "Subrange.hpp"
 #include <boost/iterator/iterator_facade.hpp>
 
 namespace dscr
@@ -48,6 +50,9 @@ namespace dscr
 ///		(())
 ///		()()
 ///
+/// Paths are listed by number of nonzero steps, then by the dyck path those steps form,
+/// then by the positions of the nonzero steps (in the order of basic_combinations).
+///
 /////////////////////////////////////////////////////////////////////////////////////
 
 template <class IntType, class RAContainerInt = std::vector<IntType>>
@@ -59,10 +64,14 @@ public:
 	using size_type = long long;
 	using value_type = RAContainerInt;
 	using motzkin_path = value_type;
+	using combination = typename basic_combinations<IntType, RAContainerInt>::combination;
+	using dyck_path = typename basic_dyck_paths<IntType, RAContainerInt>::dyck_path;
 	using comb_i = typename basic_combinations<IntType, RAContainerInt>::iterator;
 	using dyck_i = typename basic_dyck_paths<IntType, RAContainerInt>::iterator;
 	class iterator;
 	using const_iterator = iterator;
+	class reverse_iterator;
+	using const_reverse_iterator = reverse_iterator;
 
 	static std::string to_string(const motzkin_path& data, const std::string& delim = "(-)")
 	{
@@ -77,6 +86,48 @@ public:
 		return toReturn;
 	}
 
+	////////////////////////////////////////////////////////////
+	/// \brief Number of motzkin paths of length n with exactly 2k nonzero steps: catalan(k)*binomial(n,2k)
+	////////////////////////////////////////////////////////////
+	static size_type num_with_nonzero_halved(IntType n, IntType k)
+	{
+		return checked_mul<size_type>(catalan(k), binomial<size_type>(n, 2*k));
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+	/// \brief Returns the ID of the iterator whose value is path. That is, the index of path in the order of iteration.
+	///
+	/// Paths are ordered first by the number of nonzero steps, then by the dyck path formed by
+	/// the nonzero steps and finally by the positions of the nonzero steps (as a combination).
+	/// \note This constructs the proper index from scratch. If an iterator is already known, calling ID() on the iterator is much more efficient.
+	/////////////////////////////////////////////////////////////////////////////
+	static size_type get_index(const motzkin_path& path)
+	{
+		IntType n = path.size();
+		combination positions;
+		dyck_path dyck;
+
+		for (IntType i = 0; i < n; ++i)
+		{
+			if (path[i] != 0)
+			{
+				positions.push_back(i);
+				dyck.push_back(path[i]);
+			}
+		}
+
+		IntType k = positions.size()/2;
+		size_type result = 0;
+
+		for (IntType j = 0; j < k; ++j)
+			result += num_with_nonzero_halved(n, j);
+
+		result += basic_dyck_paths<IntType, RAContainerInt>::get_index(dyck)*binomial<size_type>(n, 2*k);
+		result += basic_combinations<IntType, RAContainerInt>::get_index(positions);
+
+		return result;
+	}
+
 	// **************** End static functions
 
 public:
@@ -119,20 +170,82 @@ public:
 	{
 		return iterator::make_invalid_with_id(size());
 	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief The motzkin paths of ranks [first, last) (see Subrange.hpp).
+	////////////////////////////////////////////////////////////
+	subrange<iterator> range(size_type first, size_type last) const
+	{
+		return make_subrange(*this, first, last);
+	}
+
+	reverse_iterator rbegin() const
+	{
+		return reverse_iterator(m_n);
+	}
+
+	reverse_iterator rend() const
+	{
+		return reverse_iterator::make_invalid_with_id(size());
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief Access to the m-th motzkin path (slow for iteration)
+	///
+	/// This is equivalent to calling *(begin()+m)
+	/// \param m should be an integer between 0 and size(). Undefined behavior otherwise.
+	////////////////////////////////////////////////////////////
+	motzkin_path operator[](size_type m) const
+	{
+		assert(m >= 0 && m < size());
+		return *(begin() + m);
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief Get an iterator whose current value is path
+	////////////////////////////////////////////////////////////
+	iterator get_iterator(const motzkin_path& path) const
+	{
+		iterator it(m_n);
+		it.construct(get_index(path));
+		return it;
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief Applies function f to each element of *this. Equivalent (but faster) to:
+	///			for (auto& x : (*this)) f(x);
+	///
+	/// \param f is the function to apply. It should take a const motzkin_path& as parameter.
+	///////////////////////////////////////////////////////////
+	template <class Func>
+	void for_each(Func f) const
+	{
+		iterator it(m_n);
+
+		for (size_type i = size(); i > 0; --i)
+		{
+			f(it.m_data);
+			it.next();
+		}
+	}
 	
 	////////////////////////////////////////////////////////////
-	/// \brief Forward iterator class.
+	/// \brief Random access iterator class. It's much more efficient as a bidirectional iterator than purely random access.
+	///
+	/// The iterator keeps the positions of the nonzero steps (a combination) and the dyck path they form.
+	/// Each step moves only the nonzero steps whose position changed, exactly as the combination
+	/// successor does, so iteration takes constant amortized time.
 	////////////////////////////////////////////////////////////
 	class iterator : public boost::iterator_facade<
 													iterator,
 													const motzkin_path&,
-													boost::forward_traversal_tag
+													boost::random_access_traversal_tag
 													>
 	{
 	public:
-		iterator() : m_data(), m_comb(), m_dyck() {} //empty initializer
+		iterator() : m_data(), m_positions(), m_dyck() {} //empty initializer
 		
-		explicit iterator(IntType n) : m_data(n, 0), m_comb(n, 0), m_dyck(0)
+		explicit iterator(IntType n) : m_n(n), m_data(n, 0), m_positions(), m_dyck()
 		{
 		}
 		
@@ -141,6 +254,22 @@ public:
 			return m_ID;
 		}
 		
+		////////////////////////////////////////////////////////////
+		/// \brief The positions of the nonzero steps of the current path.
+		////////////////////////////////////////////////////////////
+		const combination& nonzero_positions() const
+		{
+			return m_positions;
+		}
+		
+		////////////////////////////////////////////////////////////
+		/// \brief The dyck path formed by the nonzero steps of the current path.
+		////////////////////////////////////////////////////////////
+		const dyck_path& nonzero_steps() const
+		{
+			return m_dyck;
+		}
+		
 		static iterator make_invalid_with_id(size_type id)
 		{
 			iterator it;
@@ -152,46 +281,51 @@ public:
 		
 		void increment()
 		{
-			using namespace std;
 			++m_ID;
-			auto n = m_data.size();
+			next();
+		}
 
-			if (m_ID == motzkin(n))
+		void decrement()
+		{
+			if (m_ID == 0)
 				return;
 
-			++m_comb;
-// 			std::cout << "hola" << std::endl;
-			if (m_comb.is_at_end(n))
-			{
-// 				cout << "Combination "<< *m_comb << " at end!" << endl;
-				//Reset combinations and make a new dyck path.
-				++m_dyck;
+			--m_ID;
+			prev();
+		}
+		
+		const motzkin_path& dereference() const
+		{
+			return m_data;
+		}
 
-// 					cout << "added 1 to dyck" << endl;
-				if (m_dyck.is_at_end(m_numnonzerohalved))
-				{
-// 										cout << "dyck at end!" << endl;
-					m_numnonzerohalved += 1;
+		////////////////////////////////////////
+		///
+		/// \brief Random access capabilities to the iterators
+		/// \param m -> This assumes 0 <= m+ID <= size()
+		///
+		////////////////////////////////////////
+		void advance(difference_type m)
+		{
+			assert(0 <= m + m_ID);
 
-// 						cout << "Resetting dyck..." << endl;
-					m_dyck.reset(m_numnonzerohalved);
-				}
+			if (std::abs(m) < 40)
+			{
+				for ( ; m > 0; --m)
+					increment();
 
-// 					cout << "Resetting combination..." << endl;
-				m_comb.reset(n, 2 * m_numnonzerohalved);
+				for ( ; m < 0; ++m)
+					decrement();
 
+				return;
 			}
 
-// 				cout << "Done! Converting!" << endl;
-// 			cout << "comb = " << *m_comb << " and dyck = " << *m_dyck << endl;
-			ConvertToMotzkin(); //TODO(mraggi): do this laziliy
+			construct(m_ID + m);
 		}
 
-		
-		
-		const motzkin_path& dereference() const
+		difference_type distance_to(const iterator& other) const
 		{
-			return m_data;
+			return other.m_ID - m_ID;
 		}
 
 		bool equal(const iterator& it) const
@@ -199,34 +333,302 @@ public:
 			return it.ID() == ID();
 		}
 
-	private:
-		size_type m_ID {0};
-		motzkin_path m_data;
-		comb_i m_comb;
-		dyck_i m_dyck;
-		IntType m_numnonzerohalved {0};
+		// Moves to the next path without touching m_ID. Does nothing at the last path.
+		void next()
+		{
+			instrument(instrumented::motzkin_paths, instrumented::step);
+
+			if (next_positions())
+				return;
+
+			if (m_dyck_ID + 1 < m_num_dyck)
+			{
+				++m_dyck_ID;
+				basic_dyck_paths<IntType, RAContainerInt>::next_dyck_path(m_dyck);
+			}
+			else
+			{
+				if (2*(m_k + 1) > m_n)
+					return;
+
+				set_nonzero_halved(m_k + 1);
+				m_dyck_ID = 0;
+				m_dyck = *basic_dyck_paths<IntType, RAContainerInt>(m_k).begin();
+			}
+
+			instrument(instrumented::motzkin_paths, instrumented::reset);
+			m_positions.resize(2*m_k);
+			std::iota(m_positions.begin(), m_positions.end(), 0);
+			m_hint = 0;
+			render();
+		}
+
+		// Moves to the previous path without touching m_ID. Does nothing at the first path.
+		void prev()
+		{
+			instrument(instrumented::motzkin_paths, instrumented::step);
+			m_hint = 0;
+
+			if (prev_positions())
+				return;
+
+			if (m_dyck_ID > 0)
+			{
+				--m_dyck_ID;
+				basic_dyck_paths<IntType, RAContainerInt>::prev_dyck_path(m_dyck);
+			}
+			else
+			{
+				if (m_k == 0)
+					return;
+
+				set_nonzero_halved(m_k - 1);
+				m_dyck_ID = m_num_dyck - 1;
+				m_dyck = *basic_dyck_paths<IntType, RAContainerInt>(m_k).rbegin();
+			}
+
+			instrument(instrumented::motzkin_paths, instrumented::reset);
+			m_positions.resize(2*m_k);
+			std::iota(m_positions.begin(), m_positions.end(), m_n - 2*m_k);
+			render();
+		}
+
+		// Same as basic_combinations::next_combination, but the nonzero steps of m_data move along with their positions.
+		bool next_positions()
+		{
+			auto& c = m_positions;
+			const IntType last = static_cast<IntType>(c.size()) - 1;
 
-		void ConvertToMotzkin()
+			if (last < 0)
+				return false;
+
+			if (m_hint > 0)
+			{
+				IntType i = --m_hint;
+				IntType p = c[i]++;
+				m_data[p + 1] = m_data[p];
+				m_data[p] = 0;
+				return true;
+			}
+
+			if (c[0] + 1 != c[1])
+			{
+				IntType p = c[0]++;
+				m_data[p + 1] = m_data[p];
+				m_data[p] = 0;
+				return true;
+			}
+
+			IntType i = 1;
+
+			for ( ; i < last && (c[i] + 1 == c[i + 1]); ++i) {}
+
+			// c[0..i] is a block of consecutive positions starting at a
+			const IntType a = c[0];
+
+			if (a + i + 1 == m_n)
+				return false;
+
+			for (IntType j = 0; j <= i; ++j)
+				m_data[a + j] = 0;
+
+			for (IntType j = 0; j < i; ++j)
+			{
+				c[j] = j;
+				m_data[j] = m_dyck[j];
+			}
+
+			c[i] = a + i + 1;
+			m_data[a + i + 1] = m_dyck[i];
+			m_hint = i;
+			return true;
+		}
+
+		// Same as basic_combinations::prev_combination, but the nonzero steps of m_data move along with their positions.
+		bool prev_positions()
 		{
-// 				cout << "Converting: " << *m_comb << " and " << *m_dyck << endl;
-			for (size_t i = 0; i < m_data.size(); ++i)
+			auto& c = m_positions;
+			const IntType last = static_cast<IntType>(c.size()) - 1;
+
+			if (last < 0 || c[last] == last)
+				return false;
+
+			if (c[0] != 0)
+			{
+				IntType p = c[0]--;
+				m_data[p - 1] = m_data[p];
+				m_data[p] = 0;
+				return true;
+			}
+
+			IntType i = 1;
+
+			for ( ; i < last && (c[i] == i); ++i) {}
+
+			// c[0..i-1] = 0..i-1 and c[i] = b > i. They become the block b-1-i, ..., b-1.
+			const IntType b = c[i];
+
+			for (IntType j = 0; j < i; ++j)
+				m_data[j] = 0;
+
+			m_data[b] = 0;
+
+			for (IntType j = 0; j <= i; ++j)
 			{
-				m_data[i] = 0;
+				c[j] = b - 1 - i + j;
+				m_data[c[j]] = m_dyck[j];
 			}
 
-			size_t count = 0;
+			return true;
+		}
+
+		void set_nonzero_halved(IntType k)
+		{
+			m_k = k;
+			m_num_dyck = catalan(k);
+		}
+
+		void render()
+		{
+			std::fill(m_data.begin(), m_data.end(), 0);
+
+			for (IntType j = 0; j < 2*m_k; ++j)
+				m_data[m_positions[j]] = m_dyck[j];
+		}
+
+		// Makes this iterator point to the m-th path.
+		void construct(size_type m)
+		{
+			instrument(instrumented::motzkin_paths, instrumented::unrank);
+			m_ID = m;
+			m_hint = 0;
+
+			IntType k = 0;
 
-			for (auto x : (*m_comb))
+			for (auto block = num_with_nonzero_halved(m_n, k); m >= block; block = num_with_nonzero_halved(m_n, k))
 			{
-				m_data[x] = (*m_dyck)[count];
-				++count;
+				if (2*k >= m_n)
+					return; // past the end: only the ID is meaningful
+
+				m -= block;
+				++k;
 			}
+
+			set_nonzero_halved(k);
+
+			const size_type num_positions = binomial<size_type>(m_n, 2*k);
+			m_dyck_ID = m/num_positions;
+
+			m_dyck.resize(2*k);
+			basic_dyck_paths<IntType, RAContainerInt>::construct_dyck_path(m_dyck, m_dyck_ID);
+
+			m_positions.resize(2*k);
+			basic_combinations<IntType, RAContainerInt>::construct_combination(m_positions, m%num_positions);
+
+			render();
 		}
 
+	private:
+		size_type m_ID {0};
+		IntType m_n {0};
+		motzkin_path m_data;
+		combination m_positions;
+		dyck_path m_dyck;
+		size_type m_hint {0};
+		IntType m_k {0}; // half the number of nonzero steps
+		size_type m_dyck_ID {0};
+		size_type m_num_dyck {1};
+
 		friend class boost::iterator_core_access;
+		friend class basic_motzkin_paths;
 	}; // end class iterator
 
-	
+	////////////////////////////////////////////////////////////
+	/// \brief Reverse random access iterator class.
+	////////////////////////////////////////////////////////////
+	class reverse_iterator : public boost::iterator_facade<
+													reverse_iterator,
+													const motzkin_path&,
+													boost::random_access_traversal_tag
+													>
+	{
+	public:
+		reverse_iterator() {} //empty initializer
+
+		explicit reverse_iterator(IntType n) : m_size(motzkin(n)), m_it(n)
+		{
+			m_it.construct(m_size - 1);
+			m_it.m_ID = 0;
+		}
+
+		size_type ID() const
+		{
+			return m_it.ID();
+		}
+
+		static reverse_iterator make_invalid_with_id(size_type id)
+		{
+			reverse_iterator it;
+			it.m_it.m_ID = id;
+			return it;
+		}
+
+	private:
+
+		void increment()
+		{
+			++m_it.m_ID;
+			m_it.prev();
+		}
+
+		void decrement()
+		{
+			assert(m_it.m_ID != 0);
+			--m_it.m_ID;
+			m_it.next();
+		}
+
+		const motzkin_path& dereference() const
+		{
+			return m_it.m_data;
+		}
+
+		void advance(difference_type m)
+		{
+			assert(0 <= m + ID());
+
+			if (std::abs(m) < 40)
+			{
+				for ( ; m > 0; --m)
+					increment();
+
+				for ( ; m < 0; ++m)
+					decrement();
+
+				return;
+			}
+
+			size_type id = ID() + m;
+			m_it.construct(m_size - id - 1);
+			m_it.m_ID = id;
+		}
+
+		difference_type distance_to(const reverse_iterator& other) const
+		{
+			return other.ID() - ID();
+		}
+
+		bool equal(const reverse_iterator& it) const
+		{
+			return it.ID() == ID();
+		}
+
+	private:
+		size_type m_size {0};
+		iterator m_it {};
+
+		friend class boost::iterator_core_access;
+	}; // end class reverse_iterator
 
 private:
 	IntType m_n;
@@ -2,6 +2,8 @@
 #include "VectorHelpers.hpp"
 #include "Misc.hpp"
 #include "NaturalNumber.hpp"
+#include "Instrumentation.hpp"
+#include "Subrange.hpp"
 #include <boost/iterator/iterator_facade.hpp>
 
 namespace dscr
@@ -60,28 +62,12 @@ public:
 	static void construct_multiset(multiset& sub, const multiset& total, size_type m)
 	{
 		assert(sub.size() == total.size());
-		size_type n = total.size();
-		if (n == 0)
-			return;
-		for (auto& s : sub) s = 0;
-		std::vector<size_type> coeffs(n);
-		coeffs[0] = 1;
-		for (size_type i = 1; i < n; ++i)
+		// m written in mixed radix (total[i]+1), least significant digit first. Inverse of get_index.
+		for (size_t i = 0; i < total.size(); ++i)
 		{
-			coeffs[i] = coeffs[i-1]*(total[i-1]+1);
-		}
-		
-		for (long i = n-1; i >= 0; --i)
-		{
-			size_type w = coeffs[i];
-			auto t = big_natural_number(total[i]+1).partition_point([m,w](size_type a)
-			{
-				return a*w <= m;
-			}) - 1;
-			sub[i] = t;
-			m -= w*t;
-			if (m <= 0)
-				break;
+			size_type radix = total[i] + 1;
+			sub[i] = m%radix;
+			m /= radix;
 		}
 	}
 	
@@ -115,15 +101,11 @@ public:
 	///
 	////////////////////////////////////////////////////////////
 	explicit basic_multisets(const multiset& set) : m_total(set),
-	m_size(1)
+	m_size(calc_size(set))
 	{
-		for (auto x : set)
-		{
-			m_size *= (x+1);
-		}
 	}
 
-	explicit basic_multisets(IntType size, IntType n = 1) : m_total(size, n), m_size(std::pow(n+1,size))
+	explicit basic_multisets(IntType size, IntType n = 1) : m_total(size, n), m_size(calc_size(m_total))
 	{
 	}
 
@@ -132,6 +114,14 @@ public:
 		return m_size;
 	}
 	
+	////////////////////////////////////////////////////////////
+	/// \brief The multiset whose submultisets these are.
+	////////////////////////////////////////////////////////////
+	const multiset& total() const
+	{
+		return m_total;
+	}
+	
 	iterator begin() const
 	{
 		return iterator(m_total);
@@ -152,6 +142,26 @@ public:
 		return reverse_iterator::make_invalid_with_id(size());
 	}
 	
+	////////////////////////////////////////////////////////////
+	/// \brief The sub-multisets of ranks [first, last) (see Subrange.hpp).
+	////////////////////////////////////////////////////////////
+	subrange<iterator> range(size_type first, size_type last) const
+	{
+		return make_subrange(*this, first, last);
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief The i-th of num_shards consecutive slices of the sub-multisets, of (almost) equal sizes.
+	///
+	/// For splitting the work among processes or machines: the shards of i = 0, 1, ..., num_shards-1
+	/// are disjoint and cover everything, and each one unranks only once, at its start.
+	////////////////////////////////////////////////////////////
+	subrange<iterator> shard(size_type i, size_type num_shards) const
+	{
+		auto bounds = shard_bounds(size(), i, num_shards);
+		return range(bounds.first, bounds.second);
+	}
+
 	//////////////////////////////
 	/// @brief Random Access Capabilities for multiset
 	/// @param m assumes 0 <= m < size(). Undefined behaviour otherwise
@@ -161,6 +171,7 @@ public:
 		assert(m >= 0 && m < size());
 		multiset sub(m_total.size());
 		construct_multiset(sub,m_total,m);
+		instrument(instrumented::multisets, instrumented::unrank);
 		return sub;
 	}
 	
@@ -216,12 +227,14 @@ public:
 		
 		void increment()
 		{
+			instrument(instrumented::multisets, instrumented::step);
 			++m_ID;
 			next_multiset(m_submulti,*m_total,m_n);
 		}
 		
 		void decrement()
 		{
+			instrument(instrumented::multisets, instrumented::step);
 			--m_ID;
 			prev_multiset(m_submulti,*m_total,m_n);
 		}
@@ -241,6 +254,7 @@ public:
 		{
 			m_ID += m;
 			construct_multiset(m_submulti,*m_total,m_ID);
+			instrument(instrumented::multisets, instrumented::unrank);
 		}
 		
 		difference_type distance_to(const iterator& it) const
@@ -293,12 +307,14 @@ public:
 		//prefix
 		void increment()
 		{
+			instrument(instrumented::multisets, instrumented::step);
 			++m_ID;
 			prev_multiset(m_submulti,*m_total,m_n);
 		}
 		
 		void decrement()
 		{
+			instrument(instrumented::multisets, instrumented::step);
 			--m_ID;
 			next_multiset(m_submulti,*m_total,m_n);
 		}
@@ -332,6 +348,14 @@ private:
 	multiset m_total;
 	size_type m_size;
 	
+	static size_type calc_size(const multiset& total)
+	{
+		size_type result = 1;
+		for (auto x : total)
+			result = checked_mul<size_type>(result, x + 1);
+		return result;
+	}
+	
 	static bool can_increment(size_t index, const multiset& sub, const multiset& total)
 	{
 		return sub[index] < total[index];
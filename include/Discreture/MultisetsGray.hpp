@@ -0,0 +1,499 @@
+#pragma once
+#include "VectorHelpers.hpp"
+#include "Misc.hpp"
+#include "Instrumentation.hpp"
+#include "Subrange.hpp"
+#include <boost/iterator/iterator_facade.hpp>
+
+namespace dscr
+{
+////////////////////////////////////////////////////////////
+/// \brief class of all submultisets of a given multiset in reflected mixed-radix gray code order.
+/// \param IntType can be an int, short, etc.
+///
+/// Consecutive submultisets differ in exactly one coordinate, and by exactly one (+1 or -1).
+/// The successor is loopless (Knuth's Algorithm H, TAOCP 7.2.1.1): iterators know which
+/// coordinate changed in the last step, so that incremental evaluators don't have to look for it.
+///
+/// # Example:
+///
+///	 multisets_gray X({1,0,2});
+///		for (auto it = X.begin(); it != X.end(); ++it)
+///			std::cout << *it << " " << it.changed_index() << " " << it.changed_by() << std::endl;
+///
+/// Prints out:
+///
+/// 	[ 0 0 0 ] -1 0
+///		[ 1 0 0 ] 0 1
+///		[ 1 0 1 ] 2 1
+///		[ 0 0 1 ] 0 -1
+///		[ 0 0 2 ] 2 1
+///		[ 1 0 2 ] 0 1
+///
+////////////////////////////////////////////////////////////
+template<class IntType, class RAContainerInt = std::vector<IntType>>
+class basic_multisets_gray
+{
+public:
+	using difference_type = long long;
+	using size_type = long long;
+	using value_type = RAContainerInt;
+	using multiset = value_type;
+	class iterator;
+	using const_iterator = iterator;
+	class reverse_iterator;
+	using const_reverse_iterator = reverse_iterator;
+
+	////////////////////////////////////////////////////////////
+	/// \brief Everything (besides the multiset itself) needed to take a step in constant time.
+	///
+	/// Only the coordinates with total[i] > 0 ever change. Those are listed in active, and
+	/// focus and direction are indexed by position in active, not by coordinate.
+	////////////////////////////////////////////////////////////
+	struct gray_state
+	{
+		RAContainerInt active {}; // coordinates i with total[i] > 0
+		RAContainerInt focus {}; // Knuth's focus pointers
+		RAContainerInt direction {}; // +1 or -1
+		IntType changed {-1}; // coordinate changed in the last step, or -1
+		IntType delta {0}; // what was added to sub[changed] in the last step
+	};
+
+public:
+	////////////////////////////////////////////////////////////
+	/// \brief The state for the first submultiset, which is all zeros.
+	////////////////////////////////////////////////////////////
+	static gray_state first_state(const multiset& total)
+	{
+		gray_state state;
+		init_active(state, total);
+		IntType na = state.active.size();
+		state.focus.resize(na);
+		state.direction.resize(na);
+		for (IntType j = 0; j < na; ++j)
+		{
+			state.focus[j] = j;
+			state.direction[j] = 1;
+		}
+		return state;
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief Moves sub to the next submultiset in gray code order.
+	///
+	/// \return The coordinate that changed (which is also saved in state), or -1 if sub was the last one.
+	////////////////////////////////////////////////////////////
+	static IntType next_multiset(multiset& sub, const multiset& total, gray_state& state)
+	{
+		IntType na = state.active.size();
+		state.changed = -1;
+		state.delta = 0;
+		if (na == 0)
+			return -1;
+
+		IntType j = state.focus[0];
+		state.focus[0] = 0;
+		if (j == na)
+			return -1;
+
+		IntType i = state.active[j];
+		IntType d = state.direction[j];
+		sub[i] += d;
+
+		if (sub[i] == 0 || sub[i] == total[i])
+		{
+			state.direction[j] = -d;
+			if (j + 1 < na)
+			{
+				state.focus[j] = state.focus[j + 1];
+				state.focus[j + 1] = j + 1;
+			}
+			else
+			{
+				state.focus[j] = na;
+			}
+		}
+
+		state.changed = i;
+		state.delta = d;
+		return i;
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief Makes sub the m-th submultiset in gray code order, and state the state right after visiting it.
+	////////////////////////////////////////////////////////////
+	static void construct_multiset(multiset& sub, const multiset& total, gray_state& state, size_type m)
+	{
+		construct_multiset_impl(sub, total, state, m, m, false);
+	}
+
+	static void construct_multiset(multiset& sub, const multiset& total, size_type m)
+	{
+		gray_state state;
+		construct_multiset(sub, total, state, m);
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief Opposite of construct_multiset
+	////////////////////////////////////////////////////////////
+	static size_type get_index(const multiset& sub, const multiset& total)
+	{
+		assert(sub.size() == total.size());
+		size_type result = 0;
+		for (long i = total.size() - 1; i >= 0; --i)
+		{
+			size_type r = total[i] + 1;
+			size_type b = (result%2 == 1) ? r - 1 - sub[i] : sub[i];
+			result = result*r + b;
+		}
+		return result;
+	}
+
+	explicit basic_multisets_gray(const multiset& set) : m_total(set), m_size(calc_size(set))
+	{
+	}
+
+	explicit basic_multisets_gray(IntType size, IntType n = 1) : m_total(size, n), m_size(calc_size(m_total))
+	{
+	}
+
+	size_type size() const
+	{
+		return m_size;
+	}
+
+	iterator begin() const
+	{
+		return iterator(m_total);
+	}
+
+	const iterator end() const
+	{
+		return iterator::make_invalid_with_id(size());
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief The sub-multisets of ranks [first, last) (see Subrange.hpp).
+	////////////////////////////////////////////////////////////
+	subrange<iterator> range(size_type first, size_type last) const
+	{
+		return make_subrange(*this, first, last);
+	}
+
+	reverse_iterator rbegin() const
+	{
+		return reverse_iterator(m_total, size());
+	}
+
+	const reverse_iterator rend() const
+	{
+		return reverse_iterator::make_invalid_with_id(size());
+	}
+
+	//////////////////////////////
+	/// @brief Random Access Capabilities for multiset
+	/// @param m assumes 0 <= m < size(). Undefined behaviour otherwise
+	//////////////////////////////
+	multiset operator[](size_type m) const
+	{
+		assert(m >= 0 && m < size());
+		multiset sub(m_total.size());
+		construct_multiset(sub, m_total, m);
+		instrument(instrumented::multisets_gray, instrumented::unrank);
+		return sub;
+	}
+
+	//////////////////////////////
+	/// @brief Opposite operator to operator[]
+	/// @param sub given a multiset, what would it's index be?
+	//////////////////////////////
+	size_type get_index(const multiset& sub) const
+	{
+		return get_index(sub, m_total);
+	}
+
+	//////////////////////////////
+	/// @brief Calls f(sub) on every submultiset, in order.
+	//////////////////////////////
+	template <class Func>
+	void for_each(Func f) const
+	{
+		multiset sub(m_total.size(), 0);
+		auto state = first_state(m_total);
+		instrument(instrumented::multisets_gray, instrumented::step, size());
+		do
+		{
+			f(static_cast<const multiset&>(sub));
+		} while (next_multiset(sub, m_total, state) != -1);
+	}
+
+	class iterator : public boost::iterator_facade<
+												iterator,
+												const multiset&,
+												boost::random_access_traversal_tag
+												>
+	{
+
+	public:
+		iterator(){}
+
+		explicit iterator(const multiset& total) : m_ID(0), m_submulti(total.size(), 0), m_state(first_state(total)), m_total(&total)
+		{
+
+		}
+
+		iterator(const iterator& it) = default; // This is so that the -Weffc++ doesn't complain about me having pointers. I'm not the owner of the pointer anyway.
+		iterator& operator=(const iterator& it) = default;
+
+		size_type ID() const
+		{
+			return m_ID;
+		}
+
+		//////////////////////////////
+		/// @brief The coordinate that changed in the last step, or -1 if the last move wasn't a single step.
+		//////////////////////////////
+		IntType changed_index() const
+		{
+			return m_state.changed;
+		}
+
+		//////////////////////////////
+		/// @brief +1 or -1: what was added to the coordinate changed_index() in the last step (0 if none).
+		//////////////////////////////
+		IntType changed_by() const
+		{
+			return m_state.delta;
+		}
+
+		static const iterator make_invalid_with_id(size_type id)
+		{
+			return iterator(id);
+		}
+
+	private:
+
+		explicit iterator(size_type id) : m_ID(id) {}
+
+		void increment()
+		{
+			instrument(instrumented::multisets_gray, instrumented::step);
+			++m_ID;
+			next_multiset(m_submulti, *m_total, m_state);
+		}
+
+		void decrement()
+		{
+			instrument(instrumented::multisets_gray, instrumented::step);
+			--m_ID;
+			construct_multiset(m_submulti, *m_total, m_state, m_ID);
+			instrument(instrumented::multisets_gray, instrumented::unrank);
+		}
+
+		const multiset& dereference() const
+		{
+			return m_submulti;
+		}
+
+		//It only makes sense to compare iterators from the SAME multiset.
+		bool equal(const iterator& it) const
+		{
+			return m_ID == it.m_ID;
+		}
+
+		void advance(difference_type m)
+		{
+			m_ID += m;
+			construct_multiset(m_submulti, *m_total, m_state, m_ID);
+			instrument(instrumented::multisets_gray, instrumented::unrank);
+		}
+
+		difference_type distance_to(const iterator& it) const
+		{
+			return static_cast<difference_type>(it.ID()) - ID();
+		}
+
+	private:
+		size_type m_ID{0};
+		multiset m_submulti {};
+		gray_state m_state {};
+		multiset const * m_total {nullptr};
+
+		friend class boost::iterator_core_access;
+	};
+
+	////////////////////////////////////////////////////////////
+	/// \brief Goes through the gray code backwards.
+	///
+	/// The reverse of a reflected gray code is again a reflected gray code, started at the
+	/// last element with every coordinate moving away from the endpoint it is at, so
+	/// increment is also loopless.
+	////////////////////////////////////////////////////////////
+	class reverse_iterator :
+		public boost::iterator_facade<
+					reverse_iterator,
+					const multiset&,
+					boost::bidirectional_traversal_tag
+					>
+	{
+
+	public:
+		reverse_iterator() {}
+
+		reverse_iterator(const multiset& total, size_type size) : m_ID(0), m_size(size), m_submulti(total.size(), 0), m_state(), m_total(&total)
+		{
+			construct_multiset_impl(m_submulti, total, m_state, size - 1, 0, true);
+		}
+
+		reverse_iterator(const reverse_iterator& it) = default; // This is so that the -Weffc++ doesn't complain about me having pointers. I'm not the owner of the pointer anyway.
+		reverse_iterator& operator=(const reverse_iterator& it) = default;
+
+		size_type ID() const
+		{
+			return m_ID;
+		}
+
+		IntType changed_index() const
+		{
+			return m_state.changed;
+		}
+
+		IntType changed_by() const
+		{
+			return m_state.delta;
+		}
+
+		static const reverse_iterator make_invalid_with_id(size_type id)
+		{
+			return reverse_iterator(id);
+		}
+
+	private:
+
+		explicit reverse_iterator(size_type id) : m_ID(id) {}
+
+		//prefix
+		void increment()
+		{
+			instrument(instrumented::multisets_gray, instrumented::step);
+			++m_ID;
+			next_multiset(m_submulti, *m_total, m_state);
+		}
+
+		void decrement()
+		{
+			instrument(instrumented::multisets_gray, instrumented::step);
+			--m_ID;
+			construct_multiset_impl(m_submulti, *m_total, m_state, m_size - m_ID - 1, m_ID, true);
+			instrument(instrumented::multisets_gray, instrumented::unrank);
+		}
+
+		const multiset& dereference() const
+		{
+			return m_submulti;
+		}
+
+		//It only makes sense to compare iterators from the SAME multiset.
+		bool equal(const reverse_iterator& it) const
+		{
+			return m_ID == it.m_ID;
+		}
+
+		difference_type distance_to(const reverse_iterator& other) const
+		{
+			return static_cast<difference_type>(other.ID()) - ID();
+		}
+
+	private:
+		size_type m_ID{0};
+		size_type m_size{0};
+		multiset m_submulti {};
+		gray_state m_state {};
+		multiset const *m_total{nullptr};
+
+		friend class boost::iterator_core_access;
+	};
+
+private:
+	multiset m_total;
+	size_type m_size;
+
+	static size_type calc_size(const multiset& total)
+	{
+		size_type result = 1;
+		for (auto x : total)
+			result = checked_mul<size_type>(result, x + 1);
+		return result;
+	}
+
+	static void init_active(gray_state& state, const multiset& total)
+	{
+		state.active.clear();
+		for (size_t i = 0; i < total.size(); ++i)
+		{
+			if (total[i] > 0)
+				state.active.push_back(i);
+		}
+	}
+
+	// Constructs the submultiset of rank m, with state for walking from step s of the walk.
+	// Going forward s = m, going backwards s = size - 1 - m.
+	static void construct_multiset_impl(multiset& sub, const multiset& total, gray_state& state, size_type m, size_type s, bool reversed)
+	{
+		assert(sub.size() == total.size());
+		init_active(state, total);
+		IntType na = state.active.size();
+		state.focus.resize(na);
+		state.direction.resize(na);
+		state.changed = -1;
+		state.delta = 0;
+
+		for (auto& x : sub) x = 0;
+
+		// Write m in mixed radix (least significant first). If the number formed by the digits
+		// above the j-th is odd, the j-th coordinate is running backwards. A coordinate is passive
+		// (its direction already flipped, waiting for a carry) if its digit of s is the largest one.
+		for (IntType j = 0; j < na; ++j)
+		{
+			IntType i = state.active[j];
+			size_type r = total[i] + 1;
+			size_type b = m%r;
+			m /= r;
+			bool backwards = (m%2 == 1);
+			sub[i] = backwards ? r - 1 - b : b;
+
+			bool passive = (s%r == r - 1);
+			s /= r;
+
+			IntType sweep = (backwards != reversed) ? -1 : 1;
+			state.direction[j] = passive ? -sweep : sweep;
+			state.focus[j] = passive;
+		}
+
+		// A maximal run of passive coordinates j..k-1 has focus[j] = k. Everything else points to itself.
+		IntType j = 0;
+		while (j < na)
+		{
+			if (!state.focus[j])
+			{
+				state.focus[j] = j;
+				++j;
+				continue;
+			}
+
+			IntType k = j + 1;
+			while (k < na && state.focus[k])
+			{
+				state.focus[k] = k;
+				++k;
+			}
+
+			state.focus[j] = k;
+			j = k;
+		}
+	}
+};
+using multisets_gray = basic_multisets_gray<int>;
+using multisets_gray_fast = basic_multisets_gray<int, boost::container::static_vector<int,48>>;
+
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include <vector>
+#include <algorithm>
 #include "Misc.hpp"
 #include <boost/iterator/iterator_facade.hpp>
 #include <cassert>
@@ -5,6 +5,11 @@
 #include <cmath>
 #include <iostream>
 #include <cstdlib>
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <type_traits>
+#include <utility>
 
 #include "TimeHelpers.hpp"
 
@@ -37,26 +42,36 @@ auto divide_work(const Container& C, size_t num_processors) -> std::vector<typen
 }
 
 	
+////////////////////////////////////////////////////////////
+/// \brief Applies f to every element of [first, last), splitting the range into num_processors contiguous blocks, each one in its own thread.
+///
+/// \param thread_times if not null, is filled with how long (in seconds) each thread took. The
+/// slowest over the average is a measure of how well balanced the blocks were.
+////////////////////////////////////////////////////////////
 template <class RAIter, class Function>
-void parallel_for_each(RAIter first, RAIter last, Function f, size_t num_processors)
+void parallel_for_each(RAIter first, RAIter last, Function f, size_t num_processors, std::vector<double>* thread_times = nullptr)
 {
-	using namespace std;
-	Chronometer C;
 	auto work = divide_work(first,last,num_processors);
 	
+	if (thread_times)
+		thread_times->assign(num_processors, 0.0);
+	
 	std::vector<std::thread> threads;
 	threads.reserve(num_processors);
 	
 	for (size_t i = 0; i < num_processors; ++i)
 	{
-		threads.emplace_back(std::thread([&work, &f, i]()
+		threads.emplace_back(std::thread([&work, &f, i, thread_times]()
 		{
+			Chronometer C;
 			auto local_first = work[i];
 			auto local_last = work[i+1];
 			for ( ; local_first != local_last; ++local_first)
 			{
 				f(*local_first);
 			}
+			if (thread_times)
+				(*thread_times)[i] = C.Peek();
 		}));
 	}
 	
@@ -68,9 +83,283 @@ void parallel_for_each(RAIter first, RAIter last, Function f, size_t num_process
 }
 
 template <class Container, class Function>
-void parallel_for_each(Container& C, Function f, size_t num_processors)
+void parallel_for_each(Container& C, Function f, size_t num_processors, std::vector<double>* thread_times = nullptr)
+{
+	parallel_for_each(C.begin(), C.end(), f, num_processors, thread_times);
+}
+
+namespace detail
+{
+// Runs f(i, block_first, block_last) for each of the blocks of divide_work, each one in its own thread.
+template <class RAIter, class Function>
+void for_each_block(RAIter first, RAIter last, Function f, size_t num_processors)
+{
+	num_processors = std::max<size_t>(num_processors, 1);
+	auto work = divide_work(first,last,num_processors);
+
+	std::vector<std::thread> threads;
+	threads.reserve(num_processors);
+
+	for (size_t i = 0; i < num_processors; ++i)
+		threads.emplace_back([&work, &f, i]() { f(i, work[i], work[i+1]); });
+
+	for (auto& t : threads)
+		t.join();
+}
+
+// Runs f(chunk_first, chunk_last, chunk_offset) on consecutive chunks of [first, last), handed out
+// in increasing order to num_processors threads, until the range is exhausted or f returns false.
+template <class RAIter, class Function>
+void for_each_chunk(RAIter first, RAIter last, Function f, size_t num_processors)
+{
+	using difference_type = typename std::iterator_traits<RAIter>::difference_type;
+	num_processors = std::max<size_t>(num_processors, 1);
+
+	const difference_type n = std::distance(first, last);
+	// Small enough that an early match is found early, big enough that jumping to each chunk (an unrank) is noise.
+	const difference_type chunk = std::max<difference_type>(1, std::min<difference_type>(n/(64*num_processors), 1 << 16));
+	std::atomic<difference_type> next {0};
+	std::atomic<bool> stop {false};
+
+	auto worker = [&]()
+	{
+		while (!stop.load(std::memory_order_relaxed))
+		{
+			difference_type begin = next.fetch_add(chunk, std::memory_order_relaxed);
+			if (begin >= n)
+				return;
+
+			difference_type end = std::min(begin + chunk, n);
+			if (!f(first + begin, first + end, begin))
+				stop.store(true, std::memory_order_relaxed);
+		}
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(num_processors);
+	for (size_t i = 0; i < num_processors; ++i)
+		threads.emplace_back(worker);
+	for (auto& t : threads)
+		t.join();
+}
+} // namespace detail
+
+////////////////////////////////////////////////////////////
+/// \brief Number of elements x of [first, last) for which pred(x) is true, counted by num_processors threads.
+////////////////////////////////////////////////////////////
+template <class RAIter, class Predicate>
+long long parallel_count_if(RAIter first, RAIter last, Predicate pred, size_t num_processors)
+{
+	std::vector<long long> counts(std::max<size_t>(num_processors, 1), 0);
+
+	detail::for_each_block(first, last, [&counts, &pred](size_t i, RAIter local_first, RAIter local_last)
+	{
+		long long count = 0;
+		for ( ; local_first != local_last; ++local_first)
+		{
+			if (pred(*local_first))
+				++count;
+		}
+		counts[i] = count;
+	}, num_processors);
+
+	long long total = 0;
+	for (auto c : counts)
+		total += c;
+	return total;
+}
+
+template <class Container, class Predicate>
+long long parallel_count_if(const Container& C, Predicate pred, size_t num_processors)
+{
+	return parallel_count_if(C.begin(), C.end(), pred, num_processors);
+}
+
+////////////////////////////////////////////////////////////
+/// \brief op(init, transform(x)) folded over every x in [first, last), like std::transform_reduce.
+///
+/// Each thread folds its own contiguous block, and then the blocks are folded in order, so op must be
+/// associative (but needn't be commutative) and the result doesn't depend on the number of threads.
+/// init is used only once, so it doesn't need to be an identity of op.
+////////////////////////////////////////////////////////////
+template <class RAIter, class T, class BinaryOp, class UnaryOp>
+T parallel_reduce(RAIter first, RAIter last, T init, BinaryOp op, UnaryOp transform, size_t num_processors)
+{
+	num_processors = std::max<size_t>(num_processors, 1);
+	std::vector<T> partial(num_processors, init);
+	std::vector<char> nonempty(num_processors, false);
+
+	detail::for_each_block(first, last, [&](size_t i, RAIter local_first, RAIter local_last)
+	{
+		if (local_first == local_last)
+			return;
+
+		T value = transform(*local_first);
+		for (++local_first; local_first != local_last; ++local_first)
+			value = op(std::move(value), transform(*local_first));
+
+		partial[i] = std::move(value);
+		nonempty[i] = true;
+	}, num_processors);
+
+	for (size_t i = 0; i < num_processors; ++i)
+	{
+		if (nonempty[i])
+			init = op(std::move(init), std::move(partial[i]));
+	}
+	return init;
+}
+
+template <class Container, class T, class BinaryOp, class UnaryOp>
+T parallel_reduce(const Container& C, T init, BinaryOp op, UnaryOp transform, size_t num_processors)
+{
+	return parallel_reduce(C.begin(), C.end(), init, op, transform, num_processors);
+}
+
+////////////////////////////////////////////////////////////
+/// \brief The first (lowest rank) iterator it in [first, last) with pred(*it), or last if there is none.
+///
+/// The range is handed out in small consecutive chunks. Once some thread finds a match, no thread
+/// starts a chunk after it, and every thread stops scanning as soon as it passes it, so the result
+/// is always the lowest match, and the search ends soon after it's found.
+////////////////////////////////////////////////////////////
+template <class RAIter, class Predicate>
+RAIter parallel_find_first(RAIter first, RAIter last, Predicate pred, size_t num_processors)
+{
+	using difference_type = typename std::iterator_traits<RAIter>::difference_type;
+	const difference_type n = std::distance(first, last);
+	std::atomic<difference_type> best {n};
+
+	detail::for_each_chunk(first, last, [&best, &pred](RAIter it, RAIter chunk_last, difference_type offset)
+	{
+		for ( ; it != chunk_last; ++it, ++offset)
+		{
+			if (offset >= best.load(std::memory_order_relaxed))
+				return false;
+
+			if (pred(*it))
+			{
+				difference_type current = best.load(std::memory_order_relaxed);
+				while (offset < current && !best.compare_exchange_weak(current, offset, std::memory_order_relaxed)) {}
+				return false;
+			}
+		}
+		return true;
+	}, num_processors);
+
+	return first + best.load();
+}
+
+template <class Container, class Predicate>
+auto parallel_find_first(const Container& C, Predicate pred, size_t num_processors)
+{
+	return parallel_find_first(C.begin(), C.end(), pred, num_processors);
+}
+
+////////////////////////////////////////////////////////////
+/// \brief true if pred(x) is true for some x in [first, last). All threads stop as soon as one finds it.
+////////////////////////////////////////////////////////////
+template <class RAIter, class Predicate>
+bool parallel_any_of(RAIter first, RAIter last, Predicate pred, size_t num_processors)
+{
+	using difference_type = typename std::iterator_traits<RAIter>::difference_type;
+	std::atomic<bool> found {false};
+
+	detail::for_each_chunk(first, last, [&found, &pred](RAIter it, RAIter chunk_last, difference_type)
+	{
+		for ( ; it != chunk_last; ++it)
+		{
+			if (pred(*it))
+			{
+				found.store(true, std::memory_order_relaxed);
+				return false;
+			}
+		}
+		return !found.load(std::memory_order_relaxed);
+	}, num_processors);
+
+	return found.load();
+}
+
+template <class Container, class Predicate>
+bool parallel_any_of(const Container& C, Predicate pred, size_t num_processors)
+{
+	return parallel_any_of(C.begin(), C.end(), pred, num_processors);
+}
+
+////////////////////////////////////////////////////////////
+/// \brief The k elements of [first, last) with the largest score(x), best first, along with their scores.
+///
+/// Every thread keeps a heap with the k best of its block, and the heaps are merged at the end. Ties
+/// are broken by rank (the earliest element wins), so the result doesn't depend on the number of threads.
+////////////////////////////////////////////////////////////
+template <class RAIter, class Score>
+auto parallel_top_k(RAIter first, RAIter last, size_t k, Score score, size_t num_processors)
+{
+	using object = std::decay_t<decltype(*first)>;
+	using value = std::decay_t<decltype(score(*first))>;
+	using difference_type = typename std::iterator_traits<RAIter>::difference_type;
+
+	struct candidate
+	{
+		value score;
+		difference_type rank;
+		object x;
+	};
+
+	// a is better than b
+	auto better = [](const candidate& a, const candidate& b)
+	{
+		return a.score > b.score || (!(b.score > a.score) && a.rank < b.rank);
+	};
+
+	num_processors = std::max<size_t>(num_processors, 1);
+	std::vector<std::vector<candidate>> heaps(num_processors);
+
+	if (k > 0)
+	{
+		detail::for_each_block(first, last, [&](size_t i, RAIter local_first, RAIter local_last)
+		{
+			auto& heap = heaps[i]; // the worst of the best k at the front
+			heap.reserve(k + 1);
+			difference_type rank = std::distance(first, local_first);
+
+			for ( ; local_first != local_last; ++local_first, ++rank)
+			{
+				auto s = score(*local_first);
+				if (heap.size() == k && !better(candidate{s, rank, object()}, heap.front()))
+					continue;
+
+				heap.push_back(candidate{s, rank, *local_first});
+				std::push_heap(heap.begin(), heap.end(), better);
+				if (heap.size() > k)
+				{
+					std::pop_heap(heap.begin(), heap.end(), better);
+					heap.pop_back();
+				}
+			}
+		}, num_processors);
+	}
+
+	std::vector<candidate> all;
+	for (auto& heap : heaps)
+		std::move(heap.begin(), heap.end(), std::back_inserter(all));
+
+	std::sort(all.begin(), all.end(), better);
+	if (all.size() > k)
+		all.erase(all.begin() + k, all.end());
+
+	std::vector<std::pair<value, object>> result;
+	result.reserve(all.size());
+	for (auto& c : all)
+		result.emplace_back(c.score, std::move(c.x));
+	return result;
+}
+
+template <class Container, class Score>
+auto parallel_top_k(const Container& C, size_t k, Score score, size_t num_processors)
 {
-	parallel_for_each(C.begin(), C.end(), f, num_processors);
+	return parallel_top_k(C.begin(), C.end(), k, score, num_processors);
 }
 
 } // namespace dscr
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+////////////////////////////////////////////////////////////
+/// \file PartialPredicate.hpp
+/// \brief The depth first search behind find_if and find_all of the combination families.
+///
+/// The search builds the combination one element at a time and prunes every branch whose partial
+/// combination is rejected. A predicate can be given in two forms:
+///
+/// - A *partial predicate*: pred(comb) gets the whole partial combination and returns true or
+///   false. It's simple, but anything it computes (sums, conflict masks, ...) has to be computed
+///   again from scratch at every node of the search tree.
+///
+/// - An *incremental predicate*: an object with the three member functions
+///
+/// 		void on_push(IntType x); // x was just added at the end of the combination
+/// 		void on_pop(IntType x);  // x, the last element, was just removed
+/// 		bool accept() const;     // can the current partial combination be extended?
+///
+///   The search calls them as it walks up and down the tree, so the predicate can keep its
+///   state up to date in O(1) per node instead of O(k). For example, this only accepts
+///   combinations whose sum is at most 50:
+///
+/// 		struct sum_at_most
+/// 		{
+/// 			int sum = 0;
+/// 			void on_push(int x) { sum += x; }
+/// 			void on_pop(int x) { sum -= x; }
+/// 			bool accept() const { return sum <= 50; }
+/// 		};
+/// 		for (auto& x : combinations(30,10).find_all(sum_at_most()))
+/// 			...
+///
+///   Every iterator keeps its own copy of the predicate (along with the combination it describes),
+///   so copy it freely. Unlike a partial predicate, it's also asked about the first element.
+////////////////////////////////////////////////////////////
+
+namespace dscr
+{
+namespace detail
+{
+template <class...>
+using void_t = void;
+} // namespace detail
+
+////////////////////////////////////////////////////////////
+/// \brief true if P has on_push, on_pop and accept (see above).
+////////////////////////////////////////////////////////////
+template <class P, class = void>
+struct is_incremental_predicate : std::false_type {};
+
+template <class P>
+struct is_incremental_predicate<P, detail::void_t<decltype(std::declval<P&>().on_push(0)),
+												  decltype(std::declval<P&>().on_pop(0)),
+												  decltype(bool(std::declval<const P&>().accept()))>> : std::true_type {};
+
+namespace detail
+{
+// Appends x if the predicate accepts the result. Partial predicate version.
+template <class Combination, class P, class IntType>
+bool push_if_accepted(Combination& comb, P& pred, IntType x, std::false_type /*incremental*/)
+{
+	comb.push_back(x);
+
+	if (pred(comb))
+		return true;
+
+	comb.pop_back();
+	return false;
+}
+
+// Incremental predicate version.
+template <class Combination, class P, class IntType>
+bool push_if_accepted(Combination& comb, P& pred, IntType x, std::true_type /*incremental*/)
+{
+	comb.push_back(x);
+	pred.on_push(x);
+
+	if (pred.accept())
+		return true;
+
+	pred.on_pop(x);
+	comb.pop_back();
+	return false;
+}
+
+// The first element is never checked by a partial predicate (that's how find_if has always worked).
+template <class Combination, class P, class IntType>
+bool push_first(Combination& comb, P&, IntType x, std::false_type /*incremental*/)
+{
+	comb.push_back(x);
+	return true;
+}
+
+template <class Combination, class P, class IntType>
+bool push_first(Combination& comb, P& pred, IntType x, std::true_type /*incremental*/)
+{
+	return push_if_accepted(comb, pred, x, std::true_type());
+}
+
+template <class Combination, class P>
+void pop(Combination& comb, P&, std::false_type /*incremental*/)
+{
+	comb.pop_back();
+}
+
+template <class Combination, class P>
+void pop(Combination& comb, P& pred, std::true_type /*incremental*/)
+{
+	auto x = comb.back();
+	comb.pop_back();
+	pred.on_pop(x);
+}
+
+////////////////////////////////////////////////////////////
+/// \brief Tries to add one more element, at least start, to comb (a partial k-subset of [0,n)).
+////////////////////////////////////////////////////////////
+template <class Combination, class P, class IntType>
+bool augment(Combination& comb, P& pred, IntType n, IntType k, IntType start = 0)
+{
+	using incremental = is_incremental_predicate<P>;
+
+	if (comb.empty())
+	{
+		for ( ; start < n - k + 1; ++start)
+		{
+			if (push_first(comb, pred, start, incremental()))
+				return true;
+		}
+		return false;
+	}
+
+	auto last = comb.back();
+	IntType guysleft = k - comb.size();
+
+	start = std::max(static_cast<IntType>(last + 1), start);
+
+	for (IntType i = start; i < n - guysleft + 1; ++i)
+	{
+		if (push_if_accepted(comb, pred, i, incremental()))
+			return true;
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////
+/// \brief Moves comb to the next node of the (prunned) search tree, in depth first order.
+///
+/// \return false when the search is over.
+////////////////////////////////////////////////////////////
+template <class Combination, class P, class IntType>
+bool DFSUtil(Combination& comb, P& pred, IntType n, IntType k)
+{
+	using incremental = is_incremental_predicate<P>;
+
+	if (comb.size() < static_cast<std::size_t>(k))
+	{
+		if (augment(comb, pred, n, k))
+			return true;
+	}
+
+	// If it can't be augmented, be it because size is already k or else, we have to start backtracking
+	while (!comb.empty())
+	{
+		IntType last = comb.back();
+		pop(comb, pred, incremental());
+
+		if (augment(comb, pred, n, k, static_cast<IntType>(last + 1)))
+			return true;
+	}
+
+	return false;
+}
+} // namespace detail
+} // namespace dscr
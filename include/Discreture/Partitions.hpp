@@ -1,9 +1,13 @@
 #pragma once
 
+#include <iterator>
+#include <numeric>
 #include "VectorHelpers.hpp"
 #include "Misc.hpp"
 #include "Sequences.hpp"
 #include "NumberRange.hpp"
+#include "Instrumentation.hpp"
+#include "Subrange.hpp"
 #include <boost/iterator/iterator_facade.hpp>
 
 namespace dscr
@@ -231,6 +235,61 @@ public:
 	{
 		return reverse_iterator::make_invalid_with_id(size());
 	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief An iterator pointing at x, which must be the id-th partition in the order of iteration.
+	///
+	/// This is how an iteration is resumed from a checkpoint (see Checkpoint.hpp): it takes O(n), instead of iterating id times.
+	////////////////////////////////////////////////////////////
+	iterator resume(size_type id, const partition& x) const
+	{
+		assert(0 <= id && id < size());
+		assert(std::accumulate(x.begin(), x.end(), IntType(0)) == m_n);
+		return iterator(m_n, id, x);
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief An iterator pointing at the id-th partition.
+	///
+	/// Partitions can't be unranked (yet), but they are iterated by number of parts, and the number
+	/// of partitions with each number of parts is known. So this jumps straight to the first one
+	/// with the right number of parts, and only iterates from there.
+	////////////////////////////////////////////////////////////
+	iterator skip_to(size_type id) const
+	{
+		assert(0 <= id && id <= size());
+		if (id == size())
+			return end();
+
+		IntType parts = m_maxnumparts;
+		size_type first = 0;
+		while (true)
+		{
+			size_type block = partition_number(m_n, parts);
+			if (id < first + block)
+				break;
+			first += block;
+			--parts;
+		}
+
+		partition x;
+		first_with_given_number_of_parts(x, m_n, parts);
+		iterator it(m_n, first, x);
+		std::advance(it, id - first);
+		return it;
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief The partitions of ranks [first, last) (see Subrange.hpp).
+	////////////////////////////////////////////////////////////
+	subrange<iterator> range(size_type first, size_type last) const
+	{
+		assert(0 <= first && first <= last && last <= size());
+		auto end = iterator::make_invalid_with_id(last);
+		if (first == last)
+			return subrange<iterator>(end, end);
+		return subrange<iterator>(skip_to(first), end);
+	}
 	
 	////////////////////////////////////////////////////////////
 	/// \brief Bidirectional iterator class.
@@ -251,6 +310,8 @@ public:
 			if (numparts > 0)
 				m_data[0] = n - numparts + 1;
 		}
+
+		iterator(IntType n, size_type id, const partition& current) : m_ID(id), m_n(n), m_data(current) {}
 		
 		inline size_type ID() const
 		{
@@ -269,16 +330,24 @@ public:
 	private:
 		void increment()
 		{
+			instrument(instrumented::partitions, instrumented::step);
 			++m_ID;
 
+			auto parts = m_data.size();
 			next_partition(m_data, m_n);
+			if (m_data.size() != parts)
+				instrument(instrumented::partitions, instrumented::reset);
 		}
 		
 		void decrement()
 		{
+			instrument(instrumented::partitions, instrumented::step);
 			--m_ID;
 
+			auto parts = m_data.size();
 			prev_partition(m_data, m_n);
+			if (m_data.size() != parts)
+				instrument(instrumented::partitions, instrumented::reset);
 		}
 		
 		const partition& dereference() const
@@ -340,16 +409,24 @@ public:
 	private:
 		void increment()
 		{
+			instrument(instrumented::partitions, instrumented::step);
 			++m_ID;
 
+			auto parts = m_data.size();
 			prev_partition(m_data, m_n);
+			if (m_data.size() != parts)
+				instrument(instrumented::partitions, instrumented::reset);
 		}
 		
 		void decrement()
 		{
+			instrument(instrumented::partitions, instrumented::step);
 			--m_ID;
 
+			auto parts = m_data.size();
 			next_partition(m_data, m_n);
+			if (m_data.size() != parts)
+				instrument(instrumented::partitions, instrumented::reset);
 		}
 		
 		const partition& dereference() const
@@ -395,7 +472,7 @@ private:
 	{
 		size_type toReturn = 0;
 		for (size_type k = minnumparts; k <= maxnumparts; ++k)
-			toReturn += partition_number(n, k);
+			toReturn = checked_add<size_type>(toReturn, partition_number(n, k));
 		return toReturn;
 	}
 	
@@ -5,6 +5,8 @@
 #include "NumberRange.hpp"
 #include "Probability.hpp"
 #include "CompoundContainer.hpp"
+#include "Instrumentation.hpp"
+#include "Subrange.hpp"
 
 #include <algorithm>
 #include <numeric>
@@ -151,6 +153,7 @@ public:
 		assert(m >= 0 && m < size());
 		permutation perm(m_n);
 		construct_permutation(perm,m);
+		instrument(instrumented::permutations, instrumented::unrank);
 		return perm;
 	}
 	
@@ -192,34 +195,43 @@ public:
 	size_type get_index(const permutation& perm, size_type start = 0) const
 	{
 		size_type n = perm.size();
+		size_type result = 0;
 
-		if (n < 2)
-			return 0;
-
-		RAContainerInt sortedperm(perm.begin() + start, perm.end());
-		std::sort(sortedperm.begin(), sortedperm.end());
-		size_type i = 0;
-
-		while (start < n)
+		// Lehmer code: digit i is how many elements after position i are smaller than perm[i].
+		// No copy of the suffix is needed, and n is small enough (n! must fit) for this to be quadratic.
+		for (size_type i = start; i + 1 < n; ++i)
 		{
-			if (perm[start] != sortedperm[i])
-			{
-				break;
-			}
+			size_type smaller = 0;
+			for (size_type j = i + 1; j < n; ++j)
+				smaller += (perm[j] < perm[i]);
 
-			++start;
-			++i;
+			if (smaller != 0)
+				result += factorial(n - i - 1)*smaller;
 		}
 
-		if (start == n)
-			return 0;
+		return result;
+	}
 
-		size_type b = n - start - 1;
-		auto w = std::lower_bound(sortedperm.begin(), sortedperm.end(), perm[start]) - sortedperm.begin() - i;
 
-		return factorial(b) * (w) + get_index(perm, start + 1);
+	////////////////////////////////////////////////////////////
+	/// \brief The permutations of ranks [first, last) (see Subrange.hpp).
+	////////////////////////////////////////////////////////////
+	subrange<iterator> range(size_type first, size_type last) const
+	{
+		return make_subrange(*this, first, last);
 	}
 
+	////////////////////////////////////////////////////////////
+	/// \brief The i-th of num_shards consecutive slices of the permutations, of (almost) equal sizes.
+	///
+	/// For splitting the work among processes or machines: the shards of i = 0, 1, ..., num_shards-1
+	/// are disjoint and cover everything, and each one unranks only once, at its start.
+	////////////////////////////////////////////////////////////
+	subrange<iterator> shard(size_type i, size_type num_shards) const
+	{
+		auto bounds = shard_bounds(size(), i, num_shards);
+		return range(bounds.first, bounds.second);
+	}
 
 	////////////////////////////////////////////////////////////
 	/// \brief Random access iterator class. It's much more efficient as a bidirectional iterator than purely random access.
@@ -243,6 +255,7 @@ public:
 
 		void reset(IntType r)
 		{
+			instrument(instrumented::permutations, instrumented::reset);
 			m_ID = 0;
 			m_last = r-1;
 			m_data.resize(r);
@@ -266,6 +279,7 @@ public:
 		
 		void increment()
 		{
+			instrument(instrumented::permutations, instrumented::step);
 			if (m_ID > 1 && m_ID%2 == 0)
 			{
 				std::swap(m_data[m_last],m_data[m_last-1]);
@@ -278,6 +292,7 @@ public:
 
 		void decrement()
 		{
+			instrument(instrumented::permutations, instrumented::step);
 			if (m_ID == 0)
 				return;
 
@@ -322,6 +337,7 @@ public:
 			// If n is large, then it's better to just construct it from scratch.
 			m_ID += n;
 			construct_permutation(m_data, m_ID);
+			instrument(instrumented::permutations, instrumented::unrank);
 			return;
 
 		}
@@ -368,6 +384,7 @@ public:
 		
 		void reset(IntType n)
 		{
+			instrument(instrumented::permutations, instrumented::reset);
 			m_ID = 0;
 			m_data = basic_number_range<IntType>(n);
 			std::reverse(m_data.begin(), m_data.end());
@@ -383,6 +400,7 @@ public:
 	private:
 		void increment()
 		{
+			instrument(instrumented::permutations, instrumented::step);
 			++m_ID;
 
 			std::prev_permutation(m_data.begin(), m_data.end());
@@ -390,6 +408,7 @@ public:
 
 		void decrement()
 		{
+			instrument(instrumented::permutations, instrumented::step);
 			if (m_ID == 0)
 				return;
 
@@ -432,6 +451,7 @@ public:
 			// If n is large, then it's better to just construct it from scratch.
 			m_ID += m;
 			construct_permutation(m_data, factorial(m_data.size()) - m_ID - 1);
+			instrument(instrumented::permutations, instrumented::unrank);
 		}
 		
 		bool equal(const reverse_iterator& it) const
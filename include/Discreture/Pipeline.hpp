@@ -0,0 +1,364 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Subrange.hpp"
+
+////////////////////////////////////////////////////////////
+/// \file Pipeline.hpp
+/// \brief A producer/consumer pipeline: enumerator threads fill batches of objects, worker threads consume them.
+///
+/// parallel_for_each splits the range into fixed blocks, so when the work per object varies a lot
+/// some threads finish long before others. In pipeline_for_each the enumerators run the usual
+/// successor loop and copy the objects into batches, which go through a lock-free queue to the
+/// consumers, so every consumer keeps taking batches until there are none left. The batches are
+/// allocated once and reused, and when the queue is full the enumerators wait (backpressure), so
+/// the memory used is bounded no matter how slow the consumers are.
+////////////////////////////////////////////////////////////
+
+namespace dscr
+{
+////////////////////////////////////////////////////////////
+/// \brief Lock-free single producer, single consumer ring buffer.
+///
+/// Capacity is rounded up to a power of 2.
+////////////////////////////////////////////////////////////
+template <class T>
+class spsc_ring
+{
+public:
+	explicit spsc_ring(std::size_t capacity) : m_capacity(round_up(capacity)), m_mask(m_capacity - 1), m_buffer(new T[m_capacity]) {}
+
+	std::size_t capacity() const { return m_capacity; }
+
+	bool try_push(T value)
+	{
+		std::size_t tail = m_tail.load(std::memory_order_relaxed);
+		if (tail - m_head.load(std::memory_order_acquire) == m_capacity)
+			return false;
+
+		m_buffer[tail & m_mask] = std::move(value);
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool try_pop(T& value)
+	{
+		std::size_t head = m_head.load(std::memory_order_relaxed);
+		if (head == m_tail.load(std::memory_order_acquire))
+			return false;
+
+		value = std::move(m_buffer[head & m_mask]);
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	static std::size_t round_up(std::size_t n)
+	{
+		std::size_t p = 1;
+		while (p < n)
+			p *= 2;
+		return p;
+	}
+
+private:
+	std::size_t m_capacity;
+	std::size_t m_mask;
+	std::unique_ptr<T[]> m_buffer;
+	alignas(64) std::atomic<std::size_t> m_head {0}; // only written by the consumer
+	alignas(64) std::atomic<std::size_t> m_tail {0}; // only written by the producer
+};
+
+////////////////////////////////////////////////////////////
+/// \brief Lock-free multiple producer, multiple consumer bounded queue (Vyukov's algorithm).
+///
+/// Every cell has a sequence number that says whether it's ready to be written or to be read in the
+/// current lap, so producers and consumers only contend on their own counter. Capacity is rounded
+/// up to a power of 2.
+////////////////////////////////////////////////////////////
+template <class T>
+class mpmc_ring
+{
+public:
+	explicit mpmc_ring(std::size_t capacity) : m_capacity(spsc_ring<T>::round_up(std::max<std::size_t>(capacity, 2))),
+												m_mask(m_capacity - 1),
+												m_cells(new cell[m_capacity])
+	{
+		for (std::size_t i = 0; i < m_capacity; ++i)
+			m_cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	std::size_t capacity() const { return m_capacity; }
+
+	bool try_push(T value)
+	{
+		std::size_t pos = m_enqueue.load(std::memory_order_relaxed);
+		cell* c;
+		while (true)
+		{
+			c = &m_cells[pos & m_mask];
+			std::size_t seq = c->sequence.load(std::memory_order_acquire);
+			auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+
+			if (diff == 0)
+			{
+				if (m_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+			{
+				return false; // full
+			}
+			else
+			{
+				pos = m_enqueue.load(std::memory_order_relaxed);
+			}
+		}
+
+		c->value = std::move(value);
+		c->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool try_pop(T& value)
+	{
+		std::size_t pos = m_dequeue.load(std::memory_order_relaxed);
+		cell* c;
+		while (true)
+		{
+			c = &m_cells[pos & m_mask];
+			std::size_t seq = c->sequence.load(std::memory_order_acquire);
+			auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+
+			if (diff == 0)
+			{
+				if (m_dequeue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+			{
+				return false; // empty
+			}
+			else
+			{
+				pos = m_dequeue.load(std::memory_order_relaxed);
+			}
+		}
+
+		value = std::move(c->value);
+		c->sequence.store(pos + m_capacity, std::memory_order_release);
+		return true;
+	}
+
+private:
+	struct cell
+	{
+		std::atomic<std::size_t> sequence;
+		T value;
+	};
+
+	std::size_t m_capacity;
+	std::size_t m_mask;
+	std::unique_ptr<cell[]> m_cells;
+	alignas(64) std::atomic<std::size_t> m_enqueue {0};
+	alignas(64) std::atomic<std::size_t> m_dequeue {0};
+};
+
+////////////////////////////////////////////////////////////
+/// \brief How pipeline_for_each splits the work.
+////////////////////////////////////////////////////////////
+struct pipeline_options
+{
+	std::size_t batch_size {1024}; // objects per batch
+	std::size_t queue_capacity {64}; // batches that can be waiting for a consumer (backpressure)
+	std::size_t num_producers {1}; // enumerator threads. Families without random access use only one.
+	std::size_t num_consumers {std::max(1U, std::thread::hardware_concurrency())};
+};
+
+////////////////////////////////////////////////////////////
+/// \brief What happened in a pipeline_for_each.
+////////////////////////////////////////////////////////////
+struct pipeline_stats
+{
+	long long batches {0}; // batches consumed
+	long long producer_waits {0}; // times an enumerator found no free batch (the consumers are the bottleneck)
+	long long consumer_waits {0}; // times a consumer found the queue empty (the enumerators are the bottleneck)
+};
+
+namespace detail
+{
+template <class Object>
+struct pipeline_batch
+{
+	std::vector<Object> items;
+	std::size_t count {0};
+};
+
+template <class Iterator>
+void producer_ranges(std::vector<subrange<Iterator>>& ranges, const subrange<Iterator>& all, std::size_t num_producers, std::random_access_iterator_tag)
+{
+	for (std::size_t i = 0; i < num_producers; ++i)
+	{
+		auto bounds = shard_bounds(all.size(), i, num_producers);
+		auto end = Iterator::make_invalid_with_id(bounds.second);
+		ranges.emplace_back(bounds.first == bounds.second ? end : all.begin() + bounds.first, end);
+	}
+}
+
+// Without random access, a single enumerator does everything.
+template <class Iterator>
+void producer_ranges(std::vector<subrange<Iterator>>& ranges, const subrange<Iterator>& all, std::size_t, std::forward_iterator_tag)
+{
+	ranges.push_back(all);
+}
+
+template <template <class> class Queue, class Iterator, class Function>
+pipeline_stats run_pipeline(const std::vector<subrange<Iterator>>& ranges, Function& f, const pipeline_options& options)
+{
+	using object = std::decay_t<decltype(*std::declval<Iterator>())>;
+	using batch = pipeline_batch<object>;
+
+	// No batch needs to be bigger than the biggest range.
+	long long largest = 1;
+	for (auto& r : ranges)
+		largest = std::max(largest, r.size());
+	const std::size_t batch_size = std::min<std::size_t>(std::max<std::size_t>(options.batch_size, 1), largest);
+	const std::size_t num_consumers = std::max<std::size_t>(options.num_consumers, 1);
+
+	// Every batch is either being filled, in the queue, being consumed, or free.
+	Queue<batch*> full(options.queue_capacity);
+	std::size_t num_batches = full.capacity() + ranges.size() + num_consumers;
+	Queue<batch*> free(num_batches);
+	std::vector<batch> batches(num_batches);
+	for (auto& b : batches)
+	{
+		b.items.resize(batch_size);
+		free.try_push(&b);
+	}
+
+	std::atomic<std::size_t> producers_left {ranges.size()};
+	std::atomic<long long> producer_waits {0};
+	std::atomic<long long> consumer_waits {0};
+	std::atomic<long long> consumed {0};
+
+	auto get_free = [&free, &producer_waits]()
+	{
+		batch* b;
+		while (!free.try_pop(b))
+		{
+			producer_waits.fetch_add(1, std::memory_order_relaxed);
+			std::this_thread::yield();
+		}
+		return b;
+	};
+
+	auto send = [&full](batch* b)
+	{
+		while (!full.try_push(b))
+			std::this_thread::yield();
+	};
+
+	// Only the consumers ever push into free: with one producer and one consumer it's an spsc_ring.
+	// So a producer takes a batch only when it has an object to put in it, and never gives one back.
+	auto produce = [&](const subrange<Iterator>& range)
+	{
+		auto it = range.begin();
+		batch* b = nullptr;
+
+		for (auto left = range.size(); left > 0; --left, ++it)
+		{
+			if (!b)
+			{
+				b = get_free();
+				b->count = 0;
+			}
+
+			b->items[b->count++] = *it;
+			if (b->count == batch_size)
+			{
+				send(b);
+				b = nullptr;
+			}
+		}
+
+		if (b)
+			send(b);
+
+		producers_left.fetch_sub(1, std::memory_order_release);
+	};
+
+	auto consume = [&]()
+	{
+		batch* b;
+		while (true)
+		{
+			// Read before trying to pop: producers leave only after their last push, so if there were
+			// none left and the queue is empty anyway, it's over.
+			bool done = producers_left.load(std::memory_order_acquire) == 0;
+
+			if (full.try_pop(b))
+			{
+				for (std::size_t i = 0; i < b->count; ++i)
+					f(static_cast<const object&>(b->items[i]));
+				consumed.fetch_add(1, std::memory_order_relaxed);
+				free.try_push(b);
+				continue;
+			}
+
+			if (done)
+				return;
+
+			consumer_waits.fetch_add(1, std::memory_order_relaxed);
+			std::this_thread::yield();
+		}
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(ranges.size() + num_consumers);
+	for (auto& r : ranges)
+		threads.emplace_back(produce, std::cref(r));
+	for (std::size_t i = 0; i < num_consumers; ++i)
+		threads.emplace_back(consume);
+	for (auto& t : threads)
+		t.join();
+
+	pipeline_stats stats;
+	stats.batches = consumed.load();
+	stats.producer_waits = producer_waits.load();
+	stats.consumer_waits = consumer_waits.load();
+	return stats;
+}
+} // namespace detail
+
+////////////////////////////////////////////////////////////
+/// \brief Applies f to every object of X, enumerated by options.num_producers threads and consumed by options.num_consumers threads.
+///
+/// f is shared by all the consumers, so it must be safe to call concurrently, and the order in which
+/// the objects are processed is unspecified. With one producer and one consumer the queue is an
+/// spsc_ring, and otherwise an mpmc_ring.
+////////////////////////////////////////////////////////////
+template <class Container, class Function>
+pipeline_stats pipeline_for_each(const Container& X, Function f, const pipeline_options& options = pipeline_options())
+{
+	using iterator = typename Container::iterator;
+	using category = typename std::iterator_traits<iterator>::iterator_category;
+
+	subrange<iterator> all(X.begin(), iterator::make_invalid_with_id(X.size()));
+	std::vector<subrange<iterator>> ranges;
+	detail::producer_ranges(ranges, all, std::max<std::size_t>(options.num_producers, 1), category());
+
+	if (ranges.size() == 1 && options.num_consumers <= 1)
+		return detail::run_pipeline<spsc_ring>(ranges, f, options);
+
+	return detail::run_pipeline<mpmc_ring>(ranges, f, options);
+}
+} // namespace dscr
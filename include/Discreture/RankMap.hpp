@@ -0,0 +1,174 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "Combinations.hpp"
+#include "Permutations.hpp"
+#include "Multisets.hpp"
+
+////////////////////////////////////////////////////////////
+/// \file RankMap.hpp
+/// \brief Maps whose keys are the objects of a family, stored as a flat array indexed by rank.
+///
+/// get_index is a bijection between a family and [0, size()), so a map keyed by, say, the
+/// k-subsets of [0,n) needs no hashing and no stored keys: the value of x is at position
+/// get_index(x) of an array. When the key comes from an iterator it's even cheaper, since the
+/// iterator already knows its rank (ID()).
+///
+/// 	dscr::combination_map<double> best(20,6); // C(20,6) doubles, all 0
+/// 	for (auto it = X.begin(); it != X.end(); ++it)
+/// 		best.at(it) = f(*it); // no get_index at all
+/// 	...
+/// 	best[{1,4,5,9,12,19}] += 1.0; // get_index: O(k)
+///
+/// The values are kept in a std::vector<T> by default. For tables too big for memory, use a
+/// dscr::mapped_array<T> (from BinaryExport.hpp), which keeps them in a file instead.
+////////////////////////////////////////////////////////////
+
+namespace dscr
+{
+////////////////////////////////////////////////////////////
+/// \brief A map from the objects of Family to T, stored in Storage (a random access container of T) by rank.
+////////////////////////////////////////////////////////////
+template <class Family, class T, class Storage = std::vector<T>>
+class rank_map
+{
+public:
+	using family_type = Family;
+	using key_type = typename Family::value_type;
+	using mapped_type = T;
+	using storage_type = Storage;
+	using size_type = long long;
+	using family_iterator = typename Family::iterator;
+
+	////////////////////////////////////////////////////////////
+	/// \brief Every object of X is mapped to init.
+	////////////////////////////////////////////////////////////
+	explicit rank_map(const Family& X, const T& init = T()) : m_family(X), m_values(X.size(), init) {}
+
+	////////////////////////////////////////////////////////////
+	/// \brief The values are in values, which must have exactly X.size() of them (e.g. a mapped_array).
+	////////////////////////////////////////////////////////////
+	rank_map(const Family& X, Storage values) : m_family(X), m_values(std::move(values))
+	{
+		if (static_cast<size_type>(m_values.size()) != static_cast<size_type>(m_family.size()))
+			throw std::invalid_argument("dscr::rank_map: the storage must have exactly one value per object");
+	}
+
+	const Family& family() const { return m_family; }
+
+	size_type size() const { return m_values.size(); }
+
+	////////////////////////////////////////////////////////////
+	/// \brief The rank of x, i.e. where its value is.
+	////////////////////////////////////////////////////////////
+	size_type index(const key_type& x) const { return m_family.get_index(x); }
+
+	T& operator[](const key_type& x) { return m_values[index(x)]; }
+	const T& operator[](const key_type& x) const { return m_values[index(x)]; }
+
+	////////////////////////////////////////////////////////////
+	/// \brief The value of *it, with no need to compute its rank.
+	////////////////////////////////////////////////////////////
+	T& at(const family_iterator& it) { return m_values[it.ID()]; }
+	const T& at(const family_iterator& it) const { return m_values[it.ID()]; }
+
+	////////////////////////////////////////////////////////////
+	/// \brief The value of the object of rank r.
+	////////////////////////////////////////////////////////////
+	T& at_rank(size_type r) { assert(0 <= r && r < size()); return m_values[r]; }
+	const T& at_rank(size_type r) const { assert(0 <= r && r < size()); return m_values[r]; }
+
+	////////////////////////////////////////////////////////////
+	/// \brief Writes the value of each key in [first, last) to out. Returns the end of the output.
+	////////////////////////////////////////////////////////////
+	template <class KeyIterator, class OutputIterator>
+	OutputIterator get_many(KeyIterator first, KeyIterator last, OutputIterator out) const
+	{
+		for ( ; first != last; ++first, ++out)
+			*out = (*this)[*first];
+		return out;
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief Writes the values of the objects of ranks [first_rank, last_rank) to out, which are contiguous.
+	////////////////////////////////////////////////////////////
+	template <class OutputIterator>
+	OutputIterator get_range(size_type first_rank, size_type last_rank, OutputIterator out) const
+	{
+		assert(0 <= first_rank && first_rank <= last_rank && last_rank <= size());
+		for ( ; first_rank != last_rank; ++first_rank, ++out)
+			*out = m_values[first_rank];
+		return out;
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief Applies f(key, value) to every entry, in rank order. The keys are generated, not stored.
+	////////////////////////////////////////////////////////////
+	template <class Func>
+	void for_each(Func f)
+	{
+		size_type r = 0;
+		for (auto& x : m_family)
+			f(x, m_values[r++]);
+	}
+
+	template <class Func>
+	void for_each(Func f) const
+	{
+		size_type r = 0;
+		for (auto& x : m_family)
+			f(x, static_cast<const T&>(m_values[r++]));
+	}
+
+	Storage& values() { return m_values; }
+	const Storage& values() const { return m_values; }
+
+private:
+	Family m_family;
+	Storage m_values;
+};
+
+////////////////////////////////////////////////////////////
+/// \brief A map keyed by the k-subsets of {0,...,n-1}.
+////////////////////////////////////////////////////////////
+template <class T, class Storage = std::vector<T>>
+class combination_map : public rank_map<combinations, T, Storage>
+{
+	using base = rank_map<combinations, T, Storage>;
+public:
+	combination_map(int n, int k, const T& init = T()) : base(combinations(n,k), init) {}
+	combination_map(int n, int k, Storage values) : base(combinations(n,k), std::move(values)) {}
+	using base::operator[];
+};
+
+////////////////////////////////////////////////////////////
+/// \brief A map keyed by the permutations of {0,...,n-1}.
+////////////////////////////////////////////////////////////
+template <class T, class Storage = std::vector<T>>
+class permutation_map : public rank_map<permutations, T, Storage>
+{
+	using base = rank_map<permutations, T, Storage>;
+public:
+	explicit permutation_map(int n, const T& init = T()) : base(permutations(n), init) {}
+	permutation_map(int n, Storage values) : base(permutations(n), std::move(values)) {}
+	using base::operator[];
+};
+
+////////////////////////////////////////////////////////////
+/// \brief A map keyed by the submultisets of total.
+////////////////////////////////////////////////////////////
+template <class T, class Storage = std::vector<T>>
+class multiset_map : public rank_map<multisets, T, Storage>
+{
+	using base = rank_map<multisets, T, Storage>;
+public:
+	explicit multiset_map(const multisets::multiset& total, const T& init = T()) : base(multisets(total), init) {}
+	multiset_map(const multisets::multiset& total, Storage values) : base(multisets(total), std::move(values)) {}
+	using base::operator[];
+};
+} // namespace dscr
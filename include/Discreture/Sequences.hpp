@@ -1,6 +1,9 @@
 #pragma once
 #include <vector>
 #include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
 #include "Misc.hpp"
 #include "VectorHelpers.hpp"
 namespace dscr
@@ -12,6 +15,7 @@ using llint = long long int;
 /// \brief n!
 /// \param n is a (small) nonnegative integer.
 /// \return n!
+/// \throws std::overflow_error if the result does not fit in BigIntType (builtin integer types only).
 //////////////////////////////
 template <class BigIntType = llint>
 inline BigIntType factorial(llint n);
@@ -21,6 +25,7 @@ inline BigIntType factorial(llint n);
 /// \param n is a (small) nonnegative integer
 /// \param r is a small integer between 0 and n (inclusive)
 /// \return n!/(r!*(n-r)!)
+/// \throws std::overflow_error if the result does not fit in BigIntType (builtin integer types only).
 //////////////////////////////
 template <class BigIntType = llint>
 inline BigIntType binomial(llint n, llint r);
@@ -29,14 +34,26 @@ inline BigIntType binomial(llint n, llint r);
 /// \brief The n-th catalan number.
 /// \param n is a (small) nonnegative integer
 /// \return binomial(2n,n)/(n+1)
+/// \throws std::overflow_error if the result does not fit in BigIntType (builtin integer types only).
 //////////////////////////////
 template <class BigIntType = llint>
 inline BigIntType catalan(llint n);
 
+//////////////////////////////
+/// \brief The number of paths with n steps of +1 or -1 from height 0 to height h which never go below 0.
+/// \param n is a (small) nonnegative integer
+/// \param h is an integer. If h < 0, h > n or n+h is odd, there are no such paths.
+/// \return binomial(n,(n+h)/2) - binomial(n,(n+h)/2+1)
+/// \throws std::overflow_error if the result does not fit in BigIntType (builtin integer types only).
+//////////////////////////////
+template <class BigIntType = llint>
+inline BigIntType ballot_number(llint n, llint h);
+
 //////////////////////////////
 /// \brief The n-th motzkin number.
 /// \param n is a (small) nonnegative integer
 /// \return M_n
+/// \throws std::overflow_error if the result does not fit in BigIntType (builtin integer types only).
 //////////////////////////////
 template <class BigIntType = llint>
 inline BigIntType motzkin(llint n);
@@ -46,6 +63,7 @@ inline BigIntType motzkin(llint n);
 /// \brief The n-th partition number
 /// \param n is a (small) nonnegative integer
 /// \return P_n
+/// \throws std::overflow_error if the result does not fit in BigIntType (builtin integer types only).
 //////////////////////////////
 template <class BigIntType = llint>
 inline BigIntType partition_number(llint n);
@@ -55,6 +73,7 @@ inline BigIntType partition_number(llint n);
 /// \param n is a (small) nonnegative integer
 /// \param k <= n is a (small) nonnegative integer
 /// \return P_{n,k}
+/// \throws std::overflow_error if the result does not fit in BigIntType (builtin integer types only).
 //////////////////////////////
 template <class BigIntType = llint>
 inline BigIntType partition_number(llint n, llint k);
@@ -64,6 +83,7 @@ inline BigIntType partition_number(llint n, llint k);
 /// \param n is a (small) nonnegative integer
 /// \param k <= n is a (small) nonnegative integer
 /// \return The stirling number of the first kind S(n,k)
+/// \throws std::overflow_error if the result does not fit in BigIntType (builtin integer types only).
 //////////////////////////////
 template <class BigIntType = llint>
 inline BigIntType stirling_cycle_number(llint n, llint k);
@@ -73,6 +93,7 @@ inline BigIntType stirling_cycle_number(llint n, llint k);
 /// \param n is a (small) nonnegative integer
 /// \param k <= n is a (small) nonnegative integer
 /// \return The stirling number of the second kind S_{n,k}
+/// \throws std::overflow_error if the result does not fit in BigIntType (builtin integer types only).
 //////////////////////////////
 template <class BigIntType = llint>
 inline BigIntType stirling_partition_number(llint n, llint k);
@@ -85,6 +106,110 @@ inline BigIntType stirling_partition_number(llint n, llint k);
 template <class BigIntType = llint>
 inline BigIntType generalized_pentagonal(llint n);
 
+namespace detail
+{
+// The tables of the sequences below are shared by every thread, and size() and get_index() of the
+// families read them from many threads at once. For builtin integers every entry that fits is
+// computed once, the first time (a function-local static, so it's thread safe), and then the
+// table is only read. Other types (cpp_int, ...) have no such limit, so their tables grow as
+// needed, under a lock. extend(table) appends one more row and returns false when there are
+// enough (or throws std::overflow_error when the next row doesn't fit).
+template <class BigIntType, class Table, class Extend, class Get>
+BigIntType sequence_entry(const Table& seed, Extend extend, llint n, Get get, std::true_type /*builtin*/)
+{
+	static const Table table = [&seed, &extend]()
+	{
+		Table t = seed;
+		try
+		{
+			while (extend(t)) {}
+		}
+		catch (const std::overflow_error&) {}
+		return t;
+	}();
+
+	if (n >= static_cast<llint>(table.size()))
+		throw_overflow("dscr: integer overflow in a counting sequence");
+	return get(table);
+}
+
+template <class BigIntType, class Table, class Extend, class Get>
+BigIntType growing_sequence_entry(const Table& seed, Extend extend, llint n, Get get)
+{
+	static Table table = seed;
+	static std::mutex mutex;
+	std::lock_guard<std::mutex> lock(mutex);
+
+	// Rows are only added once they are completely computed, so an overflow never leaves the table in a bad state.
+	while (n >= static_cast<llint>(table.size()) && extend(table)) {}
+	return get(table);
+}
+
+template <class BigIntType, class Table, class Extend, class Get>
+BigIntType sequence_entry(const Table& seed, Extend extend, llint n, Get get, std::false_type /*builtin*/)
+{
+	return growing_sequence_entry<BigIntType>(seed, extend, n, get);
+}
+
+template <class BigIntType, class Table, class Extend, class Get>
+BigIntType sequence_entry(const Table& seed, Extend extend, llint n, Get get)
+{
+	return sequence_entry<BigIntType>(seed, extend, n, get, is_builtin_integer<BigIntType>());
+}
+
+// An entry of the triangular tables (binomial, partitions in k parts, stirling numbers). Unlike
+// the sequences above, a row can have entries that don't fit next to entries that do (S(n,1) = 1
+// for every n), so the rows are never cut short: each entry records whether it fits, and only
+// reading one that doesn't throws. Except for binomial, whose table stops at n = 66, they have
+// no last row even for builtin integers, so they use growing_sequence_entry.
+template <class T>
+struct triangle_entry
+{
+	T value;
+	bool fits;
+};
+
+template <class T>
+using triangle = std::vector<std::vector<triangle_entry<T>>>;
+
+template <class T>
+triangle<T> make_triangle(std::initializer_list<std::initializer_list<llint>> rows)
+{
+	triangle<T> result;
+	for (auto& row : rows)
+	{
+		result.emplace_back();
+		for (llint x : row)
+			result.back().push_back({T(x), true});
+	}
+	return result;
+}
+
+// a*x + y, if it fits.
+template <class T>
+triangle_entry<T> triangle_combine(llint a, const triangle_entry<T>& x, const triangle_entry<T>& y)
+{
+	if (!x.fits || !y.fits)
+		return {T(0), false};
+	try
+	{
+		return {dscr::checked_add<T>(dscr::checked_mul<T>(a, x.value), y.value), true};
+	}
+	catch (const std::overflow_error&)
+	{
+		return {T(0), false};
+	}
+}
+
+template <class T>
+T triangle_value(const triangle_entry<T>& e)
+{
+	if (!e.fits)
+		throw_overflow("dscr: integer overflow in a counting sequence");
+	return e.value;
+}
+} // namespace detail
+
 template <class BigIntType>
 inline BigIntType factorial(llint n)
 {
@@ -94,7 +219,7 @@ inline BigIntType factorial(llint n)
 		return toReturn;
 
 	for (llint i = 2; i <= n; ++i)
-		toReturn *= i;
+		toReturn = checked_mul<BigIntType>(toReturn, i);
 
 	return toReturn;
 }
@@ -114,19 +239,6 @@ inline BigIntType binomial(llint n, llint k)
 	if (k == 1)
 		return n;
 
-	static std::vector<std::vector<BigIntType>> B = { { 1 },
-		{ 1 },
-		{ 1,  2 },
-		{ 1,  3 },
-		{ 1,  4,  6 },
-		{ 1,  5,  10 },
-		{ 1,  6,  15,  20 }
-	};
-	llint m = B.size();
-
-	if (n < m)
-		return B[n][k];
-
 	const llint max_saved_size = 66; //this is the maximum n for which binomial(n,k) < 2^63 for any k.
 	if (n > max_saved_size)
 	{
@@ -136,61 +248,97 @@ inline BigIntType binomial(llint n, llint k)
 		std::iota(numerator.begin(), numerator.end(), n-k+1);
 		return reduce_fraction<BigIntType>(std::move(numerator),std::move(denominator));
 	}
-	
-	B.resize(n + 1, {1});
 
-	for (; m <= n; ++m)
+	using table = detail::triangle<BigIntType>;
+	static const table seed = detail::make_triangle<BigIntType>({ { 1 },
+		{ 1 },
+		{ 1,  2 },
+		{ 1,  3 },
+		{ 1,  4,  6 },
+		{ 1,  5,  10 },
+		{ 1,  6,  15,  20 }
+	});
+
+	// Only half of each row is kept, since binomial(m,r) = binomial(m,m-r).
+	auto extend = [max_saved_size](table& B)
 	{
+		llint m = B.size();
+		if (m > max_saved_size)
+			return false;
+
+		const auto& prev = B[m - 1];
 		llint last = (m + 2) / 2 - 1;
-		B[m].resize(last + 1);
+		std::vector<detail::triangle_entry<BigIntType>> row(last + 1, {BigIntType(1), true});
 
 		for (llint r = 1; r < last; ++r)
 		{
-			B[m][r] = B[m - 1][r - 1] + B[m - 1][r];
+			row[r] = detail::triangle_combine<BigIntType>(1, prev[r - 1], prev[r]);
 		}
 
 		if (m % 2 == 0)
-			B[m][last] = 2 * B[m - 1][last - 1];
+			row[last] = detail::triangle_combine<BigIntType>(2, prev[last - 1], {BigIntType(0), true});
 		else
-			B[m][last] = B[m - 1][last] + B[m - 1][last - 1];
-	}
+			row[last] = detail::triangle_combine<BigIntType>(1, prev[last], prev[last - 1]);
 
-	return B[n][k];
+		B.emplace_back(std::move(row));
+		return true;
+	};
 
+	return detail::sequence_entry<BigIntType>(seed, extend, n, [n, k](const table& B) { return detail::triangle_value(B[n][k]); });
 }
 
 template <class BigIntType>
 BigIntType catalan(llint n)
 {
-	static const std::vector<llint> C = {1, 1, 2, 5, 14, 42, 132, 429, 1430, 4862, 16796, 58786, 208012, 742900, 2674440, 9694845, 35357670, 129644790, 477638700, 1767263190, 6564120420, 24466267020, 91482563640, 343059613650, 1289904147324, 4861946401452};
+	using table = std::vector<BigIntType>;
+	static const table seed = {1, 1, 2, 5, 14, 42, 132, 429, 1430, 4862, 16796};
 
-	llint Csize = C.size();
-	
-	if (n < Csize)
-		return C[n];
+	// C_{m} = C_{m-1}*2(2m-1)/(m+1). Divide first so the product only overflows if the result does.
+	auto extend = [](table& C)
+	{
+		llint m = C.size();
+		BigIntType c = C[m - 1];
+		BigIntType num = 2*(2*m - 1);
+		BigIntType den = m + 1;
+		BigIntType g = gcd<BigIntType>(c, den);
+		c /= g;
+		den /= g;
+		C.push_back(checked_mul<BigIntType>(c, num/den));
+		return true;
+	};
 
-	return binomial(2 * n, n) / (n + 1);
+	return detail::sequence_entry<BigIntType>(seed, extend, n, [n](const table& C) { return C[n]; });
+}
+
+template <class BigIntType>
+inline BigIntType ballot_number(llint n, llint h)
+{
+	if (h < 0 || h > n || (n + h)%2 != 0)
+		return 0;
+
+	llint k = (n + h)/2;
+
+	return binomial<BigIntType>(n, k) - binomial<BigIntType>(n, k + 1);
 }
 
 template <class BigIntType>
 inline BigIntType motzkin(llint n)
 {
-	static std::vector<BigIntType> M = {1, 1, 2, 4, 9, 21, 51, 127, 323};
-// 	static std::vector<BigIntType> M = {1, 1, 2, 4, 9, 21, 51, 127, 323, 835, 2188, 5798, 15511, 41835, 113634, 310572, 853467, 2356779, 6536382, 18199284, 50852019, 142547559, 400763223, 1129760415, 3192727797, 9043402501, 25669818476, 73007772802, 208023278209, 593742784829};
-	
-	llint Msize = M.size();
+	using table = std::vector<BigIntType>;
+	static const table seed = {1, 1, 2, 4, 9, 21, 51, 127, 323};
 
-	if (n < Msize)
-		return M[n];
-	
-	llint oldsize = M.size();
-	M.resize(n+1);
-	for (long m = oldsize; m <= n; ++m)
+	// The products (2m+1)M_{m-1} overflow way before M_m does, so they are computed in a wider type.
+	auto extend = [](table& M)
 	{
-		M[m] = ( (2*m+1)*M[m-1] + (3*m - 3)*M[m-2] )/(m+2); //quite likely overflow if using llint
-	}
+		using wide = typename detail::wider<BigIntType>::type;
+		llint m = M.size();
+		wide a = checked_mul<wide>(2*m + 1, M[m - 1]);
+		wide b = checked_mul<wide>(3*m - 3, M[m - 2]);
+		M.push_back(checked_cast<BigIntType>(checked_add<wide>(a, b)/(m + 2)));
+		return true;
+	};
 
-	return M[n];
+	return detail::sequence_entry<BigIntType>(seed, extend, n, [n](const table& M) { return M[n]; });
 }
 
 template <class BigIntType>
@@ -205,37 +353,44 @@ inline BigIntType generalized_pentagonal(llint n)
 template <class BigIntType>
 inline BigIntType partition_number(llint n)
 {
-	static std::vector<llint> P = {1, 1, 2, 3, 5, 7, 11, 15, 22, 30, 42, 56, 77, 101 };
-	
-	llint oldsize = P.size();
-	
-	if (n < oldsize)
-		return P[n];
-	
-	P.resize(n+1,0);
-	for (llint m = oldsize; m <= n; ++m)
+	using table = std::vector<BigIntType>;
+	static const table seed = {1, 1, 2, 3, 5, 7, 11, 15, 22, 30, 42, 56, 77, 101 };
+
+	// Partial sums of the pentagonal recurrence can be larger than the result, so they are computed in a wider type.
+	auto extend = [](table& P)
 	{
-		llint sign = 1;
+		using wide = typename detail::wider<BigIntType>::type;
+		llint m = P.size();
+		wide plus = 0;
+		wide minus = 0;
 		llint count = 0;
+		bool positive = true;
 		for (llint k = 1; generalized_pentagonal(k) <= m; ++k)
 		{
-			P[m] += P[m-generalized_pentagonal(k)]*sign;
+			wide term = P[m-generalized_pentagonal(k)];
+			if (positive)
+				plus = checked_add<wide>(plus, term);
+			else
+				minus = checked_add<wide>(minus, term);
 			++count;
 			if (count == 2)
 			{
-				sign *= -1;
+				positive = !positive;
 				count = 0;
 			}
 		}
-	}
-	
-	return P[n];
+		P.push_back(checked_cast<BigIntType>(plus - minus));
+		return true;
+	};
+
+	return detail::sequence_entry<BigIntType>(seed, extend, n, [n](const table& P) { return P[n]; });
 }
 
 template <class BigIntType>
 inline BigIntType partition_number(llint n, llint k)
 {
-	static std::vector<std::vector<llint>> PNK =
+	using table = detail::triangle<BigIntType>;
+	static const table seed = detail::make_triangle<BigIntType>(
 	{
 		{1},
 		{0, 1},
@@ -243,99 +398,105 @@ inline BigIntType partition_number(llint n, llint k)
 		{0, 1, 1, 1},
 		{0, 1, 2, 1, 1},
 		{0, 1, 2, 2, 1, 1}
-	};
+	});
 
-	llint oldsize = PNK.size();
-	
-	if (n < oldsize)
-		return PNK[n][k];
-
-	if (k == 0 || n == 0)
+	if (k > n || k < 0)
 		return 0;
-	
-	if (k == n || k == 1)
-		return 1;
-	
-	for (llint m = oldsize; m <= n; ++m)
+
+	if (n >= static_cast<llint>(seed.size()))
+	{
+		if (k == 0 || n == 0)
+			return 0;
+
+		if (k == n || k == 1)
+			return 1;
+	}
+
+	auto extend = [](table& PNK)
 	{
-		PNK.emplace_back(m+1,0);
+		llint m = PNK.size();
+		std::vector<detail::triangle_entry<BigIntType>> row(m+1, {BigIntType(0), true});
 		for (llint l = 1; l <= m; ++l)
 		{
-			llint left = 0;
+			detail::triangle_entry<BigIntType> left = {BigIntType(0), true};
 			if (m-l >= l)
 				left = PNK[m-l][l];
 			
-			PNK[m][l] = left + PNK[m-1][l-1];
+			row[l] = detail::triangle_combine<BigIntType>(1, left, PNK[m-1][l-1]);
 		}
-	}
-	
+		PNK.emplace_back(std::move(row));
+		return true;
+	};
 
-	return PNK[n][k];
+	return detail::growing_sequence_entry<BigIntType>(seed, extend, n, [n, k](const table& PNK) { return detail::triangle_value(PNK[n][k]); });
 }
 
 template <class BigIntType>
 inline BigIntType stirling_cycle_number(llint n, llint k)
 {
-	static std::vector<std::vector<llint>> S1 =
+	using table = detail::triangle<BigIntType>;
+	static const table seed = detail::make_triangle<BigIntType>(
 	{
 		{1},
 		{0, 1},
 		{0, 1, 1},
 		{0, 2, 3, 1},
 		{0, 6, 11, 6, 1}
-	};
+	});
 	
 	if (k > n || k < 0)
 		return 0;
 	
-	llint oldsize = S1.size();
-	if (n < oldsize)
-		return S1[n][k];
-	
-	for (llint m = oldsize; m <= n; ++m)
+	auto extend = [](table& S1)
 	{
-		S1.emplace_back(m+1,0);
+		llint m = S1.size();
+		std::vector<detail::triangle_entry<BigIntType>> row(m+1, {BigIntType(0), true});
 		for (llint l = 1; l <= m; ++l)
 		{
-			llint left = 0;
 			if (l < m)
-				left = (m-1)*S1[m-1][l];
-			S1[m][l] = left + S1[m-1][l-1];
+				row[l] = detail::triangle_combine<BigIntType>(m-1, S1[m-1][l], S1[m-1][l-1]);
+			else
+				row[l] = S1[m-1][l-1];
 		}
-	}
+		S1.emplace_back(std::move(row));
+		return true;
+	};
 	
-	return S1[n][k];
+	return detail::growing_sequence_entry<BigIntType>(seed, extend, n, [n, k](const table& S1) { return detail::triangle_value(S1[n][k]); });
 }
 
 template <class BigIntType>
 inline BigIntType stirling_partition_number(llint n, llint k)
 {
-	static std::vector<std::vector<llint>> S2 =
+	using table = detail::triangle<BigIntType>;
+	static const table seed = detail::make_triangle<BigIntType>(
 	{
 		{1},
 		{0, 1},
 		{0, 1, 1},
 		{0, 1, 3, 1},
 		{0, 1, 7, 6, 1}
-	};
+	});
 	
-	llint oldsize = S2.size();
-	if (n < oldsize)
-		return S2[n][k];
+	if (k > n || k < 0)
+		return 0;
 	
-	for (llint m = oldsize; m <= n; ++m)
+	auto extend = [](table& S2)
 	{
-		S2.emplace_back(m+1,0);
+		llint m = S2.size();
+		std::vector<detail::triangle_entry<BigIntType>> row(m+1, {BigIntType(0), true});
 		for (llint l = 1; l <= m; ++l)
 		{
-			llint left = 0;
 			if (l < m)
-				left = l*S2[m-1][l];
-			S2[m][l] = left + S2[m-1][l-1];
+				row[l] = detail::triangle_combine<BigIntType>(l, S2[m-1][l], S2[m-1][l-1]);
+			else
+				row[l] = S2[m-1][l-1];
 		}
-	}
+		S2.emplace_back(std::move(row));
+		return true;
+	};
 	
-	return S2[n][k];
+	return detail::growing_sequence_entry<BigIntType>(seed, extend, n, [n, k](const table& S2) { return detail::triangle_value(S2[n][k]); });
 }
 
 } //namespace dscr
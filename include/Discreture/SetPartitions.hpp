@@ -1,12 +1,17 @@
 #pragma once
 
+#include <iterator>
+#include <limits>
 #include <numeric>
+#include <stdexcept>
 
 #include "VectorHelpers.hpp"
 #include "Misc.hpp"
 #include "Sequences.hpp"
 #include "NumberRange.hpp"
 #include "Partitions.hpp"
+#include "Instrumentation.hpp"
+#include "Subrange.hpp"
 #include <boost/iterator/iterator_facade.hpp>
 
 namespace dscr
@@ -201,6 +206,97 @@ public:
 		return iterator::make_invalid_with_id(size());
 	}
 
+	////////////////////////////////////////////////////////////
+	/// \brief An iterator pointing at x, which must be the id-th set partition in the order of iteration.
+	///
+	/// This is how an iteration is resumed from a checkpoint (see Checkpoint.hpp): it takes O(n), instead of iterating id times.
+	////////////////////////////////////////////////////////////
+	iterator resume(size_type id, const set_partition& x) const
+	{
+		assert(0 <= id && id < size());
+		return iterator(m_n, id, x);
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief Number of set partitions of {0,...,n-1} whose parts have the sizes given by shape, a number partition of n.
+	///
+	/// \return The number, or the largest size_type if it doesn't fit.
+	////////////////////////////////////////////////////////////
+	static size_type num_with_shape(const number_partition& shape)
+	{
+		// Parts of the same size are contiguous. For each group of m parts of size s, choose their
+		// s*m elements among the remaining ones, and then split them into m unordered parts: the part
+		// of the smallest one that's left has s-1 more elements out of the rest, and so on.
+		try
+		{
+			size_type remaining = std::accumulate(shape.begin(), shape.end(), size_type(0));
+			size_type result = 1;
+
+			for (std::size_t i = 0; i < shape.size(); )
+			{
+				size_type s = shape[i];
+				size_type m = 0;
+				for ( ; i < shape.size() && shape[i] == s; ++i)
+					++m;
+
+				result = checked_mul(result, binomial<size_type>(remaining, s*m));
+				for (size_type j = 0; j < m; ++j)
+					result = checked_mul(result, binomial<size_type>(s*m - j*s - 1, s - 1));
+				remaining -= s*m;
+			}
+
+			return result;
+		}
+		catch (const std::overflow_error&)
+		{
+			return std::numeric_limits<size_type>::max();
+		}
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief An iterator pointing at the id-th set partition.
+	///
+	/// Set partitions can't be unranked (yet), but they are iterated by the sizes of their parts, and
+	/// the number of set partitions with each shape is known (see num_with_shape). So this jumps
+	/// straight to the first one with the right shape, and only iterates from there.
+	////////////////////////////////////////////////////////////
+	iterator skip_to(size_type id) const
+	{
+		assert(0 <= id && id <= size());
+		if (id == size())
+			return end();
+
+		number_partition shape;
+		basic_partitions<IntType>::first_with_given_number_of_parts(shape, m_n, m_maxnumparts);
+		size_type first = 0;
+		while (true)
+		{
+			size_type block = num_with_shape(shape);
+			if (id - first < block)
+				break;
+			first += block;
+			basic_partitions<IntType>::next_partition(shape, m_n);
+		}
+
+		set_partition x;
+		fill_first_set_partition(x, shape);
+		iterator it(m_n, first, x);
+		std::advance(it, id - first);
+		return it;
+	}
+
+	////////////////////////////////////////////////////////////
+	/// \brief The set partitions of ranks [first, last) (see Subrange.hpp).
+	////////////////////////////////////////////////////////////
+	subrange<iterator> range(size_type first, size_type last) const
+	{
+		assert(0 <= first && first <= last && last <= size());
+		auto end = iterator::make_invalid_with_id(last);
+		if (first == last)
+			return subrange<iterator>(end, end);
+		return subrange<iterator>(skip_to(first), end);
+	}
+
 	////////////////////////////////////////////////////////////
 	/// \brief Forward iterator class.
 	////////////////////////////////////////////////////////////
@@ -215,9 +311,24 @@ public:
 
 		explicit iterator(IntType n, IntType numparts) : m_ID(0), m_data(n), m_n(n), m_npartition()
 		{
+			// The number of parts only goes down from here, so with enough room in every part
+			// next_set_partition never needs to allocate.
+			for (auto& part : m_data)
+				part.reserve(n);
 			basic_partitions<IntType>::first_with_given_number_of_parts(m_npartition, n, numparts);
 			fill_first_set_partition(m_data, m_npartition);
 		}
+
+		// The parts of current have the sizes of the number partition it belongs to, in order.
+		iterator(IntType n, size_type id, const set_partition& current) : m_ID(id), m_data(current), m_n(n), m_npartition()
+		{
+			m_npartition.reserve(current.size());
+			for (auto& part : m_data)
+			{
+				m_npartition.push_back(part.size());
+				part.reserve(n);
+			}
+		}
 		
 		inline size_type ID() const
 		{
@@ -234,10 +345,12 @@ public:
 	private:
 		void increment()
 		{
+			instrument(instrumented::set_partitions, instrumented::step);
 			++m_ID;
 
 			if (!next_set_partition(m_data, m_npartition))
 			{
+				instrument(instrumented::set_partitions, instrumented::reset);
 				basic_partitions<IntType>::next_partition(m_npartition, m_n);
 				fill_first_set_partition(m_data, m_npartition);
 			}
@@ -276,7 +389,7 @@ private:
 		size_type toReturn = 0;
 
 		for (IntType k = minnumparts; k <= maxnumparts; ++k)
-			toReturn += stirling_partition_number(n, k);
+			toReturn = checked_add<size_type>(toReturn, stirling_partition_number(n, k));
 
 		return toReturn;
 	}
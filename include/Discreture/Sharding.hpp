@@ -0,0 +1,179 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "Subrange.hpp"
+
+////////////////////////////////////////////////////////////
+/// \file Sharding.hpp
+/// \brief Splitting an enumeration among worker processes.
+///
+/// Every family with random access has shard(i, N), the i-th of N balanced slices of it, so N
+/// processes (on one machine or many) can each take one. fork_shards does that on the local
+/// machine: it forks one worker per shard, and each worker sends back its result as a string
+/// through a pipe. For example, to count the combinations whose elements add up to 100:
+///
+/// 	dscr::combinations X(40,8);
+/// 	auto results = dscr::fork_shards(X, 8, [](const auto& shard)
+/// 	{
+/// 		long long count = 0;
+/// 		for (auto& x : shard)
+/// 			count += (std::accumulate(x.begin(), x.end(), 0) == 100);
+/// 		return std::to_string(count);
+/// 	});
+/// 	long long total = 0;
+/// 	for (auto& r : results)
+/// 		total += std::stoll(r);
+///
+/// Unlike threads, the workers share nothing, so a worker that crashes only loses its own shard.
+/// This header is POSIX only and is not included by discreture.hpp.
+////////////////////////////////////////////////////////////
+
+namespace dscr
+{
+namespace detail
+{
+inline void write_all(int fd, const std::string& data)
+{
+	std::size_t written = 0;
+	while (written < data.size())
+	{
+		ssize_t w = ::write(fd, data.data() + written, data.size() - written);
+		if (w < 0 && errno == EINTR)
+			continue;
+		if (w <= 0)
+			return;
+		written += w;
+	}
+}
+
+inline bool read_all(int fd, std::string& data)
+{
+	char buffer[1 << 16];
+	while (true)
+	{
+		ssize_t r = ::read(fd, buffer, sizeof(buffer));
+		if (r < 0 && errno == EINTR)
+			continue;
+		if (r < 0)
+			return false;
+		if (r == 0)
+			return true;
+		data.append(buffer, r);
+	}
+}
+} // namespace detail
+
+////////////////////////////////////////////////////////////
+/// \brief Runs work(i) in a new process for each i in [0, num_workers), and returns what each one returned, in order.
+///
+/// work(i) must return a std::string (its result, serialized in any way). The workers run at the same
+/// time, and each one ends (with _exit) as soon as it's done, without running destructors of
+/// static objects. If a worker throws, crashes or can't be started, this throws std::runtime_error
+/// after waiting for all the others.
+////////////////////////////////////////////////////////////
+template <class Work>
+std::vector<std::string> fork_workers(int num_workers, Work work)
+{
+	// Anything still buffered would otherwise be written once by every worker.
+	std::cout.flush();
+	std::cerr.flush();
+	std::fflush(nullptr);
+
+	std::vector<pid_t> pids(num_workers, -1);
+	std::vector<int> pipes(num_workers, -1);
+
+	for (int i = 0; i < num_workers; ++i)
+	{
+		int fds[2];
+		if (::pipe(fds) != 0)
+			break;
+
+		pid_t pid = ::fork();
+		if (pid < 0)
+		{
+			::close(fds[0]);
+			::close(fds[1]);
+			break;
+		}
+
+		if (pid == 0) // worker
+		{
+			::close(fds[0]);
+			for (int j = 0; j < i; ++j)
+				::close(pipes[j]);
+
+			int status = 0;
+			try
+			{
+				detail::write_all(fds[1], work(i));
+			}
+			catch (const std::exception& e)
+			{
+				std::cerr << "worker " << i << ": " << e.what() << std::endl;
+				status = 1;
+			}
+			catch (...)
+			{
+				status = 1;
+			}
+
+			::close(fds[1]);
+			std::_Exit(status);
+		}
+
+		::close(fds[1]);
+		pids[i] = pid;
+		pipes[i] = fds[0];
+	}
+
+	std::vector<std::string> results(num_workers);
+	std::string failed;
+
+	for (int i = 0; i < num_workers; ++i)
+	{
+		if (pids[i] < 0)
+		{
+			failed += " " + std::to_string(i) + " (not started)";
+			continue;
+		}
+
+		bool read_ok = detail::read_all(pipes[i], results[i]);
+		::close(pipes[i]);
+
+		int status = 0;
+		while (::waitpid(pids[i], &status, 0) < 0 && errno == EINTR) {}
+
+		if (!read_ok || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+			failed += " " + std::to_string(i);
+	}
+
+	if (!failed.empty())
+		throw std::runtime_error("fork_workers: failed workers:" + failed);
+
+	return results;
+}
+
+////////////////////////////////////////////////////////////
+/// \brief Runs work(X.shard(i, num_workers)) in a new process for each shard, and returns the results in shard order.
+////////////////////////////////////////////////////////////
+template <class Container, class Work>
+std::vector<std::string> fork_shards(const Container& X, int num_workers, Work work)
+{
+	return fork_workers(num_workers, [&X, num_workers, &work](int i)
+	{
+		return work(X.shard(i, num_workers));
+	});
+}
+} // namespace dscr
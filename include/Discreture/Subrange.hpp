@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cassert>
+#include <utility>
+
+////////////////////////////////////////////////////////////
+/// \file Subrange.hpp
+/// \brief A view of the objects of a family whose ranks are in [first, last).
+///
+/// Every family has range(first, last), which returns one of these: a view with begin(), end(),
+/// size() and for_each(). It finds the object of rank first only once (by unranking, or with
+/// skip_to in the families that can't unrank), and from there on it's the family's own successor,
+/// until last.
+////////////////////////////////////////////////////////////
+
+namespace dscr
+{
+////////////////////////////////////////////////////////////
+/// \brief The objects of ranks [begin.ID(), end.ID()) of some family, iterated with the family's own iterator.
+///
+/// Like any iterator, it must not outlive the container it came from.
+////////////////////////////////////////////////////////////
+template <class Iterator>
+class subrange
+{
+public:
+	using iterator = Iterator;
+	using const_iterator = Iterator;
+	using size_type = long long;
+	using difference_type = long long;
+
+	subrange(Iterator first, Iterator last) : m_begin(first), m_end(last)
+	{
+		assert(first.ID() <= last.ID());
+	}
+
+	iterator begin() const { return m_begin; }
+
+	iterator end() const { return m_end; }
+
+	size_type size() const { return m_end.ID() - m_begin.ID(); }
+
+	bool empty() const { return size() == 0; }
+
+	////////////////////////////////////////////////////////////
+	/// \brief The rank (in the whole family) of the first object.
+	////////////////////////////////////////////////////////////
+	size_type first_rank() const { return m_begin.ID(); }
+
+	////////////////////////////////////////////////////////////
+	/// \brief One past the rank of the last object.
+	////////////////////////////////////////////////////////////
+	size_type last_rank() const { return m_end.ID(); }
+
+	////////////////////////////////////////////////////////////
+	/// \brief Applies f to every object of the range. Faster than a range for, since it counts instead of comparing iterators.
+	////////////////////////////////////////////////////////////
+	template <class Func>
+	void for_each(Func f) const
+	{
+		size_type n = size();
+		if (n == 0)
+			return;
+
+		auto it = m_begin;
+		while (true)
+		{
+			f(*it);
+			if (--n == 0)
+				break;
+			++it;
+		}
+	}
+
+private:
+	Iterator m_begin;
+	Iterator m_end;
+};
+
+////////////////////////////////////////////////////////////
+/// \brief The view of the objects of X of ranks [first, last). It unranks once, at first.
+////////////////////////////////////////////////////////////
+template <class Container>
+auto make_subrange(const Container& X, long long first, long long last)
+{
+	using iterator = typename Container::iterator;
+	assert(0 <= first && first <= last && last <= X.size());
+
+	auto end = iterator::make_invalid_with_id(last);
+	if (first == last)
+		return subrange<iterator>(end, end);
+
+	return subrange<iterator>(X.begin() + first, end);
+}
+
+////////////////////////////////////////////////////////////
+/// \brief The ranks [first, last) of the i-th of num_shards consecutive shards of [0, size).
+///
+/// The sizes of any two shards differ by at most one.
+////////////////////////////////////////////////////////////
+inline std::pair<long long, long long> shard_bounds(long long size, long long i, long long num_shards)
+{
+	assert(0 <= i && i < num_shards);
+	long long base = size/num_shards;
+	long long extra = size%num_shards; // the first extra shards get one more
+	auto start = [base, extra](long long j) { return j*base + (j < extra ? j : extra); };
+	return {start(i), start(i + 1)};
+}
+} // namespace dscr
@@ -0,0 +1,323 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "Multisets.hpp"
+#include "RankMap.hpp"
+#include "Subrange.hpp"
+
+////////////////////////////////////////////////////////////
+/// \file SubsetTransforms.hpp
+/// \brief Zeta and Möbius transforms over the submultisets of a multiset (and over the subsets of a set).
+///
+/// Given a value a[x] for every submultiset x of total, stored by rank (as in multisets::get_index),
+/// zeta_transform replaces each a[x] with the sum of a[y] over all y <= x (coordinatewise), and
+/// mobius_transform undoes it. That's what "sum over subsets" and inclusion-exclusion need. Summing
+/// directly takes time proportional to the number of pairs y <= x (3^n for the subsets of an n-set);
+/// here it's one prefix sum per coordinate, so O(n*size).
+///
+/// 	dscr::multisets X({2,1,3});
+/// 	std::vector<long long> a(X.size());
+/// 	... // a[X.get_index(x)] = f(x)
+/// 	dscr::zeta_transform(X, a); // a[X.get_index(x)] is now the sum of f(y) over all y <= x
+/// 	dscr::mobius_transform(X, a); // and back to f
+///
+/// superset_zeta_transform and superset_mobius_transform do the same with y >= x. All of them work
+/// in place on any contiguous storage with data() (std::vector, mapped_array, a multiset_map) and
+/// optionally with several threads. T can be anything with += and -= (doubles, modular integers, ...).
+////////////////////////////////////////////////////////////
+
+namespace dscr
+{
+namespace detail
+{
+// The coordinates with small strides are all done inside blocks this big, while they are in cache.
+constexpr std::size_t lattice_block_bytes = 1 << 15;
+
+// Runs f(first, last) on num_threads consecutive slices of [0, n), each one in its own thread.
+template <class Function>
+void for_each_slice(std::size_t n, Function f, std::size_t num_threads)
+{
+	num_threads = std::max<std::size_t>(std::min<std::size_t>(num_threads, n), 1);
+	if (num_threads == 1)
+	{
+		f(std::size_t(0), n);
+		return;
+	}
+
+	std::vector<std::thread> threads;
+	threads.reserve(num_threads);
+	for (std::size_t i = 0; i < num_threads; ++i)
+	{
+		auto bounds = shard_bounds(n, i, num_threads);
+		threads.emplace_back([&f, bounds]() { f(std::size_t(bounds.first), std::size_t(bounds.second)); });
+	}
+	for (auto& t : threads)
+		t.join();
+}
+
+// target[j] += source[j] (or -=) for j in [first, last). The two never overlap, which lets the compiler vectorize it.
+template <bool Inverse, class T>
+inline void lattice_row(T* __restrict target, const T* __restrict source, std::size_t first, std::size_t last)
+{
+	for (std::size_t j = first; j < last; ++j)
+	{
+		if (Inverse)
+			target[j] -= source[j];
+		else
+			target[j] += source[j];
+	}
+}
+
+// The transform along one coordinate, of stride stride and radix radix, on num_high consecutive
+// groups of stride*radix elements, but only on the offsets [first, last) inside each row.
+template <bool Up, bool Inverse, class T>
+void lattice_step(T* a, std::size_t stride, std::size_t radix, std::size_t num_high, std::size_t first, std::size_t last)
+{
+	if (radix < 2)
+		return;
+
+	for (std::size_t h = 0; h < num_high; ++h)
+	{
+		T* group = a + h*stride*radix;
+		auto row = [group, stride](std::size_t d) { return group + d*stride; };
+
+		if (!Up && !Inverse) // prefix sums, so each row adds the already updated one below it
+			for (std::size_t d = 1; d < radix; ++d)
+				lattice_row<false>(row(d), row(d - 1), first, last);
+		else if (!Up && Inverse) // differences with the rows below, still unchanged
+			for (std::size_t d = radix - 1; d > 0; --d)
+				lattice_row<true>(row(d), row(d - 1), first, last);
+		else if (Up && !Inverse)
+			for (std::size_t d = radix - 1; d > 0; --d)
+				lattice_row<false>(row(d - 1), row(d), first, last);
+		else
+			for (std::size_t d = 1; d < radix; ++d)
+				lattice_row<true>(row(d - 1), row(d), first, last);
+	}
+}
+
+// The first three coordinates of a power set, all at once on every group of 8. Every loop has
+// constant bounds, so it's fully unrolled and the groups are vectorized.
+template <bool Up, bool Inverse, class T>
+void power_set_low_bits(T* a, std::size_t size)
+{
+	for (std::size_t g = 0; g < size; g += 8)
+	{
+		T* x = a + g;
+		for (std::size_t bit = 1; bit < 8; bit *= 2)
+		{
+			for (std::size_t j = 0; j < 8; ++j)
+			{
+				if (j & bit)
+					continue;
+
+				T& lower = x[j];
+				T& upper = x[j | bit];
+				if (!Up && !Inverse)
+					upper += lower;
+				else if (!Up && Inverse)
+					upper -= lower;
+				else if (Up && !Inverse)
+					lower += upper;
+				else
+					lower -= upper;
+			}
+		}
+	}
+}
+
+// The transform over the mixed radix layout of get_index: coordinate i has stride radices[0]*...*radices[i-1].
+template <bool Up, bool Inverse, class T>
+void lattice_transform(T* a, const std::vector<std::size_t>& radices, std::size_t num_threads)
+{
+	std::size_t size = 1;
+	for (auto r : radices)
+		size *= r;
+
+	const bool power_set = !radices.empty() && std::all_of(radices.begin(), radices.end(), [](std::size_t r) { return r == 2; });
+
+	// Coordinates [0, m) have small strides: they are done block by block, each block in cache.
+	std::size_t m = 0;
+	std::size_t block = 1;
+	while (m < radices.size() && block*radices[m]*sizeof(T) <= lattice_block_bytes)
+		block *= radices[m++];
+
+	for_each_slice(size/block, [&](std::size_t first, std::size_t last)
+	{
+		for (std::size_t b = first; b < last; ++b)
+		{
+			T* x = a + b*block;
+			std::size_t i = 0;
+			std::size_t stride = 1;
+			if (power_set && m >= 3)
+			{
+				power_set_low_bits<Up, Inverse>(x, block);
+				i = 3;
+				stride = 8;
+			}
+			for ( ; i < m; ++i)
+			{
+				lattice_step<Up, Inverse>(x, stride, radices[i], block/(stride*radices[i]), 0, stride);
+				stride *= radices[i];
+			}
+		}
+	}, num_threads);
+
+	// The rest have strides of at least a block, so each row is long and contiguous: one pass each.
+	// The threads split the groups, and when there are fewer groups than threads, the rows too.
+	std::size_t stride = block;
+	for (std::size_t i = m; i < radices.size(); ++i)
+	{
+		const std::size_t radix = radices[i];
+		const std::size_t num_high = size/(stride*radix);
+		const std::size_t pieces = std::max<std::size_t>(1, std::min(stride, num_threads/num_high));
+
+		for_each_slice(num_high*pieces, [&](std::size_t first, std::size_t last)
+		{
+			for (std::size_t t = first; t < last; ++t)
+			{
+				auto columns = shard_bounds(stride, t%pieces, pieces);
+				lattice_step<Up, Inverse>(a + (t/pieces)*stride*radix, stride, radix, 1, columns.first, columns.second);
+			}
+		}, num_threads);
+
+		stride *= radix;
+	}
+}
+
+template <bool Up, bool Inverse, class IntType, class RAContainerInt, class Container>
+void multiset_transform(const basic_multisets<IntType, RAContainerInt>& X, Container& a, std::size_t num_threads)
+{
+	if (static_cast<long long>(a.size()) != X.size())
+		throw std::invalid_argument("dscr: a zeta/mobius transform needs exactly one value per submultiset");
+
+	std::vector<std::size_t> radices;
+	radices.reserve(X.total().size());
+	for (auto t : X.total())
+		radices.push_back(t + 1);
+
+	lattice_transform<Up, Inverse>(a.data(), radices, num_threads);
+}
+
+template <bool Up, bool Inverse, class Container>
+void power_set_transform(Container& a, std::size_t num_threads)
+{
+	std::size_t size = a.size();
+	if (size == 0 || (size & (size - 1)) != 0)
+		throw std::invalid_argument("dscr: a power set transform needs 2^n values");
+
+	std::vector<std::size_t> radices;
+	for (std::size_t s = 1; s < size; s *= 2)
+		radices.push_back(2);
+
+	lattice_transform<Up, Inverse>(a.data(), radices, num_threads);
+}
+} // namespace detail
+
+////////////////////////////////////////////////////////////
+/// \brief a[x] becomes the sum of a[y] over all submultisets y of x. a is indexed by X.get_index and must have X.size() elements.
+///
+/// When every element of X.total() is 1 (the subsets of a set), the first coordinates use a
+/// specialized kernel; see also power_set_zeta_transform.
+////////////////////////////////////////////////////////////
+template <class IntType, class RAContainerInt, class Container>
+void zeta_transform(const basic_multisets<IntType, RAContainerInt>& X, Container& a, std::size_t num_threads = 1)
+{
+	detail::multiset_transform<false, false>(X, a, num_threads);
+}
+
+////////////////////////////////////////////////////////////
+/// \brief The inverse of zeta_transform: a[x] becomes the alternating sum that gives back the a of before the zeta_transform.
+////////////////////////////////////////////////////////////
+template <class IntType, class RAContainerInt, class Container>
+void mobius_transform(const basic_multisets<IntType, RAContainerInt>& X, Container& a, std::size_t num_threads = 1)
+{
+	detail::multiset_transform<false, true>(X, a, num_threads);
+}
+
+////////////////////////////////////////////////////////////
+/// \brief a[x] becomes the sum of a[y] over all y with x <= y <= X.total().
+////////////////////////////////////////////////////////////
+template <class IntType, class RAContainerInt, class Container>
+void superset_zeta_transform(const basic_multisets<IntType, RAContainerInt>& X, Container& a, std::size_t num_threads = 1)
+{
+	detail::multiset_transform<true, false>(X, a, num_threads);
+}
+
+////////////////////////////////////////////////////////////
+/// \brief The inverse of superset_zeta_transform.
+////////////////////////////////////////////////////////////
+template <class IntType, class RAContainerInt, class Container>
+void superset_mobius_transform(const basic_multisets<IntType, RAContainerInt>& X, Container& a, std::size_t num_threads = 1)
+{
+	detail::multiset_transform<true, true>(X, a, num_threads);
+}
+
+////////////////////////////////////////////////////////////
+/// \brief The transforms of a multiset_map (or any rank_map over multisets), in place.
+////////////////////////////////////////////////////////////
+template <class IntType, class RAContainerInt, class T, class Storage>
+void zeta_transform(rank_map<basic_multisets<IntType, RAContainerInt>, T, Storage>& M, std::size_t num_threads = 1)
+{
+	zeta_transform(M.family(), M.values(), num_threads);
+}
+
+template <class IntType, class RAContainerInt, class T, class Storage>
+void mobius_transform(rank_map<basic_multisets<IntType, RAContainerInt>, T, Storage>& M, std::size_t num_threads = 1)
+{
+	mobius_transform(M.family(), M.values(), num_threads);
+}
+
+template <class IntType, class RAContainerInt, class T, class Storage>
+void superset_zeta_transform(rank_map<basic_multisets<IntType, RAContainerInt>, T, Storage>& M, std::size_t num_threads = 1)
+{
+	superset_zeta_transform(M.family(), M.values(), num_threads);
+}
+
+template <class IntType, class RAContainerInt, class T, class Storage>
+void superset_mobius_transform(rank_map<basic_multisets<IntType, RAContainerInt>, T, Storage>& M, std::size_t num_threads = 1)
+{
+	superset_mobius_transform(M.family(), M.values(), num_threads);
+}
+
+////////////////////////////////////////////////////////////
+/// \brief Sum over subsets: a has 2^n elements indexed by bitmask, and a[S] becomes the sum of a[R] over all R contained in S.
+////////////////////////////////////////////////////////////
+template <class Container>
+void power_set_zeta_transform(Container& a, std::size_t num_threads = 1)
+{
+	detail::power_set_transform<false, false>(a, num_threads);
+}
+
+////////////////////////////////////////////////////////////
+/// \brief The inverse of power_set_zeta_transform (inclusion-exclusion): a[S] becomes the sum of (-1)^|S-R| a[R] over all R contained in S.
+////////////////////////////////////////////////////////////
+template <class Container>
+void power_set_mobius_transform(Container& a, std::size_t num_threads = 1)
+{
+	detail::power_set_transform<false, true>(a, num_threads);
+}
+
+////////////////////////////////////////////////////////////
+/// \brief Sum over supersets: a[S] becomes the sum of a[R] over all R that contain S.
+////////////////////////////////////////////////////////////
+template <class Container>
+void power_set_superset_zeta_transform(Container& a, std::size_t num_threads = 1)
+{
+	detail::power_set_transform<true, false>(a, num_threads);
+}
+
+////////////////////////////////////////////////////////////
+/// \brief The inverse of power_set_superset_zeta_transform.
+////////////////////////////////////////////////////////////
+template <class Container>
+void power_set_superset_mobius_transform(Container& a, std::size_t num_threads = 1)
+{
+	detail::power_set_transform<true, true>(a, num_threads);
+}
+} // namespace dscr
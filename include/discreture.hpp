@@ -11,10 +11,19 @@
 #include "Discreture/Combinations.hpp"
 #include "Discreture/CombinationsTree.hpp"
 #include "Discreture/CombinationsTreePrunned.hpp"
+#include "Discreture/ConstrainedCombinations.hpp"
 #include "Discreture/Permutations.hpp"
 #include "Discreture/Multisets.hpp"
+#include "Discreture/MultisetsGray.hpp"
 #include "Discreture/Partitions.hpp"
 #include "Discreture/DyckPaths.hpp"
+#include "Discreture/DyckPathsPacked.hpp"
 #include "Discreture/Motzkin.hpp"
 #include "Discreture/SetPartitions.hpp"
 #include "Discreture/Parallel.hpp"
+#include "Discreture/Checkpoint.hpp"
+#include "Discreture/Subrange.hpp"
+#include "Discreture/Pipeline.hpp"
+#include "Discreture/RankMap.hpp"
+#include "Discreture/SubsetTransforms.hpp"
+#include "Discreture/Instrumentation.hpp"
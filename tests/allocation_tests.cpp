@@ -0,0 +1,217 @@
+#include <gtest/gtest.h>
+#include <iostream>
+#include "AllocationCounter.hpp"
+#include "discreture.hpp"
+
+using namespace std;
+using namespace dscr;
+
+// Steady state: once the iterator (or the first object) exists, going through the rest
+// shouldn't touch the heap.
+
+template <class Container>
+long long forward_allocations(const Container& X)
+{
+	auto it = X.begin();
+	auto last = X.end();
+	long long count = 0;
+	allocation_scope scope;
+	for ( ; it != last; ++it)
+		++count;
+	EXPECT_GT(count, 0);
+	return scope.allocations();
+}
+
+template <class Container>
+long long reverse_allocations(const Container& X)
+{
+	auto it = X.rbegin();
+	auto last = X.rend();
+	allocation_scope scope;
+	long long count = 0;
+	for ( ; it != last; ++it)
+		++count;
+	EXPECT_EQ(count, X.size());
+	return scope.allocations();
+}
+
+template <class Container>
+long long for_each_allocations(const Container& X)
+{
+	long long count = 0;
+	allocation_scope scope;
+	X.for_each([&count](const auto&)
+	{
+		++count;
+	});
+	EXPECT_EQ(count, X.size());
+	return scope.allocations();
+}
+
+template <class Container>
+long long rank_allocations(const Container& X)
+{
+	auto it = X.begin();
+	auto last = X.end();
+	allocation_scope scope;
+	for ( ; it != last; ++it)
+	{
+		EXPECT_EQ(X.get_index(*it), it.ID());
+	}
+	return scope.allocations();
+}
+
+TEST(Allocations, HookInstalled)
+{
+	ASSERT_TRUE(allocation_counting_enabled());
+	allocation_scope scope;
+	void* p = ::operator new(sizeof(int));
+	::operator delete(p);
+	ASSERT_EQ(scope.allocations(), 1);
+	ASSERT_EQ(scope.bytes(), sizeof(int));
+}
+
+TEST(Allocations, Combinations)
+{
+	combinations_fast X(14,6);
+	ASSERT_EQ(forward_allocations(X), 0);
+	ASSERT_EQ(reverse_allocations(X), 0);
+	ASSERT_EQ(for_each_allocations(X), 0);
+	ASSERT_EQ(rank_allocations(X), 0);
+	
+	// The first pass may fill binomial's table.
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		allocation_scope scope;
+		for (long i = 0; i < X.size(); i += 7)
+			ASSERT_EQ(X[i].size(), 6);
+		if (pass == 1)
+		{
+			ASSERT_EQ(scope.allocations(), 0);
+		}
+	}
+}
+
+TEST(Allocations, CombinationsTree)
+{
+	combinations_tree_fast X(14,6);
+	ASSERT_EQ(forward_allocations(X), 0);
+	ASSERT_EQ(reverse_allocations(X), 0);
+	ASSERT_EQ(for_each_allocations(X), 0);
+	ASSERT_EQ(rank_allocations(X), 0);
+}
+
+TEST(Allocations, FindAll)
+{
+	std::vector<int> forbidden = {3, 5, 8};
+	// Capturing by value: the predicate itself owns memory, and it used to be copied at every step.
+	auto pred = [forbidden](const auto& comb)
+	{
+		return std::find(forbidden.begin(), forbidden.end(), comb.back()) == forbidden.end();
+	};
+	
+	combinations_fast X(16,5);
+	auto F = X.find_all(pred);
+	ASSERT_EQ(forward_allocations(F), 0);
+	
+	combinations_tree_fast Y(16,5);
+	auto G = Y.find_all(pred);
+	ASSERT_EQ(forward_allocations(G), 0);
+	
+	auto by_reference = [&forbidden](const auto& comb)
+	{
+		return std::find(forbidden.begin(), forbidden.end(), comb.back()) == forbidden.end();
+	};
+	X.find_if(by_reference);
+	allocation_scope scope;
+	auto it = X.find_if(by_reference);
+	ASSERT_EQ(scope.allocations(), 0);
+	ASSERT_TRUE(by_reference(*it));
+}
+
+TEST(Allocations, Permutations)
+{
+	permutations_fast X(7);
+	ASSERT_EQ(forward_allocations(X), 0);
+	ASSERT_EQ(reverse_allocations(X), 0);
+	ASSERT_EQ(rank_allocations(X), 0);
+	
+	// get_index used to copy the suffix, even for std::vector
+	permutations Y(7);
+	ASSERT_EQ(rank_allocations(Y), 0);
+}
+
+TEST(Allocations, Multisets)
+{
+	multisets_fast::multiset total = {2,0,3,1,2};
+	multisets_fast X(total);
+	ASSERT_EQ(forward_allocations(X), 0);
+	ASSERT_EQ(reverse_allocations(X), 0);
+	ASSERT_EQ(rank_allocations(X), 0);
+	
+	allocation_scope scope;
+	for (long i = 0; i < X.size(); ++i)
+		ASSERT_EQ(X.get_index(X[i]), i);
+	ASSERT_EQ(scope.allocations(), 0);
+	
+	multisets_gray_fast Y(total);
+	ASSERT_EQ(forward_allocations(Y), 0);
+	ASSERT_EQ(reverse_allocations(Y), 0);
+	ASSERT_EQ(for_each_allocations(Y), 0);
+	ASSERT_EQ(rank_allocations(Y), 0);
+}
+
+TEST(Allocations, Paths)
+{
+	dyck_paths_fast D(8);
+	ASSERT_EQ(forward_allocations(D), 0);
+	ASSERT_EQ(reverse_allocations(D), 0);
+	ASSERT_EQ(for_each_allocations(D), 0);
+	ASSERT_EQ(rank_allocations(D), 0);
+	
+	dyck_paths_packed DP(8);
+	ASSERT_EQ(for_each_allocations(DP), 0);
+	ASSERT_EQ(rank_allocations(DP), 0);
+	
+	motzkin_paths_fast M(9);
+	ASSERT_EQ(forward_allocations(M), 0);
+	ASSERT_EQ(reverse_allocations(M), 0);
+	ASSERT_EQ(for_each_allocations(M), 0);
+	ASSERT_EQ(rank_allocations(M), 0);
+}
+
+TEST(Allocations, Partitions)
+{
+	partitions_fast X(20);
+	ASSERT_EQ(forward_allocations(X), 0);
+	ASSERT_EQ(reverse_allocations(X), 0);
+	
+	partitions_fast Y(20, 3, 7);
+	ASSERT_EQ(forward_allocations(Y), 0);
+	ASSERT_EQ(reverse_allocations(Y), 0);
+}
+
+TEST(Allocations, SetPartitions)
+{
+	// No static_vector version, but the inner vectors are kept around once they exist.
+	set_partitions X(9);
+	ASSERT_EQ(forward_allocations(X), 0);
+	
+	set_partitions Y(9, 2, 5);
+	ASSERT_EQ(forward_allocations(Y), 0);
+}
+
+TEST(Allocations, CompoundContainer)
+{
+	std::vector<std::string> words = {"the", "quick", "brown", "fox", "jumps", "over"};
+	auto X = compound_combinations(words, 3);
+	
+	auto it = X.begin();
+	auto last = X.end();
+	allocation_scope scope;
+	long long count = 0;
+	for ( ; it != last; ++it)
+		count += (*it)[0].size();
+	ASSERT_EQ(scope.allocations(), 0);
+	ASSERT_GT(count, 0);
+}
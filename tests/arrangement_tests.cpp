@@ -1,10 +1,12 @@
 #include <iostream>
 #include <vector>
+#include <array>
 #include <string>
 #include <gtest/gtest.h>
 #include "Arrangement.hpp"
 #include "Combinations.hpp"
 #include "Permutations.hpp"
+#include <numeric>
 #include "generate_strings.hpp"
 
 template <typename Arrangement, typename Container, typename IndexContainer>
@@ -56,3 +58,80 @@ TEST(Arrangements, Permutations)
 		}
 	}
 }
+
+template <class T>
+void check_gather_into(const std::vector<T>& total)
+{
+	int n = total.size();
+	for (int k = 0; k <= n; ++k)
+	{
+		dscr::combinations X(n,k);
+		std::vector<T> out(k+1);
+		for (auto& x : X)
+		{
+			auto A = dscr::make_arrangement(total,x);
+			auto end = A.gather_into(out.data());
+			ASSERT_EQ(end, out.data() + k);
+			for (int i = 0; i < k; ++i)
+				ASSERT_EQ(out[i], total[x[i]]);
+			ASSERT_EQ(A.bake(), std::vector<T>(out.begin(), out.begin()+k));
+		}
+	}
+}
+
+TEST(Arrangements, GatherInto)
+{
+	std::vector<int> ints(13);
+	std::iota(ints.begin(), ints.end(), 100);
+	check_gather_into(ints);
+	
+	std::vector<double> doubles(11);
+	std::iota(doubles.begin(), doubles.end(), 0.5);
+	check_gather_into(doubles);
+	
+	std::vector<short> shorts(10);
+	std::iota(shorts.begin(), shorts.end(), -3);
+	check_gather_into(shorts);
+	
+	check_gather_into(generate_random_strings(9));
+	
+	// long permutations, so that the wide paths are used many times (and with an iterator, the generic one).
+	std::vector<long long> big(40);
+	std::iota(big.begin(), big.end(), 1LL << 40);
+	std::vector<int> p(big.size());
+	std::iota(p.begin(), p.end(), 0);
+	std::vector<long long> out(big.size());
+	for (int t = 0; t < 100; ++t)
+	{
+		std::shuffle(p.begin(), p.end(), dscr::random::random_engine());
+		auto A = dscr::make_arrangement(big, p);
+		A.gather_into(out.begin());
+		for (size_t i = 0; i < p.size(); ++i)
+			ASSERT_EQ(out[i], big[p[i]]);
+	}
+}
+
+TEST(Arrangements, GatherMany)
+{
+	std::vector<float> total = {1.5, 2.5, 3.5, 4.5, 5.5, 6.5, 7.5, 8.5, 9.5, 10.5, 11.5, 12.5};
+	int n = total.size();
+	int k = 9;
+	dscr::combinations X(n,k);
+	std::vector<float> out(X.size()*k);
+	auto end = dscr::gather_many(total, X.begin(), X.end(), out.data());
+	ASSERT_EQ(end, out.data() + out.size());
+	
+	long i = 0;
+	for (auto& x : X)
+	{
+		for (int j = 0; j < k; ++j)
+			ASSERT_EQ(out[i*k + j], total[x[j]]);
+		++i;
+	}
+	
+	// index containers of different sizes are just written one after the other.
+	std::vector<std::array<int,3>> I = {{{0,1,2}}, {{3,3,3}}, {{11,0,5}}};
+	std::vector<float> out2(9);
+	dscr::gather_many(total, I.begin(), I.end(), out2.begin());
+	ASSERT_EQ(out2, std::vector<float>({1.5, 2.5, 3.5, 4.5, 4.5, 4.5, 12.5, 1.5, 6.5}));
+}
@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include "discreture.hpp"
+#include "BinaryExport.hpp"
+
+using namespace std;
+using namespace dscr;
+
+static std::string temp_file(const std::string& name)
+{
+	return ::testing::TempDir() + "discreture_" + name + ".bin";
+}
+
+TEST(BinaryExport, CombinationsRoundTrip)
+{
+	combinations X(12,4);
+	auto filename = temp_file("combinations");
+	ASSERT_EQ(export_objects(filename, X, "combinations", {12,4}), X.size());
+
+	binary_objects Y(filename);
+	ASSERT_EQ(Y.size(), X.size());
+	ASSERT_EQ(Y.family(), "combinations");
+	ASSERT_EQ(Y.param(0), 12);
+	ASSERT_EQ(Y.param(1), 4);
+	ASSERT_EQ(Y.header().element_size, 1);
+	ASSERT_EQ(Y.header().record_length, 4);
+
+	auto it = Y.begin();
+	for (auto& x : X)
+	{
+		ASSERT_EQ(*it, x);
+		++it;
+	}
+	ASSERT_EQ(it, Y.end());
+
+	// random access
+	for (long i = 0; i < X.size(); i += 37)
+	{
+		ASSERT_EQ(Y[i], X[i]);
+		ASSERT_EQ(*(Y.begin() + i), X[i]);
+		ASSERT_EQ(*(Y.end() - i - 1), X[X.size() - i - 1]);
+	}
+	std::remove(filename.c_str());
+}
+
+TEST(BinaryExport, SignedAndWideElements)
+{
+	dyck_paths D(6);
+	auto filename = temp_file("dyck");
+	export_objects(filename, D, "dyck_paths", {6});
+
+	binary_objects Y(filename);
+	ASSERT_EQ(Y.size(), D.size());
+	for (long i = 0; i < D.size(); ++i)
+		ASSERT_EQ(Y[i], D[i]);
+
+	std::vector<std::vector<int>> big = {{-70000, 5, 1 << 30}, {3, 2, -1}};
+	export_objects(filename, big, "big", {}, 4);
+	basic_binary_objects<long long> Z(filename);
+	ASSERT_EQ(Z.size(), 2);
+	ASSERT_EQ(Z[0], std::vector<long long>({-70000, 5, 1 << 30}));
+	ASSERT_EQ(Z[1], std::vector<long long>({3, 2, -1}));
+
+	ASSERT_THROW(export_objects(filename, big, "big", {}, 2), std::out_of_range);
+	std::remove(filename.c_str());
+}
+
+TEST(BinaryExport, FilteredObjects)
+{
+	multisets X({3,2,0,4,1});
+	auto pred = [](const multisets::multiset& x) { return x[0] + x[3] == 4; };
+	auto filename = temp_file("multisets");
+
+	auto written = export_objects_if(filename, X, pred, "multisets", {5});
+
+	basic_binary_objects<int, boost::container::static_vector<int, 5>> Y(filename);
+	ASSERT_EQ(Y.size(), written);
+
+	auto it = Y.begin();
+	for (auto& x : X)
+	{
+		if (!pred(x))
+			continue;
+		ASSERT_TRUE(std::equal(x.begin(), x.end(), it->begin(), it->end()));
+		++it;
+	}
+	ASSERT_EQ(it, Y.end());
+	std::remove(filename.c_str());
+}
+
+TEST(BinaryExport, Ranks)
+{
+	combinations X(20,6);
+	auto pred = [](const combinations::combination& c) { return (c[0] + c[5])%7 == 0; };
+	auto filename = temp_file("ranks");
+
+	auto written = export_ranks_if(filename, X, pred, "combinations", {20,6});
+	ASSERT_GT(written, 0);
+
+	binary_ranks<combinations> Y(filename, X);
+	ASSERT_EQ(Y.size(), written);
+
+	auto it = Y.begin();
+	long count = 0;
+	for (auto jt = X.begin(); jt != X.end(); ++jt)
+	{
+		if (!pred(*jt))
+			continue;
+		ASSERT_EQ(Y.rank(it.ID()), jt.ID());
+		ASSERT_EQ(*it, *jt);
+		++it;
+		++count;
+	}
+	ASSERT_EQ(count, written);
+	ASSERT_EQ(it, Y.end());
+
+	for (long i = 0; i < Y.size(); i += 11)
+	{
+		ASSERT_EQ(Y[i], X[Y.rank(i)]);
+		ASSERT_EQ(*(Y.begin() + i), X[Y.rank(i)]);
+	}
+
+	ASSERT_THROW(binary_objects Z(filename), std::runtime_error); // it's a ranks file
+	std::remove(filename.c_str());
+}
+
+TEST(BinaryExport, Errors)
+{
+	auto filename = temp_file("errors");
+	std::vector<std::vector<int>> ragged = {{1,2,3}, {1,2}};
+	ASSERT_THROW(export_objects(filename, ragged, "ragged", {}), std::invalid_argument);
+
+	ASSERT_THROW(binary_writer(filename, binary_objects_kind, "this name is way too long for the header", {}), std::invalid_argument);
+	ASSERT_THROW(binary_writer(filename, binary_objects_kind, "x", {}, 3), std::invalid_argument);
+
+	{
+		binary_writer w(filename, binary_ranks_kind, "x", {});
+		ASSERT_THROW(w.write(std::vector<int>{1}), std::logic_error);
+	}
+
+	// A file whose header doesn't match its size is rejected.
+	{
+		std::FILE* f = std::fopen(filename.c_str(), "ab");
+		std::fputc(0, f);
+		std::fclose(f);
+	}
+	ASSERT_THROW(binary_ranks<combinations>(filename, combinations(5,2)), std::runtime_error);
+	ASSERT_THROW(binary_objects("/this/file/does/not/exist.bin"), std::runtime_error);
+	std::remove(filename.c_str());
+}
@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include "discreture.hpp"
+
+using namespace std;
+using namespace dscr;
+
+// Every checkpoint taken along the way, written and read back, resumes exactly where it was taken.
+template <class Container>
+void check_resume(const Container& X, long long interval)
+{
+	using object = typename Container::value_type;
+	std::vector<object> all(X.begin(), X.end());
+
+	std::vector<checkpoint<object>> checkpoints;
+	long long count = 0;
+	for_each_with_checkpoints(X, [&count](const object&) { ++count; }, interval, [&checkpoints](const checkpoint<object>& cp) { checkpoints.push_back(cp); });
+
+	ASSERT_EQ(count, X.size());
+	ASSERT_EQ(checkpoints.size(), (X.size() + interval - 1)/interval);
+	ASSERT_EQ(checkpoints.back().rank, X.size());
+
+	for (auto& cp : checkpoints)
+	{
+		std::stringstream ss;
+		write_checkpoint(ss, cp);
+		checkpoint<object> restored;
+		read_checkpoint(ss, restored);
+		ASSERT_EQ(restored.rank, cp.rank);
+		ASSERT_EQ(restored.current, cp.current);
+
+		if (X.size() > restored.rank)
+		{
+			ASSERT_EQ(restored.current, all[restored.rank]);
+			ASSERT_EQ(resume(X, restored).ID(), restored.rank);
+		}
+
+		std::vector<object> rest;
+		for_each_with_checkpoints(X, restored, [&rest](const object& x) { rest.push_back(x); }, interval, [](const checkpoint<object>&) {});
+		ASSERT_TRUE(std::equal(rest.begin(), rest.end(), all.begin() + restored.rank, all.end()));
+		ASSERT_EQ(rest.size(), all.size() - restored.rank);
+	}
+}
+
+TEST(Checkpoint, EveryFamily)
+{
+	check_resume(combinations(10,4), 7);
+	check_resume(combinations_tree(9,4), 5);
+	check_resume(permutations(5), 11);
+	check_resume(multisets({2,1,3}), 3);
+	check_resume(partitions(12), 4);
+	check_resume(partitions(14,2,5), 6);
+	check_resume(set_partitions(6), 9);
+	check_resume(set_partitions(7,3), 13);
+	check_resume(dyck_paths(5), 4);
+	check_resume(motzkin_paths(6), 10);
+}
+
+TEST(Checkpoint, Parallel)
+{
+	combinations X(14,5);
+	std::string saved;
+	int calls = 0;
+	auto save_the_fifth = [&](const parallel_checkpoint<combinations::combination>& cp)
+	{
+		if (++calls == 5)
+		{
+			std::stringstream ss;
+			write_checkpoint(ss, cp);
+			saved = ss.str();
+		}
+	};
+
+	parallel_for_each_with_checkpoints(X, [](const combinations::combination&) {}, 4, 50, save_the_fifth);
+	ASSERT_FALSE(saved.empty());
+
+	parallel_checkpoint<combinations::combination> cp;
+	std::stringstream ss(saved);
+	read_checkpoint(ss, cp);
+	ASSERT_EQ(cp.positions.size(), 4);
+
+	// What the checkpoint says was done, plus what resuming does, is everything, once.
+	std::multiset<long long> done;
+	auto start = make_parallel_checkpoint(X, 4);
+	for (size_t i = 0; i < 4; ++i)
+	{
+		for (long long r = start.positions[i].rank; r < cp.positions[i].rank; ++r)
+			done.insert(r);
+		if (cp.positions[i].rank < cp.ends[i])
+		{
+			ASSERT_EQ(cp.positions[i].current, X[cp.positions[i].rank]);
+		}
+	}
+	ASSERT_EQ(done.size() + cp.remaining(), X.size());
+
+	std::mutex mtx;
+	long long last_remaining = -1;
+	parallel_for_each_with_checkpoints(X, cp, [&](const combinations::combination& c)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		done.insert(combinations::get_index(c));
+	}, 50, [&last_remaining](const parallel_checkpoint<combinations::combination>& cp) { last_remaining = cp.remaining(); });
+
+	ASSERT_EQ(last_remaining, 0);
+	ASSERT_EQ(done.size(), X.size());
+	ASSERT_EQ(std::set<long long>(done.begin(), done.end()).size(), X.size());
+}
+
+TEST(Checkpoint, ParallelResumeWithoutRandomAccess)
+{
+	partitions X(20);
+	std::vector<partitions::partition> all(X.begin(), X.end());
+
+	// Two blocks, each one already half done.
+	long long half = X.size()/2;
+	parallel_checkpoint<partitions::partition> cp;
+	cp.positions = {{half/2, all[half/2]}, {half + half/2, all[half + half/2]}};
+	cp.ends = {half, X.size()};
+
+	std::mutex mtx;
+	std::vector<partitions::partition> seen;
+	parallel_for_each_with_checkpoints(X, cp, [&](const partitions::partition& p)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		seen.push_back(p);
+	}, 10, [](const parallel_checkpoint<partitions::partition>&) {});
+
+	std::vector<partitions::partition> expected(all.begin() + half/2, all.begin() + half);
+	expected.insert(expected.end(), all.begin() + half + half/2, all.end());
+	std::sort(seen.begin(), seen.end());
+	std::sort(expected.begin(), expected.end());
+	ASSERT_EQ(seen, expected);
+}
+
+TEST(Checkpoint, Files)
+{
+	auto filename = ::testing::TempDir() + "discreture_checkpoint.ckpt";
+	set_partitions X(7);
+	auto it = X.begin();
+	std::advance(it, 300);
+
+	save_checkpoint(filename, make_checkpoint(it));
+	checkpoint<set_partitions::set_partition> cp;
+	load_checkpoint(filename, cp);
+	ASSERT_EQ(cp.rank, 300);
+	ASSERT_EQ(cp.current, *it);
+	ASSERT_EQ(*resume(X, cp), *it);
+
+	parallel_checkpoint<set_partitions::set_partition> wrong;
+	ASSERT_THROW(load_checkpoint(filename, wrong), std::runtime_error);
+	ASSERT_THROW(load_checkpoint("/this/file/does/not/exist.ckpt", cp), std::runtime_error);
+	std::remove(filename.c_str());
+}
@@ -245,6 +245,68 @@ TEST(Combinations,FindIf)
 	}
 }
 
+// Accepts the (partial) combinations with sum at most max_sum.
+struct bounded_sum
+{
+	int max_sum;
+	int sum {0};
+
+	void on_push(int x) { sum += x; }
+	void on_pop(int x) { sum -= x; }
+	bool accept() const { return sum <= max_sum; }
+};
+
+TEST(Combinations, IncrementalPredicate)
+{
+	static_assert(is_incremental_predicate<bounded_sum>::value, "");
+	static_assert(!is_incremental_predicate<bool(*)(const combinations::combination&)>::value, "");
+
+	combinations X(20,6);
+	int max_sum = 40;
+	auto stateless = [max_sum](const combinations::combination& comb)
+	{
+		return std::accumulate(comb.begin(), comb.end(), 0) <= max_sum;
+	};
+
+	auto A = X.find_all(stateless);
+	auto B = X.find_all(bounded_sum{max_sum});
+
+	auto it = B.begin();
+	long count = 0;
+	for (auto& a : A)
+	{
+		ASSERT_EQ(a, *it);
+		++it;
+		++count;
+	}
+	ASSERT_EQ(it, B.end());
+	ASSERT_EQ(count, std::count_if(X.begin(), X.end(), stateless));
+
+	// The state always matches the combination, also at the leaves.
+	bounded_sum pred{max_sum};
+	auto found = X.find_if(pred);
+	ASSERT_NE(found, X.end());
+	ASSERT_TRUE(stateless(*found));
+
+	// Unlike a partial predicate, an incremental one is asked about the first element too.
+	struct no_small_start
+	{
+		int first {-1};
+		int size {0};
+		void on_push(int x) { if (size++ == 0) first = x; }
+		void on_pop(int) { --size; }
+		bool accept() const { return first >= 3; }
+	};
+	auto C = combinations(8,3).find_all(no_small_start());
+	count = 0;
+	for (auto& c : C)
+	{
+		ASSERT_GE(c[0], 3);
+		++count;
+	}
+	ASSERT_EQ(count, binomial(5,3));
+}
+
 TEST(Combinations, PartitionPoint)
 {
 	int n = 60;
@@ -283,3 +283,70 @@ TEST(CombinationsTree, PartitionPoint)
 	ASSERT_EQ(rcomb.back(), 59);
 	
 }
+
+TEST(CombinationsTree, Optimize)
+{
+	int n = 22;
+	int k = 6;
+	std::vector<double> w(n);
+	std::uint64_t seed = 12345;
+	for (auto& x : w)
+	{
+		seed = seed*6364136223846793005ULL + 1442695040888963407ULL;
+		x = (seed >> 40)%1000;
+	}
+
+	// weights, minus a penalty for every pair of consecutive elements
+	auto score = [&w](const combinations_tree::combination& comb)
+	{
+		double s = 0;
+		for (size_t i = 0; i < comb.size(); ++i)
+		{
+			s += w[comb[i]];
+			if (i > 0 && comb[i] == comb[i-1] + 1)
+				s -= 300;
+		}
+		return s;
+	};
+
+	std::vector<double> max_after(n + 1, 0.0);
+	for (int i = n - 1; i >= 0; --i)
+		max_after[i] = std::max(max_after[i+1], w[i]);
+
+	auto bound = [&](const combinations_tree::combination& comb)
+	{
+		return score(comb) + (k - comb.size())*max_after[comb.back() + 1];
+	};
+
+	combinations_tree X(n,k);
+	std::vector<double> all;
+	for (auto& x : X)
+		all.push_back(score(x));
+	std::sort(all.rbegin(), all.rend());
+
+	const size_t m = 10;
+	for (size_t threads : {1, 4})
+	{
+		auto result = X.optimize(score, bound, m, threads);
+		ASSERT_EQ(result.best.size(), m);
+		ASSERT_EQ(result.scores.size(), m);
+		for (size_t i = 0; i < m; ++i)
+		{
+			check_combination_tree(result.best[i], n, k);
+			ASSERT_EQ(result.scores[i], score(result.best[i]));
+			ASSERT_EQ(result.scores[i], all[i]);
+		}
+		ASSERT_GT(result.pruned, 0);
+		ASSERT_LT(result.leaves, X.size());
+		ASSERT_LE(result.leaves + result.pruned, result.nodes);
+	}
+
+	// Asking for more than there are gives them all.
+	auto small = combinations_tree(5,2).optimize(score, bound, 100);
+	ASSERT_EQ(small.best.size(), 10);
+	ASSERT_TRUE(std::is_sorted(small.scores.rbegin(), small.scores.rend()));
+
+	auto empty = combinations_tree(5,0).optimize(score, bound, 3);
+	ASSERT_EQ(empty.best.size(), 1);
+	ASSERT_TRUE(empty.best[0].empty());
+}
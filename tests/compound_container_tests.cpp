@@ -1,6 +1,8 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <numeric>
+#include <algorithm>
 #include <gtest/gtest.h>
 #include "CompoundContainer.hpp"
 #include "Combinations.hpp"
@@ -24,7 +26,7 @@ void check_compound_container(const CompundContainer& U, const Objects& A, const
 	}
 	
 	size_t i = 0;
-	for (auto u : U)
+	for (const auto& u : U)
 	{
 		size_t j = 0;
 		for (auto w : u)
@@ -45,6 +47,42 @@ TEST(CompoundContainer, CreationAndSanity)
 	
 	check_compound_container(U,A,X);
 	
+	auto last = *std::prev(U.end());
+	ASSERT_EQ(last[2], "uch");
+	ASSERT_EQ(std::distance(U.begin(), U.end()), 3);
+}
+
+TEST(CompoundContainer, OutlivesTemporaryIterators)
+{
+	std::vector<std::string> A = {"a","b","c","d","e","f","g"};
+	auto U = dscr::compound_combinations(A,3);
+	dscr::combinations X(A.size(),3);
+	
+	// Each of these dereferences an iterator that is destroyed right away, so they must own their indices.
+	auto a = *(U.begin() + 20);
+	auto b = U.begin()[21];
+	auto c = *std::make_reverse_iterator(U.begin() + 31);
+	auto it = U.begin() + 22;
+	auto d = *it++;
+	
+	// Reuse the stack the temporaries were on.
+	std::vector<decltype(U)::iterator> others;
+	for (int i = 0; i < 10; ++i)
+		others.push_back(U.begin() + i);
+	
+	ASSERT_EQ(a.indices(), X[20]);
+	ASSERT_EQ(b.indices(), X[21]);
+	ASSERT_EQ(c.indices(), X[30]);
+	ASSERT_EQ(d.indices(), X[22]);
+	ASSERT_EQ(a[0], A[X[20][0]]);
+	ASSERT_EQ((*it).indices(), X[23]);
+	
+	std::vector<std::vector<int>> reversed;
+	for (auto rit = std::make_reverse_iterator(U.begin() + 20); rit != std::make_reverse_iterator(U.begin()); ++rit)
+		reversed.push_back(rit->indices());
+	ASSERT_EQ(reversed.size(), 20);
+	for (size_t i = 0; i < reversed.size(); ++i)
+		ASSERT_EQ(reversed[i], X[19 - i]);
 }
 
 TEST(CompoundContainer, Combinations)
@@ -82,3 +120,62 @@ TEST(CompoundContainer, Permutations)
 		check_compound_container(U,A,dscr::permutations(n));
 	}
 }
+
+TEST(CompoundContainer, RandomAccessOwnsIndices)
+{
+	std::vector<std::string> A = {"a","b","c","d","e","f","g"};
+	auto U = dscr::compound_combinations(A,3);
+	dscr::combinations X(A.size(),3);
+	
+	std::vector<decltype(U[0])> V;
+	for (int i = 0; i < U.size(); ++i)
+		V.push_back(U[i]);
+	
+	for (size_t i = 0; i < V.size(); ++i)
+	{
+		ASSERT_EQ(V[i].indices(), X[i]);
+		ASSERT_EQ(V[i].bake(), U[i].bake());
+	}
+}
+
+TEST(CompoundContainer, IterationIsAView)
+{
+	std::vector<std::string> A = {"a","b","c","d","e","f","g"};
+	auto U = dscr::compound_combinations(A,3);
+	
+	dscr::combinations X(A.size(),3);
+	
+	// the view points straight into the index iterator's storage, which is reused.
+	auto it = U.begin();
+	const auto* storage = &(*it).indices();
+	for (const auto& x : X)
+	{
+		ASSERT_EQ(&(*it).indices(), storage);
+		ASSERT_EQ((*it).indices(), x);
+		++it;
+	}
+	ASSERT_EQ(it, U.end());
+}
+
+TEST(CompoundContainer, GatherMany)
+{
+	std::vector<int> A(15);
+	std::iota(A.begin(), A.end(), 7);
+	int k = 10;
+	auto U = dscr::compound_combinations(A,k);
+	
+	std::vector<int> all(U.size()*k);
+	U.gather_many(U.begin(), U.end(), all.data());
+	
+	long i = 0;
+	for (const auto& u : U)
+	{
+		ASSERT_EQ(std::vector<int>(all.begin() + i*k, all.begin() + (i+1)*k), u.bake());
+		++i;
+	}
+	
+	std::vector<int> block(100*k);
+	auto end = U.gather_many(1000, 100, block.data());
+	ASSERT_EQ(end, block.data() + block.size());
+	ASSERT_TRUE(std::equal(block.begin(), block.end(), all.begin() + 1000*k));
+}
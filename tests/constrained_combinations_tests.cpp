@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include "discreture.hpp"
+
+using namespace std;
+using namespace dscr;
+
+struct sum_is
+{
+	using state_type = int;
+	int target;
+	int initial() const { return 0; }
+	int state(int sum, int x) const { return sum + x; }
+	bool viable(int sum) const { return sum <= target; }
+	bool accept(int sum) const { return sum == target; }
+};
+
+// No two consecutive elements. No viable, so bad prefixes are only rejected at the end.
+struct no_consecutive
+{
+	using state_type = std::pair<int, bool>; // last element, and whether two were consecutive
+	state_type initial() const { return {-2, false}; }
+	state_type state(const state_type& s, int x) const { return {x, s.second || x == s.first + 1}; }
+	bool accept(const state_type& s) const { return !s.second; }
+};
+
+template <class Machine, class Pred>
+static void check_against_brute_force(int n, int k, Machine machine, Pred pred)
+{
+	std::vector<combinations::combination> expected;
+	for (auto& x : combinations(n,k))
+		if (pred(x))
+			expected.push_back(x);
+	std::sort(expected.begin(), expected.end());
+
+	constrained_combinations<Machine> X(n, k, machine);
+	ASSERT_EQ(X.size(), expected.size());
+
+	for (long long i = 0; i < X.size(); ++i)
+	{
+		ASSERT_EQ(X[i], expected[i]);
+		ASSERT_EQ(X.get_index(expected[i]), i);
+	}
+
+	std::vector<combinations::combination> visited;
+	X.for_each([&visited](const auto& x) { visited.push_back(x); });
+	ASSERT_EQ(visited, expected);
+
+	if (k == 0) // find_all never yields the empty combination
+		return;
+
+	visited.clear();
+	for (auto& x : X.find_all())
+		visited.push_back(x);
+	ASSERT_EQ(visited, expected);
+}
+
+struct anything
+{
+	using state_type = int;
+	int initial() const { return 0; }
+	int state(int s, int) const { return s; }
+	bool accept(int) const { return true; }
+};
+
+TEST(ConstrainedCombinations, Overflow)
+{
+	constrained_combinations<anything> X(60, 30);
+	ASSERT_EQ(X.size(), combinations(60,30).size());
+	ASSERT_EQ(X.get_index(X[X.size() - 1]), X.size() - 1);
+
+	// C(70,35) doesn't fit in a long long
+	ASSERT_THROW(constrained_combinations<anything>(70, 35), std::overflow_error);
+}
+
+TEST(ConstrainedCombinations, Sum)
+{
+	for (int target : {0, 10, 40, 75, 200})
+	{
+		check_against_brute_force(20, 5, sum_is{target}, [target](const auto& x)
+		{
+			return std::accumulate(x.begin(), x.end(), 0) == target;
+		});
+	}
+
+	check_against_brute_force(7, 0, sum_is{0}, [](const auto&) { return true; });
+	check_against_brute_force(6, 6, sum_is{15}, [](const auto&) { return true; });
+}
+
+TEST(ConstrainedCombinations, WithoutViable)
+{
+	check_against_brute_force(16, 5, no_consecutive(), [](const auto& x)
+	{
+		for (size_t i = 1; i < x.size(); ++i)
+			if (x[i] == x[i-1] + 1)
+				return false;
+		return true;
+	});
+
+	// C(n-k+1, k) of them
+	constrained_combinations<no_consecutive> X(40, 12);
+	ASSERT_EQ(X.size(), combinations(29,12).size());
+}
+
+TEST(ConstrainedCombinations, UniformSampling)
+{
+	constrained_combinations<sum_is> X(12, 3, sum_is{15});
+	std::vector<int> hits(X.size(), 0);
+	std::mt19937 g(42);
+
+	const int samples = 2000*X.size();
+	for (int i = 0; i < samples; ++i)
+	{
+		auto x = X.random(g);
+		ASSERT_EQ(std::accumulate(x.begin(), x.end(), 0), 15);
+		++hits[X.get_index(x)];
+	}
+
+	for (int h : hits)
+	{
+		ASSERT_GT(h, 1700);
+		ASSERT_LT(h, 2300);
+	}
+}
+
+TEST(ConstrainedCombinations, TooManyToEnumerate)
+{
+	constrained_combinations<sum_is> X(80, 12, sum_is{480});
+	ASSERT_GT(X.size(), 1000000000LL);
+	ASSERT_LT(X.num_states(), 1000000);
+
+	std::mt19937 g(7);
+	std::uniform_int_distribution<long long> d(0, X.size() - 1);
+	for (int i = 0; i < 100; ++i)
+	{
+		long long r = d(g);
+		auto x = X[r];
+		ASSERT_EQ(std::accumulate(x.begin(), x.end(), 0), 480);
+		ASSERT_TRUE(std::is_sorted(x.begin(), x.end()));
+		ASSERT_EQ(X.get_index(x), r);
+	}
+
+	ASSERT_LT(X[0], X[1]);
+	ASSERT_LT(X[X.size() - 2], X[X.size() - 1]);
+}
@@ -0,0 +1,22 @@
+#include <gtest/gtest.h>
+#include "discreture.hpp"
+
+using namespace std;
+using namespace dscr;
+
+// The main test program is built with the default policy, which must count nothing.
+
+TEST(DefaultInstrumentation, Disabled)
+{
+	ASSERT_FALSE(instrumentation::enabled);
+
+	combinations X(10,3);
+	reset_instrumentation();
+	for (auto it = X.begin(); it != X.end(); ++it) {}
+	auto x = X[50];
+	ASSERT_EQ(X.get_index(x), 50);
+
+	auto counts = instrumentation_snapshot();
+	ASSERT_EQ(counts(instrumented::combinations, instrumented::step), 0);
+	ASSERT_EQ(counts(instrumented::combinations, instrumented::unrank), 0);
+}
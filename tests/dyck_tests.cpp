@@ -1,7 +1,9 @@
 #include <gtest/gtest.h>
 #include <iostream>
 #include "DyckPaths.hpp"
+#include "DyckPathsPacked.hpp"
 #include <set>
+#include <algorithm>
 
 using namespace std;
 using namespace dscr;
@@ -35,3 +37,144 @@ TEST(DyckPaths,ForwardIteration)
 		}
 	}
 }
+
+TEST(DyckPaths,PackedMatchesUnpacked)
+{
+	for (int n = 0; n < 10; ++n)
+	{
+		dyck_paths X(n);
+		dyck_paths_packed Y(n);
+		ASSERT_EQ(X.size(), Y.size());
+
+		auto it = Y.begin();
+		for (const auto& x : X)
+		{
+			ASSERT_EQ(dyck_paths_packed::pack(x), *it);
+			ASSERT_EQ(dyck_paths_packed::unpack(*it, n), x);
+			ASSERT_EQ(dyck_paths_packed::to_string(*it, n), dyck_paths::to_string(x));
+			++it;
+		}
+		ASSERT_EQ(it, Y.end());
+
+		long i = 0;
+		Y.for_each([&i,n](const dyck_paths_packed::dyck_path& y)
+		{
+			check_dyck_path(dyck_paths_packed::unpack(y, n));
+			++i;
+		});
+		ASSERT_EQ(i, Y.size());
+	}
+}
+
+TEST(DyckPaths,PackedHeightAndPeaks)
+{
+	int n = 9;
+	for (auto y : dyck_paths_packed(n))
+	{
+		auto x = dyck_paths_packed::unpack(y, n);
+		int h = 0;
+		int peaks = 0;
+		for (int i = 0; i < 2*n; ++i)
+		{
+			ASSERT_EQ(dyck_paths_packed::height(y, i), h);
+			h += x[i];
+			if (i + 1 < 2*n && x[i] == 1 && x[i+1] == -1)
+			{
+				ASSERT_TRUE(dyck_paths_packed::is_peak(y, i));
+				++peaks;
+			}
+		}
+		ASSERT_EQ(dyck_paths_packed::height(y, 2*n), 0);
+		ASSERT_EQ(dyck_paths_packed::num_peaks(y), peaks);
+	}
+
+	// n = 32 uses the whole word
+	auto last = dyck_paths_packed::first_dyck_path(32);
+	ASSERT_EQ(last, ~std::uint64_t(0) >> 32);
+	dyck_paths_packed::next_dyck_path(last, 32);
+	ASSERT_EQ(dyck_paths_packed::height(last, 64), 0);
+	ASSERT_EQ(dyck_paths_packed::to_string(last, 32).substr(30, 4), "()()");
+}
+
+TEST(DyckPaths,ReverseIteration)
+{
+	for (int n = 0; n < 9; ++n)
+	{
+		dyck_paths X(n);
+		std::vector<dyck_paths::dyck_path> forward(X.begin(), X.end());
+		std::vector<dyck_paths::dyck_path> backward(X.rbegin(), X.rend());
+		std::reverse(backward.begin(), backward.end());
+		ASSERT_EQ(forward, backward);
+
+		dyck_paths_packed Y(n);
+		std::vector<dyck_paths_packed::dyck_path> pbackward(Y.rbegin(), Y.rend());
+		ASSERT_EQ(pbackward.size(), forward.size());
+		for (size_t i = 0; i < forward.size(); ++i)
+			ASSERT_EQ(dyck_paths_packed::pack(forward[i]), pbackward[forward.size() - i - 1]);
+	}
+}
+
+TEST(DyckPaths,RankAndUnrank)
+{
+	for (int n = 0; n < 10; ++n)
+	{
+		dyck_paths X(n);
+		dyck_paths_packed Y(n);
+		long i = 0;
+		for (const auto& x : X)
+		{
+			ASSERT_EQ(X.get_index(x), i);
+			ASSERT_EQ(X[i], x);
+			ASSERT_EQ(Y.get_index(Y[i]), i);
+			ASSERT_EQ(dyck_paths_packed::unpack(Y[i], n), x);
+			++i;
+		}
+	}
+}
+
+TEST(DyckPaths,RandomAccess)
+{
+	int n = 14;
+	dyck_paths X(n);
+	dyck_paths_packed Y(n);
+	long step = X.size()/37;
+
+	for (long i = 0; i < X.size(); i += step)
+	{
+		auto it = X.begin() + i;
+		ASSERT_EQ(it.ID(), i);
+		ASSERT_EQ(*it, X[i]);
+		check_dyck_path(*it);
+
+		if (i >= 5 && i + 25 < X.size())
+		{
+			auto jt = it;
+			jt += 25;
+			jt -= 30;
+			ASSERT_EQ(*jt, X[i - 5]);
+		}
+		ASSERT_EQ(X.end() - it, X.size() - i);
+
+		auto rit = X.rbegin() + i;
+		ASSERT_EQ(*rit, X[X.size() - i - 1]);
+
+		ASSERT_EQ(*(Y.begin() + i), Y[i]);
+		ASSERT_EQ(*(Y.rbegin() + i), Y[Y.size() - i - 1]);
+		ASSERT_EQ(X.get_iterator(*it).ID(), i);
+	}
+}
+
+TEST(DyckPaths,ForEach)
+{
+	for (int n = 0; n < 10; ++n)
+	{
+		dyck_paths X(n);
+		auto it = X.begin();
+		X.for_each([&it](const dyck_paths::dyck_path& x)
+		{
+			ASSERT_EQ(x, *it);
+			++it;
+		});
+		ASSERT_EQ(it, X.end());
+	}
+}
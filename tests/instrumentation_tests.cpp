@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include "discreture.hpp"
+
+using namespace std;
+using namespace dscr;
+
+// This file is its own test program, built with DISCRETURE_INSTRUMENTATION=dscr::counting_instrumentation.
+
+TEST(Instrumentation, Enabled)
+{
+	ASSERT_TRUE(instrumentation::enabled);
+	ASSERT_FALSE(no_instrumentation::enabled);
+}
+
+TEST(Instrumentation, CombinationsStepsAndUnranks)
+{
+	combinations X(10,3);
+	reset_instrumentation();
+
+	for (auto it = X.begin(); it != X.end(); ++it) {}
+
+	auto counts = instrumentation_snapshot();
+	ASSERT_EQ(counts(instrumented::combinations, instrumented::step), X.size());
+	ASSERT_EQ(counts(instrumented::combinations, instrumented::unrank), 0);
+
+	auto x = X[50];
+	auto it = X.begin() + 100;
+	ASSERT_EQ(X[100], *it);
+	ASSERT_EQ(x, X[50]);
+
+	counts = instrumentation_snapshot();
+	ASSERT_EQ(counts(instrumented::combinations, instrumented::unrank), 4);
+	ASSERT_EQ(counts(instrumented::permutations, instrumented::step), 0);
+}
+
+TEST(Instrumentation, ForEachCountsEveryObject)
+{
+	dyck_paths D(7);
+	reset_instrumentation();
+	D.for_each([](const dyck_paths::dyck_path&) {});
+	ASSERT_EQ(thread_instrumentation_snapshot()(instrumented::dyck_paths, instrumented::step), D.size());
+
+	combinations_tree T(12,4);
+	T.for_each([](const combinations_tree::combination&) {});
+	ASSERT_EQ(thread_instrumentation_snapshot()(instrumented::combinations_tree, instrumented::step), T.size());
+}
+
+TEST(Instrumentation, MotzkinResets)
+{
+	int n = 8;
+	motzkin_paths M(n);
+	reset_instrumentation();
+
+	for (auto it = M.begin(); it != M.end(); ++it) {}
+
+	// One reset every time the positions run out, that is, at every new (dyck path, k) pair.
+	std::uint64_t blocks = 0;
+	for (int k = 0; 2*k <= n; ++k)
+		blocks += catalan(k);
+
+	auto counts = instrumentation_snapshot();
+	ASSERT_EQ(counts(instrumented::motzkin_paths, instrumented::step), M.size());
+	ASSERT_EQ(counts(instrumented::motzkin_paths, instrumented::reset), blocks - 1);
+	ASSERT_EQ(counts(instrumented::dyck_paths, instrumented::step), 0); // Motzkin counts as Motzkin only
+}
+
+TEST(Instrumentation, PartitionResets)
+{
+	int n = 10;
+	partitions P(n);
+	reset_instrumentation();
+
+	for (auto it = P.begin(); it != P.end(); ++it) {}
+	ASSERT_EQ(instrumentation_snapshot()(instrumented::partitions, instrumented::reset), n - 1);
+
+	reset_instrumentation();
+	set_partitions S(6);
+	for (auto it = S.begin(); it != S.end(); ++it) {}
+
+	auto counts = instrumentation_snapshot();
+	ASSERT_EQ(counts(instrumented::set_partitions, instrumented::step), S.size());
+	// One reset per integer partition: the step past the last set partition also runs out.
+	ASSERT_EQ(counts(instrumented::set_partitions, instrumented::reset), partitions(6).size());
+	ASSERT_EQ(counts(instrumented::partitions, instrumented::reset), 0);
+}
+
+TEST(Instrumentation, AddsUpAllThreads)
+{
+	combinations X(16,5);
+	reset_instrumentation();
+
+	parallel_for_each(X, [](const combinations::combination&) {}, 4);
+
+	// The work happened in other (already finished) threads.
+	ASSERT_EQ(thread_instrumentation_snapshot()(instrumented::combinations, instrumented::step), 0);
+
+	auto counts = instrumentation_snapshot();
+	auto steps = counts(instrumented::combinations, instrumented::step);
+	ASSERT_GT(steps, X.size()/2);
+	ASSERT_LE(steps, X.size());
+
+	reset_instrumentation();
+	ASSERT_EQ(instrumentation_snapshot()(instrumented::combinations, instrumented::step), 0);
+}
+
+TEST(Instrumentation, Dump)
+{
+	reset_instrumentation();
+	multisets MS({2,2,2});
+	for (auto it = MS.begin(); it != MS.end(); ++it) {}
+
+	std::stringstream ss;
+	dump_instrumentation(ss);
+	auto text = ss.str();
+	ASSERT_NE(text.find("multisets"), std::string::npos);
+	ASSERT_NE(text.find("27"), std::string::npos);
+	ASSERT_EQ(text.find("permutations"), std::string::npos);
+}
@@ -1,11 +1,16 @@
+#define DISCRETURE_COUNT_ALLOCATIONS
+#include "AllocationCounter.hpp"
 #include <gtest/gtest.h>
 #include "TimeHelpers.hpp"
 #include "Combinations.hpp"
+#include "Instrumentation.hpp"
 #include <iostream>
 
 int main(int argc, char* argv[])
 {
 	::testing::InitGoogleTest(&argc,argv);
+	// Registers this thread's counters now, so it doesn't show up in the allocation tests.
+	dscr::thread_instrumentation_snapshot();
 	return RUN_ALL_TESTS();
 }
 
@@ -2,6 +2,7 @@
 #include <iostream>
 #include "Motzkin.hpp"
 #include <set>
+#include <algorithm>
 
 using namespace std;
 using namespace dscr;
@@ -35,3 +36,81 @@ TEST(MotzkinPaths,ForwardIteration)
 		}
 	}
 }
+
+TEST(MotzkinPaths,ReverseIteration)
+{
+	for (int n = 0; n < 10; ++n)
+	{
+		motzkin_paths X(n);
+		std::vector<motzkin_paths::motzkin_path> forward(X.begin(), X.end());
+		std::vector<motzkin_paths::motzkin_path> backward(X.rbegin(), X.rend());
+		std::reverse(backward.begin(), backward.end());
+		ASSERT_EQ(forward, backward);
+	}
+}
+
+TEST(MotzkinPaths,RankAndUnrank)
+{
+	for (int n = 0; n < 10; ++n)
+	{
+		motzkin_paths X(n);
+		long i = 0;
+		for (auto it = X.begin(); it != X.end(); ++it)
+		{
+			const auto& x = *it;
+			ASSERT_EQ(X.get_index(x), i);
+			ASSERT_EQ(X[i], x);
+
+			// The composite representation agrees with the path
+			const auto& positions = it.nonzero_positions();
+			const auto& steps = it.nonzero_steps();
+			ASSERT_EQ(positions.size(), steps.size());
+			for (size_t j = 0; j < positions.size(); ++j)
+				ASSERT_EQ(x[positions[j]], steps[j]);
+			++i;
+		}
+	}
+}
+
+TEST(MotzkinPaths,RandomAccess)
+{
+	int n = 16;
+	motzkin_paths X(n);
+	long step = X.size()/41;
+
+	for (long i = 0; i < X.size(); i += step)
+	{
+		auto it = X.begin() + i;
+		ASSERT_EQ(it.ID(), i);
+		check_motzkin_path(*it);
+		ASSERT_EQ(X.get_index(*it), i);
+		ASSERT_EQ(X.get_iterator(*it).ID(), i);
+
+		if (i >= 5 && i + 60 < X.size())
+		{
+			auto jt = it;
+			jt += 60;
+			jt -= 65;
+			ASSERT_EQ(*jt, X[i - 5]);
+		}
+		ASSERT_EQ(X.end() - it, X.size() - i);
+
+		auto rit = X.rbegin() + i;
+		ASSERT_EQ(*rit, X[X.size() - i - 1]);
+	}
+}
+
+TEST(MotzkinPaths,ForEach)
+{
+	for (int n = 0; n < 10; ++n)
+	{
+		motzkin_paths X(n);
+		auto it = X.begin();
+		X.for_each([&it](const motzkin_paths::motzkin_path& x)
+		{
+			ASSERT_EQ(x, *it);
+			++it;
+		});
+		ASSERT_EQ(it, X.end());
+	}
+}
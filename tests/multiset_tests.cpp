@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include <iostream>
 #include "Multisets.hpp"
+#include "MultisetsGray.hpp"
+#include <algorithm>
 #include <set>
 #include "Probability.hpp"
 
@@ -147,3 +149,129 @@ TEST(Multisets, PartitionPoint)
 	
 	ASSERT_EQ(t, correct);	
 }
+
+TEST(Multisets, ExactSize)
+{
+	multisets X(39,2);
+	ASSERT_EQ(X.size(), 4052555153018976267LL);
+	multisets_gray G(39,2);
+	ASSERT_EQ(G.size(), 4052555153018976267LL);
+	ASSERT_THROW(multisets(40,2), std::overflow_error);
+}
+
+TEST(MultisetsGray, ForwardIteration)
+{
+	for (int n = 0; n < 12; ++n)
+	{
+		auto total = get_random_multiset(n);
+		multisets_gray X(total);
+		set<multisets_gray::multiset> S(X.begin(),X.end());
+		ASSERT_EQ(X.size(), S.size());
+		
+		long i = 0;
+		multisets_gray::multiset prev;
+		for (auto it = X.begin(); it != X.end(); ++it, ++i)
+		{
+			const auto& x = *it;
+			check_multiset(x, total);
+			ASSERT_EQ(X.get_index(x),i);
+			ASSERT_EQ(X[i],x);
+			
+			if (i == 0)
+			{
+				ASSERT_EQ(it.changed_index(), -1);
+				ASSERT_EQ(x, multisets_gray::multiset(n,0));
+			}
+			else
+			{
+				int j = it.changed_index();
+				ASSERT_GE(j, 0);
+				ASSERT_EQ(x[j] - prev[j], it.changed_by());
+				ASSERT_TRUE(it.changed_by() == 1 || it.changed_by() == -1);
+				for (int k = 0; k < n; ++k)
+				{
+					if (k != j)
+					{
+						ASSERT_EQ(x[k], prev[k]);
+					}
+				}
+			}
+			prev = x;
+		}
+		ASSERT_EQ(i, X.size());
+	}
+}
+
+TEST(MultisetsGray, ReverseIteration)
+{
+	for (int n = 0; n < 12; ++n)
+	{
+		auto total = get_random_multiset(n);
+		multisets_gray X(total);
+		std::vector<multisets_gray::multiset> forward(X.begin(), X.end());
+		std::vector<multisets_gray::multiset> backward(X.rbegin(), X.rend());
+		std::reverse(backward.begin(), backward.end());
+		ASSERT_EQ(forward, backward);
+		
+		long i = 0;
+		multisets_gray::multiset prev;
+		for (auto it = X.rbegin(); it != X.rend(); ++it, ++i)
+		{
+			if (i > 0)
+			{
+				int j = it.changed_index();
+				ASSERT_GE(j, 0);
+				ASSERT_EQ((*it)[j] - prev[j], it.changed_by());
+			}
+			prev = *it;
+		}
+	}
+}
+
+TEST(MultisetsGray, Bidirectional)
+{
+	for (int n = 0; n < 8; ++n)
+	{
+		auto total = get_random_multiset(n);
+		multisets_gray X(total);
+		if (X.size() < 2)
+			continue;
+		auto it = X.begin();
+		int start = dscr::random::random_int<int>(0,X.size()/2);
+		dumb_advance(it,start);
+		auto x = *it;
+		ASSERT_EQ(*it,X[start]);
+		int adv = random::random_int<int>(0,X.size()/2);
+		dumb_advance(it,adv);
+		ASSERT_EQ(*it,X[start+adv]);
+		dumb_advance(it,-adv);
+		ASSERT_EQ(*it,x);
+		
+		// going forward after a jump has to keep the gray code going.
+		std::advance(it, adv);
+		for (auto i = start + adv; i < X.size(); ++i, ++it)
+			ASSERT_EQ(*it, X[i]);
+		
+		auto rit = X.rbegin();
+		dumb_advance(rit, start + 1);
+		--rit;
+		for (auto i = X.size() - 1 - start; i >= 0; --i, ++rit)
+			ASSERT_EQ(*rit, X[i]);
+	}
+}
+
+TEST(MultisetsGray, ForEach)
+{
+	for (int n = 0; n < 10; ++n)
+	{
+		auto total = get_random_multiset(n);
+		multisets_gray_fast X(multisets_gray_fast::multiset(total.begin(), total.end()));
+		long i = 0;
+		X.for_each([&X,&i](const auto& x)
+		{
+			ASSERT_EQ(x, X[i]);
+			++i;
+		});
+		ASSERT_EQ(i, X.size());
+	}
+}
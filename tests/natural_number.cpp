@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 #include <iostream>
+#include <algorithm>
+#include <set>
 #include "NaturalNumber.hpp"
 
 using namespace std;
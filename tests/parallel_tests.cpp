@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <numeric>
+#include "discreture.hpp"
+
+using namespace std;
+using namespace dscr;
+
+TEST(Parallel, CountIf)
+{
+	combinations X(18,6);
+	auto pred = [](const combinations::combination& c) { return (c[0] + c[2] + c[5])%5 == 0; };
+	auto expected = std::count_if(X.begin(), X.end(), pred);
+
+	for (size_t threads : {1, 2, 3, 8})
+		ASSERT_EQ(parallel_count_if(X, pred, threads), expected);
+
+	permutations Y(7);
+	auto fixed_points = [](const permutations::permutation& p) { return p[0] == 0; };
+	ASSERT_EQ(parallel_count_if(Y.begin(), Y.end(), fixed_points, 4), 720);
+}
+
+TEST(Parallel, Reduce)
+{
+	combinations X(16,5);
+	auto sum = [](const combinations::combination& c) { return std::accumulate(c.begin(), c.end(), 0LL); };
+	long long expected = 0;
+	for (auto& x : X)
+		expected += sum(x);
+
+	for (size_t threads : {1, 2, 5, 7})
+		ASSERT_EQ(parallel_reduce(X, 0LL, std::plus<long long>(), sum, threads), expected);
+
+	// op needn't be commutative: the blocks are folded in order.
+	multisets Y({2,1,2});
+	auto digits = [](const multisets::multiset& m) { std::string s; for (auto x : m) s += char('0' + x); return s; };
+	std::string concatenated = "^";
+	for (auto& y : Y)
+		concatenated += digits(y);
+	for (size_t threads : {1, 3, 4, 40})
+		ASSERT_EQ(parallel_reduce(Y, std::string("^"), std::plus<std::string>(), digits, threads), concatenated);
+}
+
+TEST(Parallel, FindFirst)
+{
+	combinations X(24,6);
+	for (long long target : {0LL, 1LL, 1000LL, 12345LL, X.size()/2, X.size() - 1})
+	{
+		auto T = X[target];
+		// Every combination whose last element is T[5] and whose rank is at least target.
+		auto pred = [&T, target](const combinations::combination& c) { return c[5] == T[5] && combinations::get_index(c) >= target; };
+		for (size_t threads : {1, 2, 4, 8})
+		{
+			auto it = parallel_find_first(X, pred, threads);
+			ASSERT_NE(it, X.end());
+			ASSERT_EQ(it.ID(), target);
+			ASSERT_EQ(*it, T);
+		}
+	}
+
+	auto never = [](const combinations::combination&) { return false; };
+	ASSERT_EQ(parallel_find_first(X, never, 4), X.end());
+	ASSERT_EQ(parallel_find_first(X.begin(), X.begin(), never, 4), X.begin());
+}
+
+TEST(Parallel, FindFirstIsTheLowestMatch)
+{
+	permutations X(9);
+	auto pred = [](const permutations::permutation& p) { return p[0] == 5 && p[8] == 2; };
+	auto expected = std::find_if(X.begin(), X.end(), pred);
+
+	for (int rep = 0; rep < 5; ++rep)
+		ASSERT_EQ(parallel_find_first(X, pred, 8), expected);
+}
+
+TEST(Parallel, AnyOf)
+{
+	combinations X(22,7);
+	auto sum_is = [](int s) { return [s](const combinations::combination& c) { return std::accumulate(c.begin(), c.end(), 0) == s; }; };
+
+	ASSERT_TRUE(parallel_any_of(X, sum_is(21), 4)); // only the first one
+	ASSERT_TRUE(parallel_any_of(X, sum_is(126), 4)); // only the last one
+	ASSERT_FALSE(parallel_any_of(X, sum_is(20), 4));
+	ASSERT_FALSE(parallel_any_of(X.begin(), X.begin(), sum_is(21), 4));
+}
+
+TEST(Parallel, TopK)
+{
+	combinations X(20,5);
+	// Lots of ties, to check they're broken by rank.
+	auto score = [](const combinations::combination& c) { return (c[0]*7 + c[1]*3 + c[4])%23; };
+
+	std::vector<std::pair<int, combinations::combination>> expected;
+	for (auto& x : X)
+		expected.emplace_back(score(x), x);
+	std::stable_sort(expected.begin(), expected.end(), [](auto& a, auto& b) { return a.first > b.first; });
+
+	for (size_t k : {0, 1, 10, 100})
+	{
+		for (size_t threads : {1, 3, 8})
+		{
+			auto top = parallel_top_k(X, k, score, threads);
+			ASSERT_EQ(top.size(), k);
+			for (size_t i = 0; i < k; ++i)
+				ASSERT_EQ(top[i], expected[i]);
+		}
+	}
+
+	// More than there are.
+	combinations Y(6,3);
+	auto all = parallel_top_k(Y.begin(), Y.end(), 100, [](const combinations::combination& c) { return -c[2]; }, 4);
+	ASSERT_EQ(all.size(), Y.size());
+	ASSERT_EQ(all.front().second, Y[0]);
+	ASSERT_EQ(all.back().second, Y[Y.size() - 1]);
+}
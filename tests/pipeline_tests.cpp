@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include "discreture.hpp"
+
+using namespace std;
+using namespace dscr;
+
+static long long producers_factor(int p) { return p + 1; }
+
+template <class Queue>
+void check_ring(int producers, int consumers)
+{
+	const long long per_producer = 20000;
+	Queue q(8);
+	std::atomic<long long> sum {0};
+	std::atomic<long long> popped {0};
+	std::vector<std::thread> threads;
+
+	for (int p = 0; p < producers; ++p)
+	{
+		threads.emplace_back([&q, p]()
+		{
+			for (long long i = 1; i <= per_producer; ++i)
+			{
+				while (!q.try_push(i*producers_factor(p)))
+					std::this_thread::yield();
+			}
+		});
+	}
+
+	for (int c = 0; c < consumers; ++c)
+	{
+		threads.emplace_back([&]()
+		{
+			long long x;
+			while (popped.load() < producers*per_producer)
+			{
+				if (q.try_pop(x))
+				{
+					sum += x;
+					++popped;
+				}
+				else
+				{
+					std::this_thread::yield();
+				}
+			}
+		});
+	}
+
+	for (auto& t : threads)
+		t.join();
+
+	long long expected = 0;
+	for (int p = 0; p < producers; ++p)
+		expected += producers_factor(p)*per_producer*(per_producer + 1)/2;
+	ASSERT_EQ(sum.load(), expected);
+
+	long long x;
+	ASSERT_FALSE(q.try_pop(x));
+}
+
+TEST(Pipeline, Rings)
+{
+	check_ring<spsc_ring<long long>>(1, 1);
+	check_ring<mpmc_ring<long long>>(1, 1);
+	check_ring<mpmc_ring<long long>>(3, 1);
+	check_ring<mpmc_ring<long long>>(1, 4);
+	check_ring<mpmc_ring<long long>>(4, 4);
+
+	spsc_ring<int> q(3);
+	ASSERT_EQ(q.capacity(), 4);
+	for (int i = 0; i < 4; ++i)
+		ASSERT_TRUE(q.try_push(i));
+	ASSERT_FALSE(q.try_push(4)); // backpressure
+	int x;
+	ASSERT_TRUE(q.try_pop(x));
+	ASSERT_EQ(x, 0);
+	ASSERT_TRUE(q.try_push(4));
+}
+
+// Every object is consumed exactly once, whatever the options.
+template <class Container>
+void check_pipeline(const Container& X)
+{
+	using object = typename Container::value_type;
+	std::vector<object> expected(X.begin(), X.end());
+	std::sort(expected.begin(), expected.end());
+
+	std::vector<pipeline_options> all_options(5);
+	all_options[0].num_consumers = 1; // spsc
+	all_options[1].batch_size = 1;
+	all_options[1].queue_capacity = 1;
+	all_options[1].num_consumers = 3;
+	all_options[2].batch_size = 7;
+	all_options[2].queue_capacity = 2;
+	all_options[2].num_producers = 3;
+	all_options[2].num_consumers = 2;
+	all_options[3].batch_size = 1000000;
+	all_options[4].batch_size = 5;
+	all_options[4].num_producers = 8;
+	all_options[4].num_consumers = 1;
+
+	for (auto& options : all_options)
+	{
+		std::mutex mtx;
+		std::vector<object> seen;
+		auto stats = pipeline_for_each(X, [&](const object& x)
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			seen.push_back(x);
+		}, options);
+
+		std::sort(seen.begin(), seen.end());
+		ASSERT_EQ(seen, expected);
+		ASSERT_GE(stats.batches, (X.size() + options.batch_size - 1)/options.batch_size);
+	}
+}
+
+TEST(Pipeline, WholeRangeInOneBatch)
+{
+	// One producer and one consumer (spsc_ring), and the range ends exactly at the end of a batch.
+	combinations X(10,3);
+	for (std::size_t batch_size : {std::size_t(X.size()), std::size_t(X.size()/4), std::size_t(1)})
+	{
+		pipeline_options options;
+		options.batch_size = batch_size;
+		options.num_consumers = 1;
+
+		long long count = 0;
+		auto stats = pipeline_for_each(X, [&count](const combinations::combination&) { ++count; }, options);
+		ASSERT_EQ(count, X.size());
+		ASSERT_EQ(stats.batches, X.size()/batch_size);
+	}
+}
+
+TEST(Pipeline, EveryFamily)
+{
+	check_pipeline(combinations(12,5));
+	check_pipeline(combinations_tree(11,4));
+	check_pipeline(permutations(6));
+	check_pipeline(multisets({2,3,1,2}));
+	check_pipeline(partitions(15));
+	check_pipeline(set_partitions(6));
+	check_pipeline(dyck_paths(5));
+	check_pipeline(motzkin_paths(7));
+	check_pipeline(combinations(6,0));
+	check_pipeline(combinations(3,5));
+}
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <map>
+#include "discreture.hpp"
+#include "BinaryExport.hpp"
+
+using namespace std;
+using namespace dscr;
+
+TEST(RankMap, Combinations)
+{
+	combinations X(12,5);
+	combination_map<long long> M(12,5);
+	std::map<combinations::combination, long long> reference;
+	ASSERT_EQ(M.size(), X.size());
+
+	for (auto it = X.begin(); it != X.end(); ++it)
+	{
+		long long v = std::accumulate(it->begin(), it->end(), 0LL)*7 + it.ID()%3;
+		M.at(it) = v;
+		reference[*it] = v;
+	}
+
+	for (auto& kv : reference)
+		ASSERT_EQ(M[kv.first], kv.second);
+
+	combinations::combination key = {0,3,4,8,11};
+	M[key] += 100;
+	ASSERT_EQ(M.at_rank(combinations::get_index(key)), reference[key] + 100);
+
+	// batch lookups
+	std::vector<combinations::combination> keys = {X[3], X[700], X[0], X[X.size() - 1]};
+	std::vector<long long> got(keys.size());
+	M.get_many(keys.begin(), keys.end(), got.begin());
+	for (size_t i = 0; i < keys.size(); ++i)
+		ASSERT_EQ(got[i], M[keys[i]]);
+
+	std::vector<long long> contiguous;
+	M.get_range(10, 20, std::back_inserter(contiguous));
+	ASSERT_EQ(contiguous.size(), 10);
+	for (int r = 10; r < 20; ++r)
+		ASSERT_EQ(contiguous[r - 10], M[X[r]]);
+
+	long long visited = 0;
+	M.for_each([&](const combinations::combination& c, long long v) { ASSERT_EQ(v, M[c]); ++visited; });
+	ASSERT_EQ(visited, X.size());
+}
+
+TEST(RankMap, BracedKeys)
+{
+	combination_map<double> M(10,2);
+	M[{1,4}] = 2.5;
+	M[{0,9}] += 1.0;
+	const auto& C = M;
+	ASSERT_EQ((C[{1,4}]), 2.5);
+	ASSERT_EQ((C[{0,9}]), 1.0);
+	ASSERT_EQ((C[{2,3}]), 0.0);
+	ASSERT_EQ((M.index({1,4})), (combinations::get_index({1,4})));
+}
+
+TEST(RankMap, PermutationsAndMultisets)
+{
+	permutation_map<int> P(6, -1);
+	permutations X(6);
+	for (auto it = X.begin(); it != X.end(); ++it)
+	{
+		ASSERT_EQ(P[*it], -1);
+		P[*it] = it.ID();
+	}
+	for (auto it = X.begin(); it != X.end(); ++it)
+		ASSERT_EQ(P.at(it), it.ID());
+
+	multiset_map<double> S({2,0,3,1});
+	multisets Y({2,0,3,1});
+	ASSERT_EQ(S.size(), Y.size());
+	for (auto& y : Y)
+		S[y] = y[0] + 10*y[2];
+	for (auto it = Y.begin(); it != Y.end(); ++it)
+		ASSERT_EQ(S.at(it), (*it)[0] + 10*(*it)[2]);
+}
+
+TEST(RankMap, MappedStorage)
+{
+	auto filename = ::testing::TempDir() + "discreture_rank_map.bin";
+	std::remove(filename.c_str());
+	combinations X(15,4);
+
+	{
+		combination_map<double, mapped_array<double>> M(15, 4, mapped_array<double>(filename, X.size()));
+		for (auto it = X.begin(); it != X.end(); ++it)
+		{
+			ASSERT_EQ(M.at(it), 0.0);
+			M.at(it) = it.ID()*0.5;
+		}
+		M.values().sync();
+	}
+
+	// The table is still there in the next run.
+	{
+		combination_map<double, mapped_array<double>> M(15, 4, mapped_array<double>(filename, X.size()));
+		for (auto it = X.begin(); it != X.end(); ++it)
+			ASSERT_EQ(M[*it], it.ID()*0.5);
+	}
+
+	ASSERT_THROW(mapped_array<double>(filename, 7), std::runtime_error);
+	ASSERT_THROW(combination_map<double> M(15, 4, std::vector<double>(3)), std::invalid_argument);
+	std::remove(filename.c_str());
+}
@@ -3,6 +3,9 @@
 #include "Sequences.hpp"
 #include <set>
 #include "Probability.hpp"
+#include <stdexcept>
+#include <thread>
+#include <boost/multiprecision/cpp_int.hpp>
 
 using namespace std;
 using namespace dscr;
@@ -30,12 +33,101 @@ TEST(Sequences,Binomial)
 	
 	for (int i = 0; i < 100; ++i)
 	{
-		int n = random::random_int(0,100);
+		int n = random::random_int(0,67);
 		int k = random::random_int(0,n+1);
 		if (n == 0 && k == 0)
 			continue;
 		ASSERT_EQ(binomial(n,k),binomial(n-1,k)+binomial(n-1,k-1));
 	}
+	
+	using boost::multiprecision::cpp_int;
+	for (int i = 0; i < 100; ++i)
+	{
+		int n = random::random_int(0,200);
+		int k = random::random_int(0,n+1);
+		if (n == 0 && k == 0)
+			continue;
+		ASSERT_EQ(binomial<cpp_int>(n,k),binomial<cpp_int>(n-1,k)+binomial<cpp_int>(n-1,k-1));
+	}
+}
+
+TEST(Sequences,Overflow)
+{
+	using boost::multiprecision::cpp_int;
+	
+	ASSERT_EQ(factorial(20),2432902008176640000LL);
+	ASSERT_THROW(factorial(21),std::overflow_error);
+	ASSERT_EQ(factorial<cpp_int>(25),cpp_int("15511210043330985984000000"));
+	
+	ASSERT_THROW(binomial(67,33),std::overflow_error);
+	ASSERT_THROW(binomial(100,50),std::overflow_error);
+	ASSERT_EQ(binomial<cpp_int>(100,50),cpp_int("100891344545564193334812497256"));
+	
+	ASSERT_EQ(catalan(35),3116285494907301262LL);
+	ASSERT_THROW(catalan(36),std::overflow_error);
+	ASSERT_THROW(catalan(40),std::overflow_error);
+	ASSERT_EQ(catalan<cpp_int>(40),cpp_int("2622127042276492108820"));
+	for (int n = 0; n < 100; ++n)
+		ASSERT_EQ(catalan<cpp_int>(n),binomial<cpp_int>(2*n,n)/(n+1));
+	
+	ASSERT_EQ(motzkin(39),22944749046030949LL);
+	ASSERT_THROW(motzkin(60),std::overflow_error);
+	ASSERT_EQ(motzkin<cpp_int>(60),cpp_int("128453535912993825479057919"));
+	
+	ASSERT_EQ(partition_number(405),9147679068859117602LL);
+	ASSERT_THROW(partition_number(406),std::overflow_error);
+	ASSERT_EQ(partition_number<cpp_int>(500),cpp_int("2300165032574323995027"));
+	
+	ASSERT_THROW(stirling_partition_number(40,20),std::overflow_error);
+	ASSERT_THROW(stirling_cycle_number(30,10),std::overflow_error);
+	ASSERT_EQ(stirling_partition_number<cpp_int>(40,20),stirling_partition_number<cpp_int>(39,19) + 20*stirling_partition_number<cpp_int>(39,20));
+	
+	// Only the entries that don't fit throw, not the whole row.
+	ASSERT_EQ(stirling_cycle_number(22,21),231);
+	ASSERT_EQ(stirling_cycle_number(30,29),435);
+	ASSERT_THROW(stirling_cycle_number(30,1),std::overflow_error);
+	ASSERT_EQ(stirling_partition_number(40,1),1);
+	ASSERT_EQ(stirling_partition_number(40,39),780);
+	ASSERT_EQ(stirling_partition_number(40,40),1);
+	ASSERT_EQ(partition_number(600,2),300);
+	ASSERT_EQ(partition_number(600,600),1);
+	ASSERT_EQ(partition_number(600,598),2);
+	ASSERT_EQ(cpp_int(partition_number(600,20)),partition_number<cpp_int>(600,20));
+	ASSERT_THROW(partition_number(600,60),std::overflow_error);
+	ASSERT_EQ(binomial<int>(40,2),780);
+	ASSERT_THROW(binomial<int>(40,20),std::overflow_error);
+}
+
+TEST(Sequences,Threads)
+{
+	using boost::multiprecision::cpp_int;
+	
+	// The cached tables are shared: many threads at once must get the same values as one.
+	auto values = [](int t)
+	{
+		std::vector<cpp_int> result;
+		for (int n = t%7; n < 200; n += 7)
+		{
+			result.push_back(cpp_int(partition_number(std::min(n, 405))));
+			result.push_back(cpp_int(partition_number(std::min(n, 300), 5)));
+			result.push_back(cpp_int(catalan(n%36)));
+			result.push_back(cpp_int(binomial(n%67, n%13)));
+			result.push_back(partition_number<cpp_int>(n + 300));
+			result.push_back(motzkin<cpp_int>(n));
+			result.push_back(stirling_partition_number<cpp_int>(n%60, n%11));
+		}
+		return result;
+	};
+	
+	std::vector<std::vector<cpp_int>> results(8);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 8; ++t)
+		threads.emplace_back([&results, &values, t]() { results[t] = values(t); });
+	for (auto& t : threads)
+		t.join();
+	
+	for (int t = 0; t < 8; ++t)
+		ASSERT_EQ(results[t], values(t));
 }
 
 TEST(Sequences,Factorial)
@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include <numeric>
+#include <sstream>
+#include "discreture.hpp"
+#include "Sharding.hpp"
+
+using namespace std;
+using namespace dscr;
+
+// The shards are balanced, in order, and together they are the whole family.
+template <class Container>
+void check_shards(const Container& X)
+{
+	using object = typename Container::value_type;
+	std::vector<object> all(X.begin(), X.end());
+
+	for (long long N : {1LL, 2LL, 3LL, 7LL, X.size() + 5})
+	{
+		std::vector<object> joined;
+		long long smallest = X.size(), largest = 0;
+
+		for (long long i = 0; i < N; ++i)
+		{
+			auto shard = X.shard(i,N);
+			ASSERT_EQ(shard.first_rank(), static_cast<long long>(joined.size()));
+			ASSERT_EQ(shard.size(), std::distance(shard.begin(), shard.end()));
+			smallest = std::min(smallest, shard.size());
+			largest = std::max(largest, shard.size());
+
+			for (auto& x : shard)
+				joined.push_back(x);
+		}
+
+		ASSERT_LE(largest - smallest, 1);
+		ASSERT_EQ(joined, all);
+	}
+}
+
+TEST(Sharding, Shards)
+{
+	check_shards(combinations(11,4));
+	check_shards(combinations_tree(10,3));
+	check_shards(permutations(5));
+	check_shards(multisets({2,0,3,1}));
+	check_shards(combinations(5,0));
+}
+
+TEST(Sharding, ShardBoundsDontOverflow)
+{
+	long long huge = 4000000000000000000LL;
+	auto last = shard_bounds(huge, 6, 7);
+	ASSERT_EQ(last.second, huge);
+	ASSERT_EQ(shard_bounds(huge, 5, 7).second, last.first);
+}
+
+TEST(Sharding, ForkShards)
+{
+	combinations X(20,6);
+	auto count = [](const auto& shard)
+	{
+		long long c = 0;
+		for (auto& x : shard)
+			c += (std::accumulate(x.begin(), x.end(), 0) == 57);
+		return c;
+	};
+
+	long long expected = count(X.shard(0,1));
+	ASSERT_GT(expected, 0);
+
+	auto results = fork_shards(X, 4, [&count](const auto& shard) { return std::to_string(shard.first_rank()) + " " + std::to_string(count(shard)); });
+	ASSERT_EQ(results.size(), 4);
+
+	long long total = 0;
+	for (int i = 0; i < 4; ++i)
+	{
+		std::istringstream ss(results[i]);
+		long long first, c;
+		ss >> first >> c;
+		ASSERT_EQ(first, X.shard(i,4).first_rank());
+		total += c;
+	}
+	ASSERT_EQ(total, expected);
+
+	// Results bigger than a pipe's buffer.
+	permutations Y(8);
+	auto big = fork_shards(Y, 3, [](const auto& shard)
+	{
+		std::string s;
+		for (auto& p : shard)
+			for (auto x : p)
+				s += char('0' + x);
+		return s;
+	});
+	std::string all;
+	for (auto& p : Y)
+		for (auto x : p)
+			all += char('0' + x);
+	ASSERT_EQ(big[0] + big[1] + big[2], all);
+}
+
+TEST(Sharding, FailingWorker)
+{
+	auto work = [](int i) -> std::string
+	{
+		if (i == 2)
+			throw std::runtime_error("shard 2 is cursed");
+		return std::to_string(i);
+	};
+	ASSERT_THROW(fork_workers(4, work), std::runtime_error);
+}
@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include "discreture.hpp"
+
+using namespace std;
+using namespace dscr;
+
+// range(a,b) is exactly the objects of ranks [a,b), both iterating and with for_each.
+template <class Container>
+void check_ranges(const Container& X)
+{
+	using object = typename Container::value_type;
+	std::vector<object> all(X.begin(), X.end());
+	long long n = X.size();
+
+	std::vector<long long> cuts = {0, 1, n/3, n/2, n - 1, n};
+	for (long long a : cuts)
+	{
+		for (long long b : cuts)
+		{
+			if (a < 0 || b > n || a > b)
+				continue;
+
+			auto R = X.range(a,b);
+			ASSERT_EQ(R.size(), b - a);
+			ASSERT_EQ(R.first_rank(), a);
+			ASSERT_EQ(R.last_rank(), b);
+			ASSERT_EQ(R.empty(), a == b);
+
+			std::vector<object> iterated(R.begin(), R.end());
+			ASSERT_TRUE(std::equal(iterated.begin(), iterated.end(), all.begin() + a, all.begin() + b));
+			ASSERT_EQ(iterated.size(), b - a);
+
+			std::vector<object> visited;
+			R.for_each([&visited](const object& x) { visited.push_back(x); });
+			ASSERT_EQ(visited, iterated);
+		}
+	}
+}
+
+TEST(Subrange, EveryFamily)
+{
+	check_ranges(combinations(11,4));
+	check_ranges(combinations_fast(9,3));
+	check_ranges(combinations_tree(10,3));
+	check_ranges(permutations(5));
+	check_ranges(multisets({2,0,3,1}));
+	check_ranges(multisets_gray({2,1,3}));
+	check_ranges(partitions(13));
+	check_ranges(partitions(15,3,6));
+	check_ranges(set_partitions(6));
+	check_ranges(set_partitions(7,2,4));
+	check_ranges(dyck_paths(5));
+	check_ranges(motzkin_paths(7));
+}
+
+TEST(Subrange, DyckPathsPacked)
+{
+	dyck_paths_packed X(6);
+	std::vector<dyck_paths_packed::dyck_path> all(X.begin(), X.end());
+	auto R = X.range(40, 90);
+	ASSERT_EQ(R.size(), 50);
+	long long i = 40;
+	R.for_each([&](auto x) { ASSERT_EQ(x, all[i]); ++i; });
+	ASSERT_EQ(i, 90);
+}
+
+TEST(Subrange, SkipTo)
+{
+	partitions P(20);
+	long long i = 0;
+	for (auto it = P.begin(); it != P.end(); ++it, ++i)
+	{
+		if (i%17 != 0)
+			continue;
+		auto jt = P.skip_to(i);
+		ASSERT_EQ(jt.ID(), i);
+		ASSERT_EQ(*jt, *it);
+	}
+	ASSERT_EQ(P.skip_to(P.size()), P.end());
+
+	set_partitions S(8);
+	i = 0;
+	for (auto it = S.begin(); it != S.end(); ++it, ++i)
+	{
+		if (i%13 != 0)
+			continue;
+		auto jt = S.skip_to(i);
+		ASSERT_EQ(jt.ID(), i);
+		ASSERT_EQ(*jt, *it);
+	}
+}
+
+TEST(Subrange, FewParts)
+{
+	// Most of the counts for these n overflow, but not the ones with few (or many) parts.
+	partitions P(600,1,2);
+	ASSERT_EQ(P.size(), 301);
+	check_ranges(P);
+	std::vector<partitions::partition> all(P.begin(), P.end());
+	for (long long i : {0, 1, 150, 300})
+		ASSERT_EQ(*P.skip_to(i), all[i]);
+
+	set_partitions S(40,39,40);
+	ASSERT_EQ(S.size(), 781);
+	check_ranges(S);
+}
+
+TEST(Subrange, NumWithShape)
+{
+	// The shapes of the set partitions of n add up to the Bell number.
+	for (int n = 1; n < 12; ++n)
+	{
+		long long total = 0;
+		for (auto& shape : partitions(n))
+			total += set_partitions::num_with_shape(set_partitions::number_partition(shape.begin(), shape.end()));
+		ASSERT_EQ(total, set_partitions(n).size());
+	}
+	ASSERT_EQ(set_partitions::num_with_shape({2,2,1}), 15);
+	ASSERT_EQ(set_partitions::num_with_shape({3,1}), 4);
+	ASSERT_EQ(set_partitions::num_with_shape(std::vector<int>(40, 1)), 1);
+	ASSERT_EQ(set_partitions::num_with_shape({20,20,20}), std::numeric_limits<long long>::max());
+}
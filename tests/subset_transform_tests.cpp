@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include <random>
+#include "discreture.hpp"
+
+using namespace std;
+using namespace dscr;
+
+// a[x] = sum of a[y] over all y <= x (or all y >= x), the slow way.
+static vector<long long> naive_zeta(const multisets& X, const vector<long long>& a, bool up)
+{
+	vector<long long> result(a.size(), 0);
+	for (auto& x : X)
+	{
+		for (auto& y : X)
+		{
+			bool below = true;
+			for (size_t i = 0; i < x.size(); ++i)
+				below = below && (up ? x[i] <= y[i] : y[i] <= x[i]);
+			if (below)
+				result[X.get_index(x)] += a[X.get_index(y)];
+		}
+	}
+	return result;
+}
+
+static vector<long long> random_values(size_t n)
+{
+	std::mt19937 gen(n);
+	std::uniform_int_distribution<long long> dist(-1000, 1000);
+	vector<long long> a(n);
+	for (auto& v : a)
+		v = dist(gen);
+	return a;
+}
+
+TEST(SubsetTransforms, Multisets)
+{
+	for (multisets::multiset total : {multisets::multiset{2,0,3,1,2}, multisets::multiset{1,4}, multisets::multiset{}, multisets::multiset{5}})
+	{
+		multisets X(total);
+		auto a = random_values(X.size());
+
+		for (size_t threads : {1, 3})
+		{
+			auto b = a;
+			zeta_transform(X, b, threads);
+			ASSERT_EQ(b, naive_zeta(X, a, false));
+			mobius_transform(X, b, threads);
+			ASSERT_EQ(b, a);
+
+			superset_zeta_transform(X, b, threads);
+			ASSERT_EQ(b, naive_zeta(X, a, true));
+			superset_mobius_transform(X, b, threads);
+			ASSERT_EQ(b, a);
+		}
+	}
+
+	multisets X(multisets::multiset{1,2});
+	vector<long long> wrong(5);
+	ASSERT_THROW(zeta_transform(X, wrong), std::invalid_argument);
+}
+
+TEST(SubsetTransforms, BiggerThanABlock)
+{
+	// Big enough that the last coordinates are done in separate passes.
+	multisets X(multisets::multiset{3,3,3,3,3,3,2});
+	auto a = random_values(X.size());
+
+	auto expected = a;
+	for (auto& x : X)
+	{
+		long long sum = 0;
+		for (auto& y : multisets(x))
+			sum += a[X.get_index(y)];
+		expected[X.get_index(x)] = sum;
+	}
+
+	for (size_t threads : {1, 2, 5})
+	{
+		auto b = a;
+		zeta_transform(X, b, threads);
+		ASSERT_EQ(b, expected);
+		mobius_transform(X, b, threads);
+		ASSERT_EQ(b, a);
+	}
+}
+
+TEST(SubsetTransforms, PowerSet)
+{
+	for (int n : {0, 1, 2, 3, 5, 14})
+	{
+		size_t size = 1 << n;
+		auto a = random_values(size);
+
+		vector<long long> subsets(size, 0);
+		vector<long long> supersets(size, 0);
+		for (size_t S = 0; S < size; ++S)
+		{
+			// every submask R of S
+			for (size_t R = S; ; R = (R - 1) & S)
+			{
+				subsets[S] += a[R];
+				supersets[R] += a[S];
+				if (R == 0)
+					break;
+			}
+		}
+
+		for (size_t threads : {1, 4})
+		{
+			auto b = a;
+			power_set_zeta_transform(b, threads);
+			ASSERT_EQ(b, subsets);
+			power_set_mobius_transform(b, threads);
+			ASSERT_EQ(b, a);
+
+			power_set_superset_zeta_transform(b, threads);
+			ASSERT_EQ(b, supersets);
+			power_set_superset_mobius_transform(b, threads);
+			ASSERT_EQ(b, a);
+		}
+
+		// multisets(n) is the power set, in the same order
+		auto c = a;
+		zeta_transform(multisets(n), c);
+		ASSERT_EQ(c, subsets);
+	}
+
+	vector<double> wrong(6);
+	ASSERT_THROW(power_set_zeta_transform(wrong), std::invalid_argument);
+}
+
+TEST(SubsetTransforms, MultisetMap)
+{
+	// The zeta transform of all ones counts the submultisets of each x.
+	multiset_map<long long> M(multisets::multiset{3,1,2});
+	M.for_each([](const auto&, long long& v) { v = 1; });
+	zeta_transform(M);
+	for (auto& x : M.family())
+	{
+		long long size = 1;
+		for (auto t : x)
+			size *= t + 1;
+		ASSERT_EQ(M[x], size);
+	}
+
+	mobius_transform(M);
+	M.for_each([](const auto&, long long v) { ASSERT_EQ(v, 1); });
+}